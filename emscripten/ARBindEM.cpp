@@ -7,36 +7,63 @@ EMSCRIPTEN_BINDINGS(constant_bindings) {
     register_vector<int>("IntList");
 
 	function("setup", &setup);
+	function("setupWithMemoryPlan", &setupWithMemoryPlan);
 	function("teardown", &teardown);
+	function("resizeController", &resizeController);
 
-	function("setupAR2", &setupAR2);
+	function("_loadCamera", &loadCamera);
+	function("clearParamLTCache", &clearParamLTCache);
+	function("clearControllerPool", &clearControllerPool);
+
+	function("setLogLevel", &setLogLevel);
+	function("getLogLevel", &getLogLevel);
+
+	function("setTraceEnabled", &setTraceEnabled);
+	function("getTraceEnabled", &getTraceEnabled);
+	function("clearTrace", &clearTrace);
+	function("getTrace", &getTrace);
 
+	function("getFrameStats", &getFrameStats);
+	function("resetTracking", &resetTracking);
+
+#ifdef HAVE_NFT
+	function("setupAR2", &setupAR2);
+	function("_addNFTMarkers", &addNFTMarkers);
+	function("detectNFTMarker", &detectNFTMarker);
+	function("getNFTMarker", &getNFTMarkerInfo);
+	function("getNFTTrackingInfo", &getNFTTrackingInfo);
+	function("setNFTSearchFeatureNum", &setNFTSearchFeatureNum);
+	function("getNFTSearchFeatureNum", &getNFTSearchFeatureNum);
+#endif
+
+// The NFT module (artoolkit_nft.js) is loaded by the square marker build on the first loadNFTMarker()
+// and only needs the functions above.
+#ifndef ARTOOLKIT_NFT_MODULE
 	function("_addMarker", &addMarker);
 	function("_addMultiMarker", &addMultiMarker);
-	function("_addNFTMarkers", &addNFTMarkers);
 
 	function("getMultiMarkerNum", &getMultiMarkerNum);
 	function("getMultiMarkerCount", &getMultiMarkerCount);
 
-	function("_loadCamera", &loadCamera);
-
 	function("setMarkerInfoDir", &setMarkerInfoDir);
 	function("setMarkerInfoVertex", &setMarkerInfoVertex);
 
 	function("getTransMatSquare", &getTransMatSquare);
 	function("getTransMatSquareCont", &getTransMatSquareCont);
+	function("setSquareMarkerWidth", &setSquareMarkerWidth);
+	function("getTransMatSquareBatch", &getTransMatSquareBatch);
+	function("setPoseFilter", &setPoseFilter);
+	function("getPoseFilterCutoff", &getPoseFilterCutoff);
 
 	function("getTransMatMultiSquare", &getTransMatMultiSquare);
 	function("getTransMatMultiSquareRobust", &getTransMatMultiSquareRobust);
+	function("getTransMatMultiSquareBatch", &getTransMatMultiSquareBatch);
 
 	function("detectMarker", &detectMarker);
 	function("getMarkerNum", &getMarkerNum);
 
-	function("detectNFTMarker", &detectNFTMarker);
-
 	function("getMultiEachMarker", &getMultiEachMarkerInfo);
 	function("getMarker", &getMarkerInfo);
-	function("getNFTMarker", &getNFTMarkerInfo);
 
 
 	/* AR Toolkit C APIS */
@@ -45,9 +72,6 @@ EMSCRIPTEN_BINDINGS(constant_bindings) {
 
 	function("getProcessingImage", &getProcessingImage);
 
-	function("setLogLevel", &setLogLevel);
-	function("getLogLevel", &getLogLevel);
-
 	function("setProjectionNearPlane", &setProjectionNearPlane);
 	function("getProjectionNearPlane", &getProjectionNearPlane);
 
@@ -75,6 +99,21 @@ EMSCRIPTEN_BINDINGS(constant_bindings) {
 	function("setImageProcMode", &setImageProcMode);
 	function("getImageProcMode", &getImageProcMode);
 
+	function("setROIFullScanInterval", &setROIFullScanInterval);
+	function("getROIFullScanInterval", &getROIFullScanInterval);
+	function("setCoarseDetectionFactor", &setCoarseDetectionFactor);
+	function("getCoarseDetectionFactor", &getCoarseDetectionFactor);
+	function("setLabelingThreadNum", &setLabelingThreadNum);
+	function("getLabelingThreadNum", &getLabelingThreadNum);
+	function("setFastAdaptiveThresholdEnabled", &setFastAdaptiveThresholdEnabled);
+	function("getFastAdaptiveThresholdEnabled", &getFastAdaptiveThresholdEnabled);
+	function("setPatternIndexEnabled", &setPatternIndexEnabled);
+	function("getPatternIndexEnabled", &getPatternIndexEnabled);
+	function("setCornerTrackingInterval", &setCornerTrackingInterval);
+	function("getCornerTrackingInterval", &getCornerTrackingInterval);
+	function("setThresholdEstimation", &setThresholdEstimation);
+#endif
+
 
 	/* errors */
 	constant("ERROR_ARCONTROLLER_NOT_FOUND", ARCONTROLLER_NOT_FOUND);
@@ -0,0 +1,134 @@
+/*
+ * Tracking of the corners of square markers, see ARCornerTrack.h.
+ *
+ * The flow d of a point minimizes sum((I(x) - J(x + d))^2) over the window, with I the previous luma and J the
+ * current one. Each step solves G * step = sum((I(x) - J(x + d)) * grad I(x)) with G = sum(grad I * grad I^T),
+ * which depends only on the previous luma and is computed once per level. The flow found at a level, doubled,
+ * is the guess of the next one.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "ARCornerTrack.h"
+
+#define WIN_SIZE        (2 * AR_CORNER_TRACK_WIN_HALF + 1)
+#define ITERATIONS_MAX  10
+#define STEP_MIN        0.03f   // Step (pixels) below which the iterations stop.
+#define EIGEN_MIN       8.0f    // Smallest eigenvalue of G per window pixel, below it the window has no corner.
+
+int arCornerTrackPyramidSize( int xsize, int ysize )
+{
+    int size = 0, l;
+    for( l = 0; l < AR_CORNER_TRACK_LEVELS; l++ ) size += (xsize >> l) * (ysize >> l);
+    return size;
+}
+
+static const ARUint8 *level( const ARUint8 *pyramid, int xsize, int ysize, int l, int *w, int *h )
+{
+    int i;
+    for( i = 0; i < l; i++ ) pyramid += (xsize >> i) * (ysize >> i);
+    *w = xsize >> l;
+    *h = ysize >> l;
+    return pyramid;
+}
+
+void arCornerTrackPyramid( const ARUint8 *luma, int xsize, int ysize, ARUint8 *pyramid )
+{
+    int l, x, y;
+
+    memcpy( pyramid, luma, xsize * ysize );
+    for( l = 1; l < AR_CORNER_TRACK_LEVELS; l++ ) {
+        int             w, h, sw, sh;
+        const ARUint8  *src = level( pyramid, xsize, ysize, l - 1, &sw, &sh );
+        ARUint8        *dst = (ARUint8 *)level( pyramid, xsize, ysize, l, &w, &h );
+        for( y = 0; y < h; y++ ) {
+            const ARUint8 *s0 = src + 2 * y * sw, *s1 = s0 + sw;
+            for( x = 0; x < w; x++ ) {
+                dst[y * w + x] = (ARUint8)((s0[2 * x] + s0[2 * x + 1] + s1[2 * x] + s1[2 * x + 1] + 2) >> 2);
+            }
+        }
+    }
+}
+
+// Bilinear interpolation, x in [0, w - 1) and y in [0, h - 1).
+static float sample( const ARUint8 *img, int w, float x, float y )
+{
+    int             ix = (int)x, iy = (int)y;
+    float           fx = x - ix, fy = y - iy;
+    const ARUint8  *p = img + iy * w + ix;
+    return (1.0f - fy) * ((1.0f - fx) * p[0] + fx * p[1]) + fy * ((1.0f - fx) * p[w] + fx * p[w + 1]);
+}
+
+// The window around (x, y), one more pixel for the gradients, is inside the image.
+static int inside( float x, float y, int w, int h )
+{
+    return x - AR_CORNER_TRACK_WIN_HALF - 1 >= 0.0f && x + AR_CORNER_TRACK_WIN_HALF + 1 < w - 1
+        && y - AR_CORNER_TRACK_WIN_HALF - 1 >= 0.0f && y + AR_CORNER_TRACK_WIN_HALF + 1 < h - 1;
+}
+
+int arCornerTrack( const ARUint8 *prevPyramid, const ARUint8 *pyramid, int xsize, int ysize, const float prev[2], float cur[2] )
+{
+    float   iv[WIN_SIZE * WIN_SIZE], ix[WIN_SIZE * WIN_SIZE], iy[WIN_SIZE * WIN_SIZE];
+    float   scale = (float)(1 << (AR_CORNER_TRACK_LEVELS - 1));
+    float   gx = (cur[0] - prev[0]) / scale, gy = (cur[1] - prev[1]) / scale;
+    int     l, i, dx, dy, it;
+
+    for( l = AR_CORNER_TRACK_LEVELS - 1; l >= 0; l-- ) {
+        int             w, h;
+        const ARUint8  *img = level( prevPyramid, xsize, ysize, l, &w, &h );
+        const ARUint8  *next = level( pyramid, xsize, ysize, l, &w, &h );
+        float           s = (float)(1 << l);
+        float           px = (prev[0] + 0.5f) / s - 0.5f, py = (prev[1] + 0.5f) / s - 0.5f;
+        float           gxx = 0.0f, gxy = 0.0f, gyy = 0.0f, det, minEig, vx = 0.0f, vy = 0.0f;
+
+        if( !inside( px, py, w, h ) ) return -1;
+        for( i = 0, dy = -AR_CORNER_TRACK_WIN_HALF; dy <= AR_CORNER_TRACK_WIN_HALF; dy++ ) {
+            for( dx = -AR_CORNER_TRACK_WIN_HALF; dx <= AR_CORNER_TRACK_WIN_HALF; dx++, i++ ) {
+                float x = px + dx, y = py + dy;
+                iv[i] = sample( img, w, x, y );
+                ix[i] = 0.5f * (sample( img, w, x + 1.0f, y ) - sample( img, w, x - 1.0f, y ));
+                iy[i] = 0.5f * (sample( img, w, x, y + 1.0f ) - sample( img, w, x, y - 1.0f ));
+                gxx += ix[i] * ix[i];
+                gxy += ix[i] * iy[i];
+                gyy += iy[i] * iy[i];
+            }
+        }
+        det = gxx * gyy - gxy * gxy;
+        minEig = 0.5f * (gxx + gyy - sqrtf( (gxx - gyy) * (gxx - gyy) + 4.0f * gxy * gxy ));
+        if( minEig < EIGEN_MIN * WIN_SIZE * WIN_SIZE || det <= 0.0f ) return -1;
+
+        for( it = 0; it < ITERATIONS_MAX; it++ ) {
+            float qx = px + gx + vx, qy = py + gy + vy, bx = 0.0f, by = 0.0f, ex, ey;
+            if( !inside( qx, qy, w, h ) ) return -1;
+            for( i = 0, dy = -AR_CORNER_TRACK_WIN_HALF; dy <= AR_CORNER_TRACK_WIN_HALF; dy++ ) {
+                for( dx = -AR_CORNER_TRACK_WIN_HALF; dx <= AR_CORNER_TRACK_WIN_HALF; dx++, i++ ) {
+                    float diff = iv[i] - sample( next, w, qx + dx, qy + dy );
+                    bx += diff * ix[i];
+                    by += diff * iy[i];
+                }
+            }
+            ex = (gyy * bx - gxy * by) / det;
+            ey = (gxx * by - gxy * bx) / det;
+            vx += ex;
+            vy += ey;
+            if( ex * ex + ey * ey < STEP_MIN * STEP_MIN ) break;
+        }
+
+        if( l > 0 ) {
+            gx = 2.0f * (gx + vx);
+            gy = 2.0f * (gy + vy);
+        } else {
+            float qx = px + gx + vx, qy = py + gy + vy, residual = 0.0f;
+            if( !inside( qx, qy, w, h ) ) return -1;
+            for( i = 0, dy = -AR_CORNER_TRACK_WIN_HALF; dy <= AR_CORNER_TRACK_WIN_HALF; dy++ ) {
+                for( dx = -AR_CORNER_TRACK_WIN_HALF; dx <= AR_CORNER_TRACK_WIN_HALF; dx++, i++ ) {
+                    residual += fabsf( iv[i] - sample( next, w, qx + dx, qy + dy ) );
+                }
+            }
+            if( residual / (WIN_SIZE * WIN_SIZE) > AR_CORNER_TRACK_RESIDUAL_MAX ) return -1;
+            cur[0] = prev[0] + gx + vx;
+            cur[1] = prev[1] + gy + vy;
+        }
+    }
+    return 0;
+}
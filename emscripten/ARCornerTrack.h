@@ -0,0 +1,39 @@
+/*
+ * Tracking of the corners of square markers from frame to frame, to skip their detection.
+ *
+ * The corners are followed with the pyramidal Lucas-Kanade optical flow: a window around the corner in the previous
+ * luma is matched in the current one by Gauss-Newton steps on the image gradients, from the coarsest level of the
+ * pyramid (for the large motions) to the full resolution (for the accuracy). The corner of a marker, with the dark
+ * border on two sides, is the kind of window this is well conditioned for.
+ */
+
+#ifndef AR_CORNER_TRACK_H
+#define AR_CORNER_TRACK_H
+
+#include <AR/ar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AR_CORNER_TRACK_LEVELS        3    // Levels of the pyramid, each half the size of the one below.
+#define AR_CORNER_TRACK_WIN_HALF      7    // The window is 2 * AR_CORNER_TRACK_WIN_HALF + 1 pixels wide.
+#define AR_CORNER_TRACK_RESIDUAL_MAX  24.0 // Mean absolute difference of the windows above which a corner is lost.
+
+// Bytes of the pyramid of a xsize x ysize luma.
+int arCornerTrackPyramidSize(int xsize, int ysize);
+
+// Copies luma to the first level of pyramid and downscales it by 2 into each next level.
+void arCornerTrackPyramid(const ARUint8 *luma, int xsize, int ysize, ARUint8 *pyramid);
+
+/*
+ * Finds in pyramid the point at prev[] in prevPyramid (observed coordinates), from the guess in cur[], into cur[].
+ * Returns -1 if the point is lost: too close to the border, in a window without corner, or matched by a window too
+ * different from its own.
+ */
+int arCornerTrack(const ARUint8 *prevPyramid, const ARUint8 *pyramid, int xsize, int ysize, const float prev[2], float cur[2]);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // AR_CORNER_TRACK_H
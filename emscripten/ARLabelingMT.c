@@ -0,0 +1,322 @@
+/*
+ *  ARLabelingMT.c multithreaded version of arLabeling()
+ *  from AR/arLabeling.c and AR/arLabelingSub
+ *  ARToolKit5
+ *
+ *  The rows are cut into horizontal strips, each labeled by a thread with the algorithm of arLabelingSubEBR().
+ *  A strip takes its provisional labels from its own range of labelInfo->work, so the label image is never
+ *  renumbered: the labels of the first row of each strip are joined with those of the last row of the previous
+ *  strip, then the label classes are numbered in the order of their first provisional label, which like in
+ *  arLabeling() is the raster order of their first pixel.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define AR_LABELING_MT_PTHREADS
+#include <pthread.h>
+#endif
+#include "ARLabelingMT.h"
+#include "ARTrace.h"
+
+typedef struct {
+    ARUint8      *image;
+    int           xsize;
+    int           y0, y1;       // Rows labeled, y0 to y1 - 1.
+    int           labelingMode;
+    int           labelingThresh;
+    ARLabelInfo  *labelInfo;
+    int           base;         // Labels base + 1 to base + capacity.
+    int           capacity;
+    int           num;          // Labels used, -1 if more were needed.
+} ARLabelingStripT;
+
+static void *labelStrip( void *arg )
+{
+    ARLabelingStripT        *strip = (ARLabelingStripT *)arg;
+    int                      xsize = strip->xsize;
+    int                     *work = strip->labelInfo->work;
+    int                     *work2 = strip->labelInfo->work2;
+    int                      wk_max = strip->base;
+    int                      i, j, k, m, n;
+
+    AR_TRACE_BEGIN("arLabelingStrip");
+    for( j = strip->y0; j < strip->y1; j++ ) {
+        ARUint8                 *pnt = &(strip->image[j*xsize+1]);
+        AR_LABELING_LABEL_TYPE  *pnt2 = &(strip->labelInfo->labelImage[j*xsize+1]);
+        // The row above the strip belongs to the previous one, it is joined in arLabelingMT().
+        AR_LABELING_LABEL_TYPE  *pnt1 = (j == strip->y0) ? NULL : pnt2 - xsize;
+
+        pnt2[-1] = pnt2[xsize-2] = 0;
+        for( i = 1; i < xsize-1; i++, pnt++, pnt2++ ) {
+            int  up = 0, upLeft = 0, upRight = 0, *wk;
+
+            if( strip->labelingMode == AR_LABELING_BLACK_REGION ? *pnt > strip->labelingThresh : *pnt <= strip->labelingThresh ) {
+                *pnt2 = 0;
+                continue;
+            }
+            if( pnt1 ) {
+                up = pnt1[i-1];
+                upLeft = pnt1[i-2];
+                upRight = pnt1[i];
+            }
+            if( up > 0 ) {
+                *pnt2 = up;
+                wk = &(work2[(up-1)*7]);
+                wk[0]++; wk[1] += i; wk[2] += j; wk[6] = j;
+            }
+            else if( upRight > 0 ) {
+                if( upLeft > 0 || *(pnt2-1) > 0 ) {
+                    m = work[upRight-1];
+                    n = work[(upLeft > 0 ? upLeft : *(pnt2-1))-1];
+                    if( m > n ) {
+                        *pnt2 = n;
+                        for( k = strip->base; k < wk_max; k++ ) if( work[k] == m ) work[k] = n;
+                    }
+                    else if( m < n ) {
+                        *pnt2 = m;
+                        for( k = strip->base; k < wk_max; k++ ) if( work[k] == n ) work[k] = m;
+                    }
+                    else *pnt2 = m;
+                    wk = &(work2[((*pnt2)-1)*7]);
+                    wk[0]++; wk[1] += i; wk[2] += j; wk[6] = j;
+                }
+                else {
+                    *pnt2 = upRight;
+                    wk = &(work2[(upRight-1)*7]);
+                    wk[0]++; wk[1] += i; wk[2] += j;
+                    if( wk[3] > i ) wk[3] = i;
+                    wk[6] = j;
+                }
+            }
+            else if( upLeft > 0 ) {
+                *pnt2 = upLeft;
+                wk = &(work2[(upLeft-1)*7]);
+                wk[0]++; wk[1] += i; wk[2] += j;
+                if( wk[4] < i ) wk[4] = i;
+                wk[6] = j;
+            }
+            else if( *(pnt2-1) > 0 ) {
+                *pnt2 = *(pnt2-1);
+                wk = &(work2[((*pnt2)-1)*7]);
+                wk[0]++; wk[1] += i; wk[2] += j;
+                if( wk[4] < i ) wk[4] = i;
+            }
+            else {
+                if( wk_max - strip->base >= strip->capacity ) {
+                    strip->num = -1;
+                    AR_TRACE_END("arLabelingStrip");
+                    return NULL;
+                }
+                wk_max++;
+                work[wk_max-1] = *pnt2 = wk_max;
+                wk = &(work2[(wk_max-1)*7]);
+                wk[0] = 1; wk[1] = i; wk[2] = j; wk[3] = i; wk[4] = i; wk[5] = j; wk[6] = j;
+            }
+        }
+    }
+    strip->num = wk_max - strip->base;
+    AR_TRACE_END("arLabelingStrip");
+    return NULL;
+}
+
+struct _ARLabelingMTHandle {
+    int                threadNum;
+#ifdef AR_LABELING_MT_PTHREADS
+    pthread_t          workers[AR_LABELING_MT_THREAD_MAX];
+    int                workerNum;   // Workers started.
+    pthread_mutex_t    mutex;
+    pthread_cond_t     startCond;   // Strips posted or quit.
+    pthread_cond_t     doneCond;    // All strips labeled.
+    ARLabelingStripT  *strips;
+    int                stripNum;
+    int                next;        // Next strip to take.
+    int                pending;     // Strips not labeled yet.
+    int                quit;
+#endif
+};
+
+#ifdef AR_LABELING_MT_PTHREADS
+// Takes the strips posted by arLabelingMT() until there are none left, returns 1 if a strip was labeled.
+static int labelPostedStrips( ARLabelingMTHandle *handle )
+{
+    int  labeled = 0;
+
+    while( handle->next < handle->stripNum ) {
+        ARLabelingStripT *strip = &(handle->strips[handle->next++]);
+        pthread_mutex_unlock( &(handle->mutex) );
+        labelStrip( strip );
+        pthread_mutex_lock( &(handle->mutex) );
+        if( --handle->pending == 0 ) pthread_cond_signal( &(handle->doneCond) );
+        labeled = 1;
+    }
+    return labeled;
+}
+
+static void *labelingWorker( void *arg )
+{
+    ARLabelingMTHandle *handle = (ARLabelingMTHandle *)arg;
+
+    pthread_mutex_lock( &(handle->mutex) );
+    while( !handle->quit ) {
+        if( !labelPostedStrips( handle ) ) pthread_cond_wait( &(handle->startCond), &(handle->mutex) );
+    }
+    pthread_mutex_unlock( &(handle->mutex) );
+    return NULL;
+}
+#endif
+
+ARLabelingMTHandle *arLabelingMTCreateHandle( int threadNum )
+{
+    ARLabelingMTHandle *handle;
+
+    if( threadNum < 1 || threadNum > AR_LABELING_MT_THREAD_MAX ) return NULL;
+    if( (handle = (ARLabelingMTHandle *)calloc( 1, sizeof(ARLabelingMTHandle) )) == NULL ) return NULL;
+    handle->threadNum = threadNum;
+#ifdef AR_LABELING_MT_PTHREADS
+    pthread_mutex_init( &(handle->mutex), NULL );
+    pthread_cond_init( &(handle->startCond), NULL );
+    pthread_cond_init( &(handle->doneCond), NULL );
+    // A worker that can't be started leaves its strips to the others and the calling thread.
+    while( handle->workerNum < threadNum - 1 ) {
+        if( pthread_create( &(handle->workers[handle->workerNum]), NULL, labelingWorker, handle ) != 0 ) break;
+        handle->workerNum++;
+    }
+#endif
+    return handle;
+}
+
+int arLabelingMTDeleteHandle( ARLabelingMTHandle **handle )
+{
+#ifdef AR_LABELING_MT_PTHREADS
+    int  i;
+#endif
+
+    if( handle == NULL || *handle == NULL ) return -1;
+#ifdef AR_LABELING_MT_PTHREADS
+    pthread_mutex_lock( &((*handle)->mutex) );
+    (*handle)->quit = 1;
+    pthread_cond_broadcast( &((*handle)->startCond) );
+    pthread_mutex_unlock( &((*handle)->mutex) );
+    for( i = 0; i < (*handle)->workerNum; i++ ) pthread_join( (*handle)->workers[i], NULL );
+    pthread_cond_destroy( &((*handle)->doneCond) );
+    pthread_cond_destroy( &((*handle)->startCond) );
+    pthread_mutex_destroy( &((*handle)->mutex) );
+#endif
+    free( *handle );
+    *handle = NULL;
+    return 0;
+}
+
+static int findLabel( const int *work, int label )
+{
+    while( work[label-1] != label ) label = work[label-1];
+    return label;
+}
+
+int arLabelingMT( ARUint8 *image, int xsize, int ysize, int debugMode, int labelingMode, int labelingThresh,
+                  int imageProcMode, ARLabelInfo *labelInfo, ARUint8 *image_thresh, ARLabelingMTHandle *handle )
+{
+    ARLabelingStripT         strips[AR_LABELING_MT_THREAD_MAX];
+    AR_LABELING_LABEL_TYPE  *labelImage = labelInfo->labelImage;
+    int                     *work = labelInfo->work;
+    int                      stripNum, s, i, j, k, label_num;
+
+    stripNum = (ysize - 2) / AR_LABELING_MT_STRIP_MIN;
+    if( handle == NULL ) stripNum = 1;
+    else if( stripNum > handle->threadNum ) stripNum = handle->threadNum;
+    if( stripNum <= 1 || debugMode != AR_DEBUG_DISABLE || imageProcMode != AR_IMAGE_PROC_FRAME_IMAGE || image_thresh ) {
+        return arLabeling( image, xsize, ysize, debugMode, labelingMode, labelingThresh, imageProcMode, labelInfo, image_thresh );
+    }
+
+    memset( labelImage, 0, xsize * sizeof(AR_LABELING_LABEL_TYPE) );
+    memset( &(labelImage[(ysize-1)*xsize]), 0, xsize * sizeof(AR_LABELING_LABEL_TYPE) );
+    for( s = 0; s < stripNum; s++ ) {
+        strips[s].image = image;
+        strips[s].xsize = xsize;
+        strips[s].y0 = 1 + (ysize - 2) * s / stripNum;
+        strips[s].y1 = 1 + (ysize - 2) * (s + 1) / stripNum;
+        strips[s].labelingMode = labelingMode;
+        strips[s].labelingThresh = labelingThresh;
+        strips[s].labelInfo = labelInfo;
+        strips[s].base = AR_LABELING_WORK_SIZE / stripNum * s;
+        strips[s].capacity = AR_LABELING_WORK_SIZE / stripNum;
+        strips[s].num = 0;
+    }
+#ifdef AR_LABELING_MT_PTHREADS
+    // The calling thread takes strips like the workers, then waits for those they took.
+    pthread_mutex_lock( &(handle->mutex) );
+    handle->strips = strips;
+    handle->stripNum = stripNum;
+    handle->next = 0;
+    handle->pending = stripNum;
+    pthread_cond_broadcast( &(handle->startCond) );
+    labelPostedStrips( handle );
+    while( handle->pending > 0 ) pthread_cond_wait( &(handle->doneCond), &(handle->mutex) );
+    handle->strips = NULL;
+    handle->stripNum = 0;
+    pthread_mutex_unlock( &(handle->mutex) );
+#else
+    for( s = 0; s < stripNum; s++ ) labelStrip( &strips[s] );
+#endif
+    for( s = 0; s < stripNum; s++ ) {
+        if( strips[s].num < 0 ) {
+            return arLabeling( image, xsize, ysize, debugMode, labelingMode, labelingThresh, imageProcMode, labelInfo, image_thresh );
+        }
+    }
+
+    // Joins the label classes across the strip boundaries, each class pointing to its smallest label.
+    for( s = 1; s < stripNum; s++ ) {
+        AR_LABELING_LABEL_TYPE  *pnt2 = &(labelImage[strips[s].y0*xsize]);
+        AR_LABELING_LABEL_TYPE  *pnt1 = pnt2 - xsize;
+        for( i = 1; i < xsize-1; i++ ) {
+            if( pnt2[i] <= 0 ) continue;
+            for( k = i-1; k <= i+1; k++ ) {
+                int  a, b;
+                if( pnt1[k] <= 0 ) continue;
+                a = findLabel( work, pnt2[i] );
+                b = findLabel( work, pnt1[k] );
+                if( a > b ) work[a-1] = b;
+                else if( a < b ) work[b-1] = a;
+            }
+        }
+    }
+
+    // Same numbering as arLabeling(): the labels are visited in the order they were created in.
+    j = 1;
+    for( s = 0; s < stripNum; s++ ) {
+        for( i = strips[s].base + 1; i <= strips[s].base + strips[s].num; i++ ) {
+            work[i-1] = (work[i-1] == i) ? j++ : work[work[i-1]-1];
+        }
+    }
+    labelInfo->label_num = label_num = j - 1;
+    if( label_num == 0 ) return 0;
+
+    memset( labelInfo->area, 0, label_num * sizeof(int) );
+    memset( labelInfo->pos, 0, label_num * 2 * sizeof(ARdouble) );
+    for( i = 0; i < label_num; i++ ) {
+        labelInfo->clip[i][0] = xsize;
+        labelInfo->clip[i][1] = 0;
+        labelInfo->clip[i][2] = ysize;
+        labelInfo->clip[i][3] = 0;
+    }
+    for( s = 0; s < stripNum; s++ ) {
+        for( i = strips[s].base; i < strips[s].base + strips[s].num; i++ ) {
+            int  *wk = &(labelInfo->work2[i*7]);
+            j = work[i] - 1;
+            labelInfo->area[j]   += wk[0];
+            labelInfo->pos[j][0] += wk[1];
+            labelInfo->pos[j][1] += wk[2];
+            if( labelInfo->clip[j][0] > wk[3] ) labelInfo->clip[j][0] = wk[3];
+            if( labelInfo->clip[j][1] < wk[4] ) labelInfo->clip[j][1] = wk[4];
+            if( labelInfo->clip[j][2] > wk[5] ) labelInfo->clip[j][2] = wk[5];
+            if( labelInfo->clip[j][3] < wk[6] ) labelInfo->clip[j][3] = wk[6];
+        }
+    }
+    for( i = 0; i < label_num; i++ ) {
+        labelInfo->pos[i][0] /= labelInfo->area[i];
+        labelInfo->pos[i][1] /= labelInfo->area[i];
+    }
+    return label_num;
+}
@@ -0,0 +1,66 @@
+/*
+ *  ARLabelingMT.h multithreaded version of arLabeling()
+ *  from AR/arLabeling.c
+ *  ARToolKit5
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2015 Daqri, LLC.
+ *  Copyright 2002-2015 ARToolworks, Inc.
+ *
+ *  Author(s): Hirokazu Kato, Philip Lamb
+ *
+ */
+
+#ifndef AR_LABELING_MT_H
+#define AR_LABELING_MT_H
+
+#include <AR/ar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AR_LABELING_MT_THREAD_MAX   16
+#define AR_LABELING_MT_STRIP_MIN    32  // Rows per strip, smaller images are labeled by a single thread.
+
+typedef struct _ARLabelingMTHandle ARLabelingMTHandle;
+
+/*
+ * Creates the threads that label the strips of arLabelingMT(): threadNum - 1 workers, which wait for the strips
+ * of each frame and are kept until arLabelingMTDeleteHandle(). The calling thread labels strips too, and all of
+ * them if no worker could be started. Returns NULL if threadNum is out of 1 to AR_LABELING_MT_THREAD_MAX.
+ */
+ARLabelingMTHandle *arLabelingMTCreateHandle( int threadNum );
+// Stops and joins the workers.
+int arLabelingMTDeleteHandle( ARLabelingMTHandle **handle );
+
+/*
+ * arLabeling() with the rows of the image labeled in horizontal strips concurrently, one per thread of handle.
+ * The label numbers, areas, clips and positions in labelInfo are those arLabeling() gives, so are the contours
+ * arDetectMarker2() traces in the label image.
+ *
+ * Without pthreads (the emscripten builds other than artoolkit_wasm_mt.js) the strips are labeled one after the
+ * other. A NULL handle, the debug mode, the field image mode and the adaptive threshold image (image_thresh) are
+ * left to arLabeling(), and so are the images whose labels don't fit in the ranges of the strips.
+ */
+int arLabelingMT( ARUint8 *image, int xsize, int ysize, int debugMode, int labelingMode, int labelingThresh,
+                  int imageProcMode, ARLabelInfo *labelInfo, ARUint8 *image_thresh, ARLabelingMTHandle *handle );
+
+#ifdef __cplusplus
+}
+#endif
+#endif // AR_LABELING_MT_H
@@ -0,0 +1,237 @@
+/*
+ * Index of the patterns of an ARPattHandle, see ARPattIndex.h.
+ *
+ * Patterns and quads are compared like in arGetMarkerInfo(): 255 - pixel, less the mean, correlated and divided
+ * by the norms. With a the quad and b a pattern split into their block means aL, bL and the rests aR, bR,
+ * a.b = aL.bL + aR.bR <= aL.bL + |aR| |bR|, and aL.bL = sum(sumA * sumB / count) over the blocks.
+ */
+
+#include <math.h>
+#include "ARPattIndex.h"
+
+#define BLOCK_NUM (AR_PATT_INDEX_GRID * AR_PATT_INDEX_GRID)
+
+typedef struct {
+    int     channels;               // 1 for the mono patterns, 3 for the color ones.
+    int     pattSize;
+    int     pattNumMax;
+    int     blockCount[BLOCK_NUM];  // Values in each block.
+} ARPattIndexHeaderT;
+
+// Bytes rounded up for the doubles that follow.
+#define ALIGNED(size) (((size) + sizeof(double) - 1) / sizeof(double) * sizeof(double))
+
+typedef struct {
+    double  norm;                   // 0 for a uniform pattern, -1 for one not loaded when the index was built.
+    double  rest;                   // Norm of the pattern less its block means.
+    double  blockSum[BLOCK_NUM];
+} ARPattIndexEntryT;
+
+typedef struct {
+    double  bound;
+    int     entry;                  // patno * 4 + dir.
+} ARPattIndexBoundT;
+
+// The header is followed by the entries, then by the scratch of arPattIndexShortlist(): the quad's values, for
+// three channels, and a bound per entry, so that shortlisting allocates nothing.
+#define HEADER_SIZE ALIGNED(sizeof(ARPattIndexHeaderT))
+#define ENTRIES_SIZE(pattNumMax) ((pattNumMax) * 4 * sizeof(ARPattIndexEntryT))
+#define INPUT_SIZE(pattSize) ALIGNED((pattSize) * (pattSize) * 3 * sizeof(int))
+
+static ARPattIndexEntryT *entries( const void *index )
+{
+    return (ARPattIndexEntryT *)((const char *)index + HEADER_SIZE);
+}
+
+static int *inputOf( void *index )
+{
+    const ARPattIndexHeaderT *header = (const ARPattIndexHeaderT *)index;
+    return (int *)((char *)index + HEADER_SIZE + ENTRIES_SIZE(header->pattNumMax));
+}
+
+static ARPattIndexBoundT *boundsOf( void *index )
+{
+    const ARPattIndexHeaderT *header = (const ARPattIndexHeaderT *)index;
+    return (ARPattIndexBoundT *)((char *)index + HEADER_SIZE + ENTRIES_SIZE(header->pattNumMax) + INPUT_SIZE(header->pattSize));
+}
+
+static int blockOf( int pixel, int pattSize )
+{
+    return ((pixel / pattSize) * AR_PATT_INDEX_GRID / pattSize) * AR_PATT_INDEX_GRID
+         + (pixel % pattSize) * AR_PATT_INDEX_GRID / pattSize;
+}
+
+// Block sums of v into sum, returns the squared norm of v less its block means.
+static double blockSums( const ARPattIndexHeaderT *header, const int *v, double *sum )
+{
+    int     size = header->pattSize * header->pattSize;
+    double  sq = 0.0, proj = 0.0;
+    int     i, c;
+
+    for( i = 0; i < BLOCK_NUM; i++ ) sum[i] = 0.0;
+    for( i = 0; i < size; i++ ) {
+        double *s = &sum[blockOf(i, header->pattSize)];
+        for( c = 0; c < header->channels; c++ ) {
+            int value = v[i * header->channels + c];
+            *s += value;
+            sq += (double)value * value;
+        }
+    }
+    for( i = 0; i < BLOCK_NUM; i++ ) {
+        if( header->blockCount[i] > 0 ) proj += sum[i] * sum[i] / header->blockCount[i];
+    }
+    return sq > proj ? sq - proj : 0.0;
+}
+
+static int correlate( const int *a, const int *b, int size )
+{
+    int sum = 0, i;
+    for( i = 0; i < size; i++ ) sum += a[i] * b[i];
+    return sum;
+}
+
+// The bounds are taken in decreasing order from a max-heap, since the search usually stops after a few of them:
+// bounds[0..heapNum) is the heap, each bound taken is moved to just after it, so bounds[heapNum..boundNum) holds
+// those taken so far, the largest last.
+static void siftDown( ARPattIndexBoundT *bounds, int heapNum, int i )
+{
+    ARPattIndexBoundT  b = bounds[i];
+    int                child;
+
+    while( (child = 2 * i + 1) < heapNum ) {
+        if( child + 1 < heapNum && bounds[child + 1].bound > bounds[child].bound ) child++;
+        if( bounds[child].bound <= b.bound ) break;
+        bounds[i] = bounds[child];
+        i = child;
+    }
+    bounds[i] = b;
+}
+
+static ARPattIndexBoundT *takeBound( ARPattIndexBoundT *bounds, int *heapNum )
+{
+    ARPattIndexBoundT  top = bounds[0];
+
+    (*heapNum)--;
+    bounds[0] = bounds[*heapNum];
+    siftDown( bounds, *heapNum, 0 );
+    bounds[*heapNum] = top;
+    return &bounds[*heapNum];
+}
+
+int arPattIndexSize( const ARPattHandle *pattHandle )
+{
+    return (int)(HEADER_SIZE + ENTRIES_SIZE(pattHandle->patt_num_max) + INPUT_SIZE(pattHandle->pattSize)
+                 + pattHandle->patt_num_max * 4 * sizeof(ARPattIndexBoundT));
+}
+
+int arPattIndexBuild( const ARPattHandle *pattHandle, int pattDetectMode, void *index )
+{
+    ARPattIndexHeaderT  *header = (ARPattIndexHeaderT *)index;
+    ARPattIndexEntryT   *entry = entries( index );
+    int                  i, k;
+
+    if( pattDetectMode == AR_MATRIX_CODE_DETECTION ) return -1;
+    header->channels = (pattDetectMode == AR_TEMPLATE_MATCHING_MONO || pattDetectMode == AR_TEMPLATE_MATCHING_MONO_AND_MATRIX) ? 1 : 3;
+    header->pattSize = pattHandle->pattSize;
+    header->pattNumMax = pattHandle->patt_num_max;
+    for( i = 0; i < BLOCK_NUM; i++ ) header->blockCount[i] = 0;
+    for( i = 0; i < header->pattSize * header->pattSize; i++ ) {
+        header->blockCount[blockOf(i, header->pattSize)] += header->channels;
+    }
+
+    for( k = 0; k < header->pattNumMax * 4; k++ ) {
+        const int *v;
+        double     sq = 0.0;
+        int        size = header->pattSize * header->pattSize * header->channels;
+
+        entry[k].norm = -1.0;
+        entry[k].rest = 0.0;
+        if( pattHandle->pattf[k / 4] == 0 ) continue;
+        v = header->channels == 1 ? pattHandle->pattBW[k] : pattHandle->patt[k];
+        for( i = 0; i < size; i++ ) sq += (double)v[i] * v[i];
+        entry[k].norm = sqrt( sq );
+        entry[k].rest = sqrt( blockSums( header, v, entry[k].blockSum ) );
+    }
+    return 0;
+}
+
+int arPattIndexShortlist( const ARPattHandle *pattHandle, void *index, const ARUint8 *ext_patt, double cfMin, int *shortlist )
+{
+    const ARPattIndexHeaderT  *header = (const ARPattIndexHeaderT *)index;
+    const ARPattIndexEntryT   *entry = entries( index );
+    int                        size = header->pattSize * header->pattSize * header->channels;
+    int                       *input = inputOf( index );
+    ARPattIndexBoundT         *bounds = boundsOf( index );
+    double                     blockSum[BLOCK_NUM];
+    double                     norm, rest, best = -2.0;
+    int                        ave = 0, sq = 0, boundNum = 0, heapNum, num = 0, bestEntry = -1;
+    int                        i, k;
+
+    for( i = 0; i < size; i++ ) ave += 255 - ext_patt[i];
+    ave /= size;
+    for( i = 0; i < size; i++ ) {
+        input[i] = (255 - ext_patt[i]) - ave;
+        sq += input[i] * input[i];
+    }
+    if( sq == 0 ) return -1;
+    norm = sqrt( (double)sq );
+    rest = sqrt( blockSums( header, input, blockSum ) );
+
+    for( k = 0; k < header->pattNumMax; k++ ) shortlist[k] = 0;
+    for( k = 0; k < header->pattNumMax * 4; k++ ) {
+        double low = 0.0;
+        if( pattHandle->pattf[k / 4] != 1 ) continue;
+        if( entry[k].norm < 0.0 ) { // Loaded since the index was built, left to arGetMarkerInfo().
+            if( !shortlist[k / 4] ) num++;
+            shortlist[k / 4] = 1;
+            continue;
+        }
+        bounds[boundNum].entry = k;
+        if( entry[k].norm == 0.0 ) { // Correlates to 0.
+            bounds[boundNum++].bound = 0.0;
+            continue;
+        }
+        for( i = 0; i < BLOCK_NUM; i++ ) {
+            if( header->blockCount[i] > 0 ) low += blockSum[i] * entry[k].blockSum[i] / header->blockCount[i];
+        }
+        bounds[boundNum++].bound = (low + rest * entry[k].rest) / (norm * entry[k].norm);
+    }
+    for( i = boundNum / 2 - 1; i >= 0; i-- ) siftDown( bounds, boundNum, i );
+    heapNum = boundNum;
+
+    while( heapNum > 0 && bounds[0].bound >= (best > cfMin ? best : cfMin) ) {
+        const ARPattIndexBoundT *b = takeBound( bounds, &heapNum );
+        const ARPattIndexEntryT *e = &entry[b->entry];
+        const int *v = header->channels == 1 ? pattHandle->pattBW[b->entry] : pattHandle->patt[b->entry];
+        double cf = e->norm == 0.0 ? 0.0 : correlate( input, v, size ) / (norm * e->norm);
+        if( cf > best ) {
+            best = cf;
+            bestEntry = b->entry;
+        }
+    }
+
+    if( best < cfMin ) {
+        // No match passes: the closest found, or the first by bound, is left for the confidence to be reported.
+        if( bestEntry < 0 && heapNum > 0 ) bestEntry = bounds[0].entry;
+        if( bestEntry >= 0 && !shortlist[bestEntry / 4] ) {
+            shortlist[bestEntry / 4] = 1;
+            num++;
+        }
+    } else {
+        // The bounds taken, then those left that come close to the best correlation.
+        for( i = boundNum - 1; i >= 0; i-- ) {
+            if( i < heapNum ) {
+                if( heapNum == 0 || bounds[0].bound < best - AR_PATT_INDEX_MARGIN ) break;
+                takeBound( bounds, &heapNum );
+            }
+            if( bounds[i].bound < best - AR_PATT_INDEX_MARGIN ) break;
+            k = bounds[i].entry / 4;
+            if( !shortlist[k] ) {
+                shortlist[k] = 1;
+                num++;
+            }
+        }
+    }
+
+    return num;
+}
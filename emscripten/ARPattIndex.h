@@ -0,0 +1,50 @@
+/*
+ * Index of the patterns of an ARPattHandle, to narrow down template matching in large pattern libraries.
+ *
+ * arGetMarkerInfo() correlates the pattern read from each quad with every loaded pattern in its four orientations.
+ * The index keeps, for each pattern and orientation, the sums of a 4 x 4 grid of blocks and the norm of the rest
+ * of the pattern. The correlation of two patterns is at most the correlation of their block means plus the product
+ * of the norms of their rests, divided by their norms, so a bound is had from 16 products instead of a full
+ * pattern. The patterns are then correlated in full in the order of their bounds, until the best correlation found
+ * beats the bounds left: the patterns whose bound doesn't come close can't be the best match, whatever the library
+ * size.
+ *
+ * The correlation loop is written to be auto-vectorized (artoolkit_wasm_simd.js is built with -msimd128).
+ */
+
+#ifndef AR_PATT_INDEX_H
+#define AR_PATT_INDEX_H
+
+#include <AR/ar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AR_PATT_INDEX_GRID       4    // Blocks of the grid along a side of the pattern.
+#define AR_PATT_INDEX_MARGIN     0.01 // Kept below the best correlation, for the rounding differences with arGetMarkerInfo().
+
+// Bytes of the index of pattHandle, including the scratch of arPattIndexShortlist().
+int arPattIndexSize(const ARPattHandle *pattHandle);
+
+/*
+ * Indexes the patterns of pattHandle loaded (pattf != 0), for the template matching mode of pattDetectMode
+ * (AR_TEMPLATE_MATCHING_MONO or AR_TEMPLATE_MATCHING_MONO_AND_MATRIX for the mono patterns, the color ones
+ * otherwise). index is arPattIndexSize() bytes. Returns -1 for AR_MATRIX_CODE_DETECTION.
+ */
+int arPattIndexBuild(const ARPattHandle *pattHandle, int pattDetectMode, void *index);
+
+/*
+ * Sets shortlist[k] to 1 for the active patterns (pattf == 1) that can be the best match of ext_patt, as read by
+ * arPattGetImage2() in the mode of the index, 0 for the others. shortlist holds pattHandle->patt_num_max entries.
+ * When no pattern correlates with ext_patt by cfMin or more, only the closest one found is shortlisted, which may
+ * not be the best match, for its confidence to be reported below cfMin. Patterns loaded after arPattIndexBuild()
+ * are always shortlisted. Returns the number of patterns shortlisted, -1 if ext_patt is uniform.
+ * The index holds the scratch of the call, so it can't shortlist for two threads at once; nothing is allocated.
+ */
+int arPattIndexShortlist(const ARPattHandle *pattHandle, void *index, const ARUint8 *ext_patt, double cfMin, int *shortlist);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // AR_PATT_INDEX_H
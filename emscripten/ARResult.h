@@ -0,0 +1,101 @@
+/*
+ * Results handed back to the caller of the controller API in ARToolKitJS.cpp.
+ *
+ * The emscripten build writes them into the artoolkit JS object (artoolkit["frameMalloc"],
+ * artoolkit["markerInfo"], ...), see ARResultEM.cpp. The native build keeps the last result
+ * of each kind, see native/ARResultNative.cpp and native/ARToolKitNative.h.
+ */
+
+#ifndef AR_RESULT_H
+#define AR_RESULT_H
+
+#include <AR/ar.h>
+
+struct FrameMallocResult {
+	int id;
+	ARUint8 *framepointer;
+	int framesize;
+	ARdouble *camera;           // 4x4 projection matrix
+	ARdouble *transform;        // 3x4 transformation matrix filled by the getTransMat* functions
+	ARUint8 *videoLumaPointer;
+	int ardoubleSize;
+	ARdouble *squarePoses;      // AR_SQUARE_MAX 3x4 matrices filled by getTransMatSquareBatch, by marker index
+	int *squarePoseTypes;       // type of the marker of each pose, -1 if it was not estimated
+	ARdouble *squarePoseErrors;
+	int squarePoseMax;          // AR_SQUARE_MAX
+	float *squarePosesGL;       // the squarePoses as column-major OpenGL right-handed model-view matrices, 16 floats each
+};
+
+struct NFTMarkerResult {
+	int id;
+	float error;
+	int found;
+	float pose[12];
+};
+
+struct MultiEachMarkerResult {
+	int visible;
+	int pattId;
+	int pattType;
+	ARdouble width;
+};
+
+// Poses of all the multimarkers of a controller, see getTransMatMultiSquareBatch().
+struct MultiMarkerBatchResult {
+	int multiMarkerNum;
+	ARdouble *trans;            // a 3x4 matrix per multimarker, the last pose of those out of view
+	int *visibleNum;            // visible sub-markers of each multimarker
+	ARdouble *errors;           // -1 for the multimarkers without visible sub-marker
+};
+
+// Quality of the last AR2 tracking of a controller's NFT marker, see getNFTTrackingInfo().
+struct NFTTrackingResult {
+	int markerIndex;            // -1 if no NFT marker was tracked in the last frame
+	int result;                 // ar2TrackingMod(): 0 tracked, -3 fewer than 3 features matched, -4 error above threshold after the cascade
+	float error;                // final tracking error
+	int candidateNum;           // visible features
+	int trackedNum;             // features matched above the similarity threshold
+	float simAverage;           // average similarity of the matched features
+	float blurLevel;            // average blur level of the matched features, -1 without adaptive templates
+	int icpLevel;               // pose estimations run in the robust cascade
+	float icpErr[5];            // error after each: no outlier rejection, inlier probability 0.8, 0.6, 0.4, 0.0; -1 if not run
+	int searchFeatureNum;       // current AR2 settings, for adaptive policies
+	float simThresh;
+	float trackingThresh;
+};
+
+// Timings (ms) and counters of the last frame of a controller, see getFrameStats().
+struct FrameStatsResult {
+	int frameNum;               // detectMarker() calls since setup
+	double detectMs;            // arDetectMarker(): thresholding, labeling, quad fitting, pattern and matrix decoding
+	int labelNum;               // connected components found by the labeling
+	int candidateQuadNum;       // components fitted as quads, before pattern and matrix decoding
+	int markerNum;              // quads decoded as markers
+	int roiNum;                 // regions scanned instead of the whole frame, 0 for a full scan, see setROIFullScanInterval()
+	int coarseFactor;           // downscaling of the labeling, 1 at full resolution, see setCoarseDetectionFactor()
+	int threshold;              // labeling threshold of the frame, unused in the adaptive threshold mode
+	int pattShortlistNum;       // patterns left to correlate with the quads by the pattern index, -1 without, see setPatternIndexEnabled()
+	int trackedMarkerNum;       // square markers tracked from the last frame instead of detected, see setCornerTrackingInterval()
+	double squarePoseMs;        // getTransMatSquare() and getTransMatSquareCont() calls
+	int squarePoseNum;
+	double multiPoseMs;         // getTransMatMultiSquare() and getTransMatMultiSquareRobust() calls
+	int multiPoseNum;
+	double kpmMs;               // kpmMatching(): feature extraction and matching, 0 while an NFT marker is tracked
+	int kpmResultNum;           // -1 if KPM did not run
+	double ar2CandidateMs;      // AR2 tracking of the NFT marker, see AR2TrackingModStatsT
+	double ar2TemplateMs;
+	double ar2IcpMs;
+	int ar2CandidateNum;
+	int ar2TrackedFeatureNum;
+	int ar2IcpLevel;            // 1-5, the level of the robust ICP cascade the pose was accepted or given up at
+};
+
+void emitFrameMallocResult(const FrameMallocResult *result);
+void emitMarkerInfoResult(const ARMarkerInfo *markerInfo);
+void emitNFTMarkerResult(const NFTMarkerResult *result);
+void emitMultiEachMarkerResult(const MultiEachMarkerResult *result);
+void emitMultiMarkerBatchResult(const MultiMarkerBatchResult *result);
+void emitFrameStatsResult(const FrameStatsResult *result);
+void emitNFTTrackingResult(const NFTTrackingResult *result);
+
+#endif // AR_RESULT_H
@@ -0,0 +1,325 @@
+/*
+ * Emscripten implementation of ARResult.h. Included at the end of ARToolKitJS.cpp, like ARBindEM.cpp.
+ */
+
+#include <emscripten.h>
+
+void emitFrameMallocResult(const FrameMallocResult *result) {
+	EM_ASM_({
+		if (!artoolkit["frameMalloc"]) {
+			artoolkit["frameMalloc"] = ({});
+		}
+		var frameMalloc = artoolkit["frameMalloc"];
+		frameMalloc["framepointer"] = $1;
+		frameMalloc["framesize"] = $2;
+		frameMalloc["camera"] = $3;
+		frameMalloc["transform"] = $4;
+		frameMalloc["videoLumaPointer"] = $5;
+		frameMalloc["ardoubleSize"] = $6;
+		frameMalloc["squarePoses"] = $7;
+		frameMalloc["squarePoseTypes"] = $8;
+		frameMalloc["squarePoseErrors"] = $9;
+		frameMalloc["squarePoseMax"] = $10;
+		frameMalloc["squarePosesGL"] = $11;
+	},
+		result->id,
+		result->framepointer,
+		result->framesize,
+		result->camera,
+		result->transform,
+		result->videoLumaPointer,   //$5
+		result->ardoubleSize,
+		result->squarePoses,
+		result->squarePoseTypes,
+		result->squarePoseErrors,
+		result->squarePoseMax,
+		result->squarePosesGL
+	);
+}
+
+void emitMarkerInfoResult(const ARMarkerInfo *markerInfo) {
+	EM_ASM_({
+		var $a = arguments;
+		var i = 12;
+		if (!artoolkit["markerInfo"]) {
+			artoolkit["markerInfo"] = ({
+				pos: [0,0],
+				line: [[0,0,0], [0,0,0], [0,0,0], [0,0,0]],
+				vertex: [[0,0], [0,0], [0,0], [0,0]]
+			});
+		}
+		var markerInfo = artoolkit["markerInfo"];
+		markerInfo["area"] = $0;
+		markerInfo["id"] = $1;
+		markerInfo["idPatt"] = $2;
+		markerInfo["idMatrix"] = $3;
+		markerInfo["dir"] = $4;
+		markerInfo["dirPatt"] = $5;
+		markerInfo["dirMatrix"] = $6;
+		markerInfo["cf"] = $7;
+		markerInfo["cfPatt"] = $8;
+		markerInfo["cfMatrix"] = $9;
+		markerInfo["pos"][0] = $10;
+		markerInfo["pos"][1] = $11;
+		markerInfo["line"][0][0] = $a[i++];
+		markerInfo["line"][0][1] = $a[i++];
+		markerInfo["line"][0][2] = $a[i++];
+		markerInfo["line"][1][0] = $a[i++];
+		markerInfo["line"][1][1] = $a[i++];
+		markerInfo["line"][1][2] = $a[i++];
+		markerInfo["line"][2][0] = $a[i++];
+		markerInfo["line"][2][1] = $a[i++];
+		markerInfo["line"][2][2] = $a[i++];
+		markerInfo["line"][3][0] = $a[i++];
+		markerInfo["line"][3][1] = $a[i++];
+		markerInfo["line"][3][2] = $a[i++];
+		markerInfo["vertex"][0][0] = $a[i++];
+		markerInfo["vertex"][0][1] = $a[i++];
+		markerInfo["vertex"][1][0] = $a[i++];
+		markerInfo["vertex"][1][1] = $a[i++];
+		markerInfo["vertex"][2][0] = $a[i++];
+		markerInfo["vertex"][2][1] = $a[i++];
+		markerInfo["vertex"][3][0] = $a[i++];
+		markerInfo["vertex"][3][1] = $a[i++];
+		markerInfo["errorCorrected"] = $a[i++];
+		// markerInfo["globalID"] = $a[i++];
+	},
+		markerInfo->area,
+		markerInfo->id,
+		markerInfo->idPatt,
+		markerInfo->idMatrix,
+		markerInfo->dir,
+		markerInfo->dirPatt,
+		markerInfo->dirMatrix,
+		markerInfo->cf,
+		markerInfo->cfPatt,
+		markerInfo->cfMatrix,
+
+		markerInfo->pos[0],
+		markerInfo->pos[1],
+
+		markerInfo->line[0][0],
+		markerInfo->line[0][1],
+		markerInfo->line[0][2],
+
+		markerInfo->line[1][0],
+		markerInfo->line[1][1],
+		markerInfo->line[1][2],
+
+		markerInfo->line[2][0],
+		markerInfo->line[2][1],
+		markerInfo->line[2][2],
+
+		markerInfo->line[3][0],
+		markerInfo->line[3][1],
+		markerInfo->line[3][2],
+
+		//
+
+		markerInfo->vertex[0][0],
+		markerInfo->vertex[0][1],
+
+		markerInfo->vertex[1][0],
+		markerInfo->vertex[1][1],
+
+		markerInfo->vertex[2][0],
+		markerInfo->vertex[2][1],
+
+		markerInfo->vertex[3][0],
+		markerInfo->vertex[3][1],
+
+		//
+
+		markerInfo->errorCorrected
+
+		// markerInfo->globalID
+	);
+}
+
+void emitNFTMarkerResult(const NFTMarkerResult *result) {
+	EM_ASM_({
+		var $a = arguments;
+		var i = 0;
+		if (!artoolkit["NFTMarkerInfo"]) {
+			artoolkit["NFTMarkerInfo"] = ({
+				id: 0,
+				error: -1,
+				found: 0,
+				pose: [0,0,0,0, 0,0,0,0, 0,0,0,0]
+			});
+		}
+		var markerInfo = artoolkit["NFTMarkerInfo"];
+		markerInfo["id"] = $a[i++];
+		markerInfo["error"] = $a[i++];
+		markerInfo["found"] = $a[i++];
+		markerInfo["pose"][0] = $a[i++];
+		markerInfo["pose"][1] = $a[i++];
+		markerInfo["pose"][2] = $a[i++];
+		markerInfo["pose"][3] = $a[i++];
+		markerInfo["pose"][4] = $a[i++];
+		markerInfo["pose"][5] = $a[i++];
+		markerInfo["pose"][6] = $a[i++];
+		markerInfo["pose"][7] = $a[i++];
+		markerInfo["pose"][8] = $a[i++];
+		markerInfo["pose"][9] = $a[i++];
+		markerInfo["pose"][10] = $a[i++];
+		markerInfo["pose"][11] = $a[i++];
+	},
+		result->id,
+		result->error,
+		result->found,
+
+		result->pose[0],
+		result->pose[1],
+		result->pose[2],
+		result->pose[3],
+
+		result->pose[4],
+		result->pose[5],
+		result->pose[6],
+		result->pose[7],
+
+		result->pose[8],
+		result->pose[9],
+		result->pose[10],
+		result->pose[11]
+	);
+}
+
+void emitMultiEachMarkerResult(const MultiEachMarkerResult *result) {
+	EM_ASM_({
+		if (!artoolkit["multiEachMarkerInfo"]) {
+			artoolkit["multiEachMarkerInfo"] = ({});
+		}
+		var multiEachMarker = artoolkit["multiEachMarkerInfo"];
+		multiEachMarker['visible'] = $0;
+		multiEachMarker['pattId'] = $1;
+		multiEachMarker['pattType'] = $2;
+		multiEachMarker['width'] = $3;
+	},
+		result->visible,
+		result->pattId,
+		result->pattType,
+		result->width
+	);
+}
+
+void emitMultiMarkerBatchResult(const MultiMarkerBatchResult *result) {
+	EM_ASM_({
+		if (!artoolkit["multiMarkerBatch"]) {
+			artoolkit["multiMarkerBatch"] = ({});
+		}
+		var multiMarkerBatch = artoolkit["multiMarkerBatch"];
+		multiMarkerBatch["multiMarkerNum"] = $0;
+		multiMarkerBatch["trans"] = $1;
+		multiMarkerBatch["visibleNum"] = $2;
+		multiMarkerBatch["errors"] = $3;
+	},
+		result->multiMarkerNum,
+		result->trans,
+		result->visibleNum,
+		result->errors
+	);
+}
+
+void emitFrameStatsResult(const FrameStatsResult *result) {
+	EM_ASM_({
+		var $a = arguments;
+		var i = 0;
+		if (!artoolkit["frameStats"]) {
+			artoolkit["frameStats"] = ({});
+		}
+		var frameStats = artoolkit["frameStats"];
+		frameStats["frameNum"] = $a[i++];
+		frameStats["detectMs"] = $a[i++];
+		frameStats["labelNum"] = $a[i++];
+		frameStats["candidateQuadNum"] = $a[i++];
+		frameStats["markerNum"] = $a[i++];
+		frameStats["roiNum"] = $a[i++];
+		frameStats["coarseFactor"] = $a[i++];
+		frameStats["threshold"] = $a[i++];
+		frameStats["pattShortlistNum"] = $a[i++];
+		frameStats["trackedMarkerNum"] = $a[i++];
+		frameStats["squarePoseMs"] = $a[i++];
+		frameStats["squarePoseNum"] = $a[i++];
+		frameStats["multiPoseMs"] = $a[i++];
+		frameStats["multiPoseNum"] = $a[i++];
+		frameStats["kpmMs"] = $a[i++];
+		frameStats["kpmResultNum"] = $a[i++];
+		frameStats["ar2CandidateMs"] = $a[i++];
+		frameStats["ar2TemplateMs"] = $a[i++];
+		frameStats["ar2IcpMs"] = $a[i++];
+		frameStats["ar2CandidateNum"] = $a[i++];
+		frameStats["ar2TrackedFeatureNum"] = $a[i++];
+		frameStats["ar2IcpLevel"] = $a[i++];
+	},
+		result->frameNum,
+		result->detectMs,
+		result->labelNum,
+		result->candidateQuadNum,
+		result->markerNum,
+		result->roiNum,
+		result->coarseFactor,
+		result->threshold,
+		result->pattShortlistNum,
+		result->trackedMarkerNum,
+		result->squarePoseMs,
+		result->squarePoseNum,
+		result->multiPoseMs,
+		result->multiPoseNum,
+		result->kpmMs,
+		result->kpmResultNum,
+		result->ar2CandidateMs,
+		result->ar2TemplateMs,
+		result->ar2IcpMs,
+		result->ar2CandidateNum,
+		result->ar2TrackedFeatureNum,
+		result->ar2IcpLevel
+	);
+}
+
+void emitNFTTrackingResult(const NFTTrackingResult *result) {
+	EM_ASM_({
+		var $a = arguments;
+		var i = 0;
+		if (!artoolkit["NFTTrackingInfo"]) {
+			artoolkit["NFTTrackingInfo"] = ({
+				icpErr: [-1, -1, -1, -1, -1]
+			});
+		}
+		var trackingInfo = artoolkit["NFTTrackingInfo"];
+		trackingInfo["markerIndex"] = $a[i++];
+		trackingInfo["result"] = $a[i++];
+		trackingInfo["error"] = $a[i++];
+		trackingInfo["candidateNum"] = $a[i++];
+		trackingInfo["trackedNum"] = $a[i++];
+		trackingInfo["simAverage"] = $a[i++];
+		trackingInfo["blurLevel"] = $a[i++];
+		trackingInfo["icpLevel"] = $a[i++];
+		trackingInfo["icpErr"][0] = $a[i++];
+		trackingInfo["icpErr"][1] = $a[i++];
+		trackingInfo["icpErr"][2] = $a[i++];
+		trackingInfo["icpErr"][3] = $a[i++];
+		trackingInfo["icpErr"][4] = $a[i++];
+		trackingInfo["searchFeatureNum"] = $a[i++];
+		trackingInfo["simThresh"] = $a[i++];
+		trackingInfo["trackingThresh"] = $a[i++];
+	},
+		result->markerIndex,
+		result->result,
+		result->error,
+		result->candidateNum,
+		result->trackedNum,
+		result->simAverage,
+		result->blurLevel,
+		result->icpLevel,
+		result->icpErr[0],
+		result->icpErr[1],
+		result->icpErr[2],
+		result->icpErr[3],
+		result->icpErr[4],
+		result->searchFeatureNum,
+		result->simThresh,
+		result->trackingThresh
+	);
+}
@@ -0,0 +1,94 @@
+/*
+ * Fast adaptive thresholding, see ARThreshAdaptive.h.
+ *
+ * The means of the rows are computed with a running sum and kept in a ring buffer of kernel rows, whose column
+ * sums are updated by adding the row entering the box and subtracting the one leaving it. The divisions by the
+ * number of pixels of the (clipped) box are multiplications by a reciprocal, exact for the sums of 8-bit pixels.
+ */
+
+#include <stdint.h>
+#include "ARThreshAdaptive.h"
+
+#define DIV_SHIFT 24
+
+// floor(sum / count) for sum <= 255 * count and count <= AR_THRESH_ADAPTIVE_KERNEL_SIZE_MAX.
+#define DIV(sum, recip) ((int)(((uint32_t)(sum) * (recip)) >> DIV_SHIFT))
+
+static uint32_t reciprocal( int count )
+{
+    return ((1u << DIV_SHIFT) + count - 1) / count;
+}
+
+int arThreshAdaptiveWorkSize( int xsize, int kernelSize )
+{
+    int n = (kernelSize / 2) * 2 + 1;
+    return xsize * (int)sizeof(uint16_t) + n * xsize;
+}
+
+// The means of the boxes of 2 * half + 1 pixels along the row.
+static void rowMeans( const ARUint8 *src, int xsize, int half, ARUint8 *dst )
+{
+    int       x, sum = 0;
+    int       x0 = half < xsize ? half : xsize; // First pixel whose box isn't clipped on the left.
+    int       x1 = xsize - half > x0 ? xsize - half : x0; // First pixel clipped on the right.
+    uint32_t  recip = reciprocal( 2 * half + 1 );
+
+    for( x = 0; x < half && x < xsize; x++ ) sum += src[x];
+    for( x = 0; x < x0; x++ ) {
+        if( x + half < xsize ) sum += src[x + half];
+        dst[x] = (ARUint8)DIV( sum, reciprocal( (x + half < xsize ? x + half : xsize - 1) + 1 ) );
+    }
+    for( ; x < x1; x++ ) {
+        sum += src[x + half];
+        if( x > half ) sum -= src[x - half - 1];
+        dst[x] = (ARUint8)DIV( sum, recip );
+    }
+    for( ; x < xsize; x++ ) {
+        if( x > half ) sum -= src[x - half - 1];
+        dst[x] = (ARUint8)DIV( sum, reciprocal( xsize - (x > half ? x - half : 0) ) );
+    }
+}
+
+int arThreshAdaptiveBinarize( const ARUint8 *image, int xsize, int ysize, int kernelSize, int bias, ARUint8 *bw, void *work )
+{
+    int        half = kernelSize / 2;
+    int        n = 2 * half + 1;
+    uint16_t  *colSum = (uint16_t *)work;
+    ARUint8   *rows = (ARUint8 *)(colSum + xsize);
+    int        x, y;
+
+    if( kernelSize < 1 || kernelSize > AR_THRESH_ADAPTIVE_KERNEL_SIZE_MAX ) return -1;
+
+    for( x = 0; x < xsize; x++ ) colSum[x] = 0;
+    for( y = 0; y < half && y < ysize; y++ ) {
+        ARUint8 *row = rows + (y % n) * xsize;
+        rowMeans( image + y * xsize, xsize, half, row );
+        for( x = 0; x < xsize; x++ ) colSum[x] += row[x];
+    }
+
+    for( y = 0; y < ysize; y++ ) {
+        const ARUint8  *src = image + y * xsize;
+        ARUint8        *dst = bw + y * xsize;
+        int             y0 = y > half ? y - half : 0;
+        int             y1 = y + half < ysize ? y + half : ysize - 1;
+        uint32_t        recip = reciprocal( y1 - y0 + 1 );
+
+        // Row y - half - 1 leaves the box and row y + half, in the same slot of the ring, enters it.
+        if( y > half ) {
+            const ARUint8 *row = rows + ((y - half - 1) % n) * xsize;
+            for( x = 0; x < xsize; x++ ) colSum[x] -= row[x];
+        }
+        if( y + half < ysize ) {
+            ARUint8 *row = rows + ((y + half) % n) * xsize;
+            rowMeans( image + (y + half) * xsize, xsize, half, row );
+            for( x = 0; x < xsize; x++ ) colSum[x] += row[x];
+        }
+
+        for( x = 0; x < xsize; x++ ) {
+            int thresh = DIV( colSum[x], recip ) + bias;
+            thresh = thresh < 0 ? 0 : (thresh > 255 ? 255 : thresh);
+            dst[x] = src[x] <= thresh ? AR_THRESH_ADAPTIVE_DARK : 255;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * Fast adaptive thresholding for AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE.
+ *
+ * arDetectMarker() box filters the whole luma with arImageProcLumaHistAndBoxFilterWithBias(), which sums
+ * the kernel for every pixel, then labels comparing each pixel with the filtered image. Here the box sums are
+ * kept running, along the rows and down the columns, so a pixel costs the same whatever the kernel size, and
+ * the comparison is done as the mean is computed: the output is a binary image labeled with a fixed threshold,
+ * at the cost of the manual threshold mode.
+ *
+ * The inner loops are written to be auto-vectorized (artoolkit_wasm_simd.js is built with -msimd128).
+ */
+
+#ifndef AR_THRESH_ADAPTIVE_H
+#define AR_THRESH_ADAPTIVE_H
+
+#include <AR/ar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AR_THRESH_ADAPTIVE_KERNEL_SIZE_MAX  63
+#define AR_THRESH_ADAPTIVE_DARK             0   // Value of the dark pixels in the binary image, 255 for the others.
+#define AR_THRESH_ADAPTIVE_LABELING_THRESH  127 // Threshold to label the binary image with.
+
+// Bytes of the work buffer of arThreshAdaptiveBinarize().
+int arThreshAdaptiveWorkSize(int xsize, int kernelSize);
+
+/*
+ * Writes to bw AR_THRESH_ADAPTIVE_DARK where image is at most the mean of the kernelSize x kernelSize box around
+ * the pixel plus bias, 255 elsewhere. As in arImageProcLumaHistAndBoxFilterWithBias() the kernel size is made odd
+ * (kernelSize / 2 pixels on each side), the box is clipped at the image borders, and the mean of the rows is
+ * truncated before the mean of the columns is. Returns -1 if kernelSize is out of range.
+ */
+int arThreshAdaptiveBinarize(const ARUint8 *image, int xsize, int ysize, int kernelSize, int bias, ARUint8 *bw, void *work);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // AR_THRESH_ADAPTIVE_H
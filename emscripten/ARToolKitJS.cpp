@@ -7,6 +7,7 @@
     #endif
 
     ** According to config.h ARDOUBLE_IS_FLOAT is false when compiling with emscripten. This means we are dealing with 64bit float
+    ** The artoolkit_wasm_float.js build defines ARDOUBLE_IS_FLOAT; frameMalloc reports sizeof(ARdouble) so the JS side can pick its views.
 */
 
 #include <stdio.h>
@@ -14,17 +15,27 @@
 //#include <AR/gsub_lite.h>
 // #include <AR/gsub_es2.h>
 #include <AR/arMulti.h>
-#include <emscripten.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <AR/config.h>
 #include <AR/arFilterTransMat.h>
+#include <AR/arImageProc.h>
 #include <AR2/tracking.h>
 #include <AR/paramGL.h>
 #include <AR/video.h>
 #include <KPM/kpm.h>
 #include "trackingMod.h"
+#include "ARResult.h"
+#include "ARTrace.h"
+#include "ARLabelingMT.h"
+#include "ARThreshAdaptive.h"
+#include "ARPattIndex.h"
+#include "ARCornerTrack.h"
 
 #define PAGES_MAX               10          // Maximum number of pages expected. You can change this down (to save memory) or up (to accomodate more pages.)
 
@@ -33,15 +44,31 @@ struct multi_marker {
 	ARMultiMarkerInfoT *multiMarkerHandle;
 };
 
+// Square marker types, as artoolkit.PATTERN_MARKER and artoolkit.BARCODE_MARKER.
+#define SQUARE_MARKER_UNKNOWN   -1
+#define SQUARE_MARKER_PATTERN   0
+#define SQUARE_MARKER_BARCODE   1
+
+// The registered width and last pose of a square marker, see setSquareMarkerWidth().
+struct square_pose {
+	ARdouble width;
+	ARdouble trans[3][4];
+	int frameNum = -1; // Frame of the last pose, -1 for none.
+	ARFilterTransMatInfo *filter = NULL; // See setPoseFilter(), made with the first filtered pose.
+};
+
 struct arController {
 	int id;
 
+	int cameraID = -1;
 	ARParam param;
 	ARParamLT *paramLT = NULL;
 
 	ARUint8 *videoFrame = NULL;
 	int videoFrameSize;
 	ARUint8 *videoLuma = NULL;
+	int frameCapacity = 0; // Pixels the frame and luma buffers can hold, see setupWithMemoryPlan().
+	int maxSearchFeatureNum = AR2_SEARCH_FEATURE_MAX;
 
 	int width = 0;
 	int height = 0;
@@ -49,15 +76,16 @@ struct arController {
 	ARHandle *arhandle = NULL;
 	ARPattHandle *arPattHandle = NULL;
 	ARMultiMarkerInfoT *arMultiMarkerHandle = NULL;
-	AR3DHandle* ar3DHandle;
+	AR3DHandle* ar3DHandle = NULL;
 
-	KpmHandle* kpmHandle;
-	AR2HandleT* ar2Handle;
+	KpmHandle* kpmHandle = NULL;
+	AR2HandleT* ar2Handle = NULL;
+	KpmRefDataSet *kpmRefDataSet = NULL; // Kept so kpmHandle can be rebuilt on resize.
 
 	int detectedPage = -2;  // -2 Tracking not inited, -1 tracking inited OK, >= 0 tracking online on page.
 
 	int surfaceSetCount = 0; // Running NFT marker id
-	AR2SurfaceSetT      *surfaceSet[PAGES_MAX];
+	AR2SurfaceSetT      *surfaceSet[PAGES_MAX] = {};
 	std::unordered_map<int, AR2SurfaceSetT*> surfaceSets;
 
 	ARdouble nearPlane = 0.0001;
@@ -69,6 +97,54 @@ struct arController {
 
 	ARdouble cameraLens[16];
 	AR_PIXEL_FORMAT pixFormat = AR_PIXEL_FORMAT_RGBA;
+
+	FrameStatsResult stats = {}; // See getFrameStats().
+
+	int roiFullScanInterval = 0; // See setROIFullScanInterval(), 0 to scan every frame in full.
+	int roiFramesSinceFullScan = 0;
+	std::vector<int> roiMarkerIds; // Markers found in the last frame, all must be found again in the ROIs.
+	std::vector<ARUint8> roiLuma;
+	int coarseFactor = 1; // See setCoarseDetectionFactor().
+	std::vector<ARUint8> coarseLuma;
+	int labelingThreadNum = 1; // See setLabelingThreadNum().
+	ARLabelingMTHandle *labelingMTHandle = NULL; // Workers of the labeling, with more than one thread.
+	std::vector<ARUint8> adaptiveBw; // Luma binarized by the adaptive threshold.
+	std::vector<ARUint8> adaptiveWork;
+	bool fastAdaptiveEnabled = false; // See setFastAdaptiveThresholdEnabled().
+	int threshSampleStep = 0; // See setThresholdEstimation(), 0 for the auto threshold of arDetectMarker().
+	int threshInterval = 1;
+	int threshMaxShift = 0;
+	double threshSmoothing = 0;
+	int threshFramesSinceUpdate = 0;
+	double threshSmoothed = -1; // -1 until the first estimate.
+	double threshMean = 0; // Brightness at the last estimate.
+	bool pattIndexEnabled = false; // See setPatternIndexEnabled().
+	std::vector<ARUint8> pattIndex; // Emptied when patterns are loaded, built again by the next frame.
+	int pattIndexMode = -1; // Pattern detection mode the index was built for.
+	std::vector<int> pattShortlist;
+	std::vector<ARUint8> pattImage;
+	int cornerTrackInterval = 0; // See setCornerTrackingInterval(), 0 to detect the markers in every frame.
+	int cornerTrackFrames = 0; // Frames tracked since the markers were last detected.
+	std::vector<ARUint8> trackPyramid; // Of the last frame, see arCornerTrackPyramid().
+	std::vector<ARUint8> trackPyramidNext;
+	bool trackPyramidValid = false;
+	bool historySkipped = false; // Frames were processed without arDetectMarker() since the last one.
+	NFTTrackingResult nftTracking = {}; // See getNFTTrackingInfo().
+	std::unordered_map<int, square_pose> squarePoses; // By marker id * 2 + type.
+	ARdouble batchTrans[AR_SQUARE_MAX][3][4]; // Poses of the markers by index, see getTransMatSquareBatch().
+	int batchTypes[AR_SQUARE_MAX];
+	ARdouble batchErrors[AR_SQUARE_MAX];
+	float batchGL[AR_SQUARE_MAX][16]; // batchTrans as column-major OpenGL right-handed model-view matrices.
+	ARdouble poseFilterSampleRate = AR_FILTER_TRANS_MAT_SAMPLE_RATE_DEFAULT; // See setPoseFilter().
+	ARdouble poseFilterCutoff = 0; // 0 for unfiltered poses.
+	bool multiIndexValid = false; // Multimarkers by sub-marker, see getTransMatMultiSquareBatch(). Built again when one is added.
+	std::unordered_map<int, std::vector<int>> multiPattIndex; // By the pattern id of a template sub-marker.
+	std::unordered_map<int, std::vector<int>> multiMatrixIndex; // By the code of a matrix sub-marker.
+	std::unordered_map<unsigned long long, std::vector<int>> multiGlobalIndex; // By the global id of a matrix sub-marker.
+	std::vector<char> multiInView;
+	std::vector<ARdouble> multiBatchTrans; // A 3x4 matrix per multimarker.
+	std::vector<int> multiBatchVisible;
+	std::vector<ARdouble> multiBatchErrors;
 };
 
 std::unordered_map<int, arController> arControllers;
@@ -90,8 +166,626 @@ static int MARKER_INDEX_OUT_OF_BOUNDS = -3;
 
 static ARMarkerInfo gMarkerInfo;
 
+static double nowMs() {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// ============================================================================
+//	ARParamLT cache
+// ============================================================================
+
+#define PARAM_LT_CACHE_UNUSED_MAX 4 // Unreferenced lookup tables kept around for re-setups and resolution switches.
+
+struct param_lt_entry {
+	ARParam param;
+	int offset;
+	ARParamLT *paramLT;
+	int refCount;
+};
+
+static std::vector<param_lt_entry> paramLTCache;
+
+static bool paramEquals(const ARParam *a, const ARParam *b) {
+	return a->xsize == b->xsize && a->ysize == b->ysize &&
+		a->dist_function_version == b->dist_function_version &&
+		memcmp(a->mat, b->mat, sizeof(a->mat)) == 0 &&
+		memcmp(a->dist_factor, b->dist_factor, sizeof(a->dist_factor)) == 0;
+}
+
+static void trimParamLTCache(int keepUnused) {
+	int unused = 0;
+	for (size_t i = 0; i < paramLTCache.size(); i++) {
+		if (paramLTCache[i].refCount == 0) unused++;
+	}
+	// Entries are kept in least-recently-used order, so evict from the front.
+	for (size_t i = 0; i < paramLTCache.size() && unused > keepUnused; ) {
+		if (paramLTCache[i].refCount == 0) {
+			arParamLTFree(&(paramLTCache[i].paramLT));
+			paramLTCache.erase(paramLTCache.begin() + i);
+			unused--;
+		} else {
+			i++;
+		}
+	}
+}
+
+/**
+	Returns a lookup table for param, building it only if no controller has
+	already created one for the same camera parameters, size and offset.
+	Every successful call must be paired with releaseParamLT().
+*/
+static ARParamLT *acquireParamLT(ARParam *param, int offset) {
+	for (size_t i = 0; i < paramLTCache.size(); i++) {
+		if (paramLTCache[i].offset == offset && paramEquals(&(paramLTCache[i].param), param)) {
+			param_lt_entry entry = paramLTCache[i];
+			entry.refCount++;
+			paramLTCache.erase(paramLTCache.begin() + i);
+			paramLTCache.push_back(entry);
+			return entry.paramLT;
+		}
+	}
+
+	param_lt_entry entry;
+	if ((entry.paramLT = arParamLTCreate(param, offset)) == NULL) {
+		return NULL;
+	}
+	entry.param = *param;
+	entry.offset = offset;
+	entry.refCount = 1;
+	paramLTCache.push_back(entry);
+
+	return entry.paramLT;
+}
+
+static void releaseParamLT(ARParamLT **paramLT_p) {
+	for (size_t i = 0; i < paramLTCache.size(); i++) {
+		if (paramLTCache[i].paramLT == *paramLT_p) {
+			if (paramLTCache[i].refCount > 0) paramLTCache[i].refCount--;
+			*paramLT_p = NULL;
+			trimParamLTCache(PARAM_LT_CACHE_UNUSED_MAX);
+			return;
+		}
+	}
+	// Not one of ours.
+	arParamLTFree(paramLT_p);
+}
+
+
+// ============================================================================
+//	Controller pool
+// ============================================================================
+
+#define CONTROLLER_POOL_MAX 2 // Torn down controllers whose allocations are kept for reuse by setup().
+
+// The size-dependent allocations of a torn down controller.
+struct pooled_controller {
+	int width;
+	int height;
+
+	ARUint8 *videoFrame;
+	int videoFrameSize;
+	ARUint8 *videoLuma;
+	int frameCapacity;
+
+	ARParam param;
+	ARParamLT *paramLT;
+	ARHandle *arhandle;
+	AR3DHandle *ar3DHandle;
+	AR2HandleT *ar2Handle;
+};
+
+static std::vector<pooled_controller> controllerPool;
+
+
+// ============================================================================
+//	Region of interest detection
+// ============================================================================
+
+#define ROI_MARGIN_MIN 16    // Pixels added around a marker's bounding box, at least.
+#define ROI_MARGIN_RATIO 0.5 // And this fraction of its size, for the motion between frames.
+
+struct roi_box {
+	int x0, y0, x1, y1; // Inclusive.
+};
+
+// Whether detectMarker() can look for the markers of the last frame in ROIs only. The full scan (arDetectMarker())
+// is also needed to update auto thresholds other than adaptive, which has its own thresholding of the whole frame.
+static bool roiDetectionPossible(arController *arc) {
+	ARHandle *handle = arc->arhandle;
+	if (arc->roiFullScanInterval <= 0 || arc->roiFramesSinceFullScan + 1 >= arc->roiFullScanInterval) return false;
+	if (arc->roiMarkerIds.empty() || handle->marker_num <= 0) return false;
+	if (handle->arDebug != AR_DEBUG_DISABLE || handle->arImageProcMode != AR_IMAGE_PROC_FRAME_IMAGE) return false;
+	return handle->arLabelingThreshMode != AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE;
+}
+
+// A marker in two boxes would be found twice.
+static void mergeROIBoxes(std::vector<roi_box> *boxes) {
+	for (bool merged = true; merged; ) {
+		merged = false;
+		for (size_t i = 0; i < boxes->size() && !merged; i++) {
+			for (size_t j = i + 1; j < boxes->size() && !merged; j++) {
+				roi_box &a = (*boxes)[i], &b = (*boxes)[j];
+				if (a.x0 > b.x1 || b.x0 > a.x1 || a.y0 > b.y1 || b.y0 > a.y1) continue;
+				a.x0 = std::min(a.x0, b.x0); a.y0 = std::min(a.y0, b.y0);
+				a.x1 = std::max(a.x1, b.x1); a.y1 = std::max(a.y1, b.y1);
+				boxes->erase(boxes->begin() + j);
+				merged = true;
+			}
+		}
+	}
+}
+
+// The boxes around the identified markers of the last frame, expanded and merged where they overlap.
+static void getROIBoxes(arController *arc, std::vector<roi_box> *boxes) {
+	ARHandle *handle = arc->arhandle;
+	boxes->clear();
+	for (int i = 0; i < handle->marker_num; i++) {
+		const ARMarkerInfo *marker = &(handle->markerInfo[i]);
+		if (marker->id < 0) continue;
+		float x0 = 1e9f, y0 = 1e9f, x1 = -1e9f, y1 = -1e9f;
+		for (int j = 0; j < 4; j++) {
+			float ox, oy;
+			// The vertices are undistorted, the labeling works on the observed frame.
+			arParamIdeal2ObservLTf(&(arc->paramLT->paramLTf), (float)marker->vertex[j][0], (float)marker->vertex[j][1], &ox, &oy);
+			x0 = std::min(x0, ox); y0 = std::min(y0, oy);
+			x1 = std::max(x1, ox); y1 = std::max(y1, oy);
+		}
+		float margin = std::max((float)ROI_MARGIN_MIN, (float)ROI_MARGIN_RATIO * std::max(x1 - x0, y1 - y0));
+		roi_box box;
+		box.x0 = std::max(0, (int)(x0 - margin));
+		box.y0 = std::max(0, (int)(y0 - margin));
+		box.x1 = std::min(handle->xsize - 1, (int)(x1 + margin));
+		box.y1 = std::min(handle->ysize - 1, (int)(y1 + margin));
+		if (box.x1 <= box.x0 || box.y1 <= box.y0) continue;
+		boxes->push_back(box);
+	}
+	mergeROIBoxes(boxes);
+}
+
+static bool pattIndexActive(arController *arc) {
+	ARHandle *handle = arc->arhandle;
+	return arc->pattIndexEnabled && handle->pattHandle != NULL && handle->pattHandle->patt_num > 0
+		&& handle->arPatternDetectionMode != AR_MATRIX_CODE_DETECTION;
+}
+
+// arGetMarkerInfo() for one quad at a time, with the patterns arPattIndexShortlist() rules out deactivated.
+// The pattern of the quad is read twice, once for the index and once by arGetMarkerInfo(), which is cheap next
+// to correlating it with a large library. Returns the number of markers, -1 on error.
+static int getMarkerInfoIndexed(arController *arc, int marker2Num, int markerNum) {
+	ARHandle *handle = arc->arhandle;
+	ARPattHandle *pattHandle = handle->pattHandle;
+	int mode = handle->arPatternDetectionMode;
+	bool mono = mode == AR_TEMPLATE_MATCHING_MONO || mode == AR_TEMPLATE_MATCHING_MONO_AND_MATRIX;
+	if (arc->pattIndex.empty() || arc->pattIndexMode != mode) {
+		AR_TRACE_BEGIN("arPattIndexBuild");
+		arc->pattIndex.resize(arPattIndexSize(pattHandle));
+		int ret = arPattIndexBuild(pattHandle, mode, arc->pattIndex.data());
+		AR_TRACE_END("arPattIndexBuild");
+		if (ret < 0) return -1;
+		arc->pattIndexMode = mode;
+	}
+	arc->pattShortlist.resize(pattHandle->patt_num_max);
+	arc->pattImage.resize(pattHandle->pattSize * pattHandle->pattSize * 3);
+	if (arc->stats.pattShortlistNum < 0) arc->stats.pattShortlistNum = 0;
+
+	int found = 0;
+	for (int i = 0; i < marker2Num; i++) {
+		ARMarkerInfo2 *marker2 = &(handle->markerInfo2[i]);
+		ARdouble line[4][3], vertex[4][2];
+		int num = -1;
+		if (arGetLine(marker2->x_coord, marker2->y_coord, marker2->coord_num, marker2->vertex, &(arc->paramLT->paramLTf), line, vertex) == 0
+				&& arPattGetImage2(AR_IMAGE_PROC_FRAME_IMAGE, mono ? AR_TEMPLATE_MATCHING_MONO : AR_TEMPLATE_MATCHING_COLOR,
+				pattHandle->pattSize, pattHandle->pattSize * AR_PATT_SAMPLE_FACTOR1, arc->videoFrame, handle->xsize, handle->ysize,
+				handle->arPixelFormat, &(arc->paramLT->paramLTf), vertex, handle->pattRatio, arc->pattImage.data()) == 0) {
+			num = arPattIndexShortlist(pattHandle, arc->pattIndex.data(), arc->pattImage.data(), AR_CONFIDENCE_CUTOFF_DEFAULT,
+				arc->pattShortlist.data());
+		}
+		// Otherwise arGetMarkerInfo() rejects the quad by itself, or it is uniform and matches no pattern.
+		for (int k = 0; num >= 0 && k < pattHandle->patt_num_max; k++) {
+			if (pattHandle->pattf[k] == 1 && !arc->pattShortlist[k]) {
+				pattHandle->pattf[k] = 2;
+				arc->pattShortlist[k] = -1;
+			}
+		}
+		int n = 0;
+		int ret = arGetMarkerInfo(arc->videoFrame, handle->xsize, handle->ysize, handle->arPixelFormat, marker2, 1,
+			pattHandle, AR_IMAGE_PROC_FRAME_IMAGE, mode, &(arc->paramLT->paramLTf), handle->pattRatio,
+			handle->markerInfo + markerNum + found, &n, handle->matrixCodeType);
+		for (int k = 0; num >= 0 && k < pattHandle->patt_num_max; k++) {
+			if (arc->pattShortlist[k] < 0) pattHandle->pattf[k] = 1;
+		}
+		if (ret < 0) return -1;
+		arc->stats.pattShortlistNum += num >= 0 ? num : pattHandle->patt_num;
+		found += n;
+	}
+	return found;
+}
+
+// The pattern or matrix code of the quads of handle->markerInfo2, into handle->markerInfo from markerNum on, with
+// the confidence cutoff of arDetectMarker(). Returns the number of markers, -1 on error.
+static int getMarkerInfo(arController *arc, int marker2Num, int markerNum) {
+	ARHandle *handle = arc->arhandle;
+	int found = 0;
+	if (pattIndexActive(arc)) {
+		if ((found = getMarkerInfoIndexed(arc, marker2Num, markerNum)) < 0) return -1;
+	} else if (arGetMarkerInfo(arc->videoFrame, handle->xsize, handle->ysize, handle->arPixelFormat, handle->markerInfo2, marker2Num,
+			handle->pattHandle, AR_IMAGE_PROC_FRAME_IMAGE, handle->arPatternDetectionMode, &(arc->paramLT->paramLTf),
+			handle->pattRatio, handle->markerInfo + markerNum, &found, handle->matrixCodeType) < 0) return -1;
+	for (int i = markerNum; i < markerNum + found; i++) {
+		ARMarkerInfo *marker = &(handle->markerInfo[i]);
+		if (marker->id >= 0 && marker->cf < AR_CONFIDENCE_CUTOFF_DEFAULT) {
+			marker->id = -1;
+			marker->cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_MATCH_CONFIDENCE;
+		}
+	}
+	return found;
+}
+
+// The labeling, contour and marker extraction of arDetectMarker() in each box, with the current threshold.
+// Unlike arDetectMarker(), markers are not kept from the previous frames (tracking history).
+// Returns the number of boxes, -1 on error.
+static int detectMarkerInBoxes(arController *arc, const std::vector<roi_box> &boxes) {
+	ARHandle *handle = arc->arhandle;
+	int labelNum = 0, marker2Num = 0, markerNum = 0;
+	for (size_t b = 0; b < boxes.size(); b++) {
+		const roi_box &box = boxes[b];
+		int w = box.x1 - box.x0 + 1, h = box.y1 - box.y0 + 1;
+		arc->roiLuma.resize(w * h);
+		for (int y = 0; y < h; y++) {
+			memcpy(&(arc->roiLuma[y * w]), arc->videoLuma + (box.y0 + y) * handle->xsize + box.x0, w);
+		}
+
+		// The label image of the handle has the size of the frame, enough for any box.
+		if (arLabelingMT(arc->roiLuma.data(), w, h, AR_DEBUG_DISABLE, handle->arLabelingMode, handle->arLabelingThresh,
+				AR_IMAGE_PROC_FRAME_IMAGE, &(handle->labelInfo), NULL, arc->labelingMTHandle) < 0) return -1;
+		labelNum += handle->labelInfo.label_num;
+		int marker2Count = 0;
+		if (arDetectMarker2(w, h, &(handle->labelInfo), AR_IMAGE_PROC_FRAME_IMAGE, AR_AREA_MAX, AR_AREA_MIN,
+				AR_SQUARE_FIT_THRESH, handle->markerInfo2, &marker2Count) < 0) return -1;
+		marker2Num += marker2Count;
+		marker2Count = std::min(marker2Count, AR_SQUARE_MAX - markerNum);
+		for (int i = 0; i < marker2Count; i++) {
+			ARMarkerInfo2 *marker2 = &(handle->markerInfo2[i]);
+			marker2->pos[0] += box.x0;
+			marker2->pos[1] += box.y0;
+			for (int j = 0; j < marker2->coord_num; j++) {
+				marker2->x_coord[j] += box.x0;
+				marker2->y_coord[j] += box.y0;
+			}
+		}
+
+		int found = getMarkerInfo(arc, marker2Count, markerNum);
+		if (found < 0) return -1;
+		for (int i = markerNum; i < markerNum + found; i++) {
+			handle->markerInfo[i].markerInfo2Ptr = NULL; // markerInfo2 is reused by the next box.
+		}
+		markerNum += found;
+	}
+
+	handle->labelInfo.label_num = labelNum;
+	handle->marker2_num = marker2Num;
+	handle->marker_num = markerNum;
+	return boxes.size();
+}
+
+// Looks for the markers of the last frame around them, with the threshold of the last full scan. A marker lost
+// leads to a full scan.
+static int detectMarkerROI(arController *arc) {
+	std::vector<roi_box> boxes;
+	getROIBoxes(arc, &boxes);
+	return detectMarkerInBoxes(arc, boxes);
+}
+
+static bool coarseDetectionPossible(arController *arc) {
+	ARHandle *handle = arc->arhandle;
+	if (arc->coarseFactor <= 1) return false;
+	if (handle->arDebug != AR_DEBUG_DISABLE || handle->arImageProcMode != AR_IMAGE_PROC_FRAME_IMAGE) return false;
+	// Only the median and Otsu thresholds are computed on the downscaled luma.
+	return handle->arLabelingThreshMode != AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE &&
+		handle->arLabelingThreshMode != AR_LABELING_THRESH_MODE_AUTO_BRACKETING;
+}
+
+// The median or Otsu threshold of the auto threshold modes, from a histogram of count pixels.
+static int histogramThreshold(const unsigned int hist[256], unsigned int count, AR_LABELING_THRESH_MODE mode) {
+	if (mode == AR_LABELING_THRESH_MODE_AUTO_MEDIAN) {
+		unsigned int below = 0;
+		for (int v = 0; v < 256; v++) {
+			below += hist[v];
+			if (below * 2 >= count) return v;
+		}
+		return 255;
+	}
+	double sum = 0;
+	for (int v = 0; v < 256; v++) sum += (double)v * hist[v];
+	double sumBelow = 0, best = -1;
+	unsigned int below = 0;
+	int thresh = 0;
+	for (int v = 0; v < 256; v++) {
+		below += hist[v];
+		if (below == 0) continue;
+		if (below == count) break;
+		sumBelow += (double)v * hist[v];
+		double above = (double)(count - below);
+		double meanBelow = sumBelow / below, meanAbove = (sum - sumBelow) / above;
+		double variance = (double)below * above * (meanBelow - meanAbove) * (meanBelow - meanAbove);
+		if (variance > best) {
+			best = variance;
+			thresh = v;
+		}
+	}
+	return thresh;
+}
+
+static int coarseThreshold(const std::vector<ARUint8> &luma, AR_LABELING_THRESH_MODE mode) {
+	unsigned int hist[256] = {0};
+	for (size_t i = 0; i < luma.size(); i++) hist[luma[i]]++;
+	return histogramThreshold(hist, luma.size(), mode);
+}
+
+static bool thresholdEstimationActive(arController *arc) {
+	AR_LABELING_THRESH_MODE mode = arc->arhandle->arLabelingThreshMode;
+	return arc->threshSampleStep > 0 &&
+		(mode == AR_LABELING_THRESH_MODE_AUTO_MEDIAN || mode == AR_LABELING_THRESH_MODE_AUTO_OTSU);
+}
+
+// Brightness of the frame, from the pixels of a grid of the given step.
+static double sampledMean(const ARUint8 *luma, int xsize, int ysize, int step) {
+	unsigned long long sum = 0;
+	unsigned int count = 0;
+	for (int y = step / 2; y < ysize; y += step) {
+		const ARUint8 *row = luma + y * xsize;
+		for (int x = step / 2; x < xsize; x += step, count++) sum += row[x];
+	}
+	return count ? (double)sum / count : 0;
+}
+
+// The median or Otsu threshold from the histogram of a grid of pixels, recomputed every threshInterval frames or
+// as soon as the brightness shifts by more than threshMaxShift, and smoothed over the updates. arDetectMarker()
+// keeps the threshold set here: its own auto threshold interval never runs out.
+static void estimateThreshold(arController *arc) {
+	ARHandle *handle = arc->arhandle;
+	int step = arc->threshSampleStep;
+	// The brightness is checked every frame on a 4 times sparser grid.
+	double mean = sampledMean(arc->videoLuma, handle->xsize, handle->ysize, step * 4);
+	bool shifted = arc->threshSmoothed >= 0 && arc->threshMaxShift > 0 && std::fabs(mean - arc->threshMean) > arc->threshMaxShift;
+	if (arc->threshSmoothed < 0 || shifted || ++arc->threshFramesSinceUpdate >= arc->threshInterval) {
+		unsigned int hist[256] = {0};
+		unsigned int count = 0;
+		for (int y = step / 2; y < handle->ysize; y += step) {
+			const ARUint8 *row = arc->videoLuma + y * handle->xsize;
+			for (int x = step / 2; x < handle->xsize; x += step, count++) hist[row[x]]++;
+		}
+		int thresh = histogramThreshold(hist, count, handle->arLabelingThreshMode);
+		// A lighting change is followed at once, the noise of the estimates is smoothed.
+		if (arc->threshSmoothed < 0 || shifted) arc->threshSmoothed = thresh;
+		else arc->threshSmoothed = arc->threshSmoothing * arc->threshSmoothed + (1.0 - arc->threshSmoothing) * thresh;
+		arc->threshMean = mean;
+		arc->threshFramesSinceUpdate = 0;
+	}
+	handle->arLabelingThresh = (int)(arc->threshSmoothed + 0.5);
+	handle->arLabelingThreshAutoIntervalTTL = 1;
+}
+
+// Labels the luma downscaled by coarseFactor, then extracts the markers from the full resolution luma in boxes
+// around the quads found, so that the corners have the accuracy of a full resolution detection. Markers smaller
+// than about coarseFactor * 8 pixels are missed. Returns the number of boxes, -1 on error.
+static int detectMarkerCoarse(arController *arc) {
+	ARHandle *handle = arc->arhandle;
+	int f = arc->coarseFactor;
+	int w = handle->xsize / f, h = handle->ysize / f;
+	int shift = f == 2 ? 2 : 4;
+
+	arc->coarseLuma.resize(w * h);
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			const ARUint8 *p = arc->videoLuma + (y * f) * handle->xsize + x * f;
+			int sum = 0;
+			for (int j = 0; j < f; j++, p += handle->xsize) {
+				for (int i = 0; i < f; i++) sum += p[i];
+			}
+			arc->coarseLuma[y * w + x] = (ARUint8)((sum + (1 << (shift - 1))) >> shift);
+		}
+	}
+	// Updated every arLabelingThreshAutoInterval frames, like arDetectMarker() does.
+	if (handle->arLabelingThreshMode != AR_LABELING_THRESH_MODE_MANUAL && !thresholdEstimationActive(arc)) {
+		if (handle->arLabelingThreshAutoIntervalTTL <= 0) {
+			handle->arLabelingThresh = coarseThreshold(arc->coarseLuma, handle->arLabelingThreshMode);
+			handle->arLabelingThreshAutoIntervalTTL = handle->arLabelingThreshAutoInterval;
+		} else {
+			handle->arLabelingThreshAutoIntervalTTL--;
+		}
+	}
+
+	if (arLabelingMT(arc->coarseLuma.data(), w, h, AR_DEBUG_DISABLE, handle->arLabelingMode, handle->arLabelingThresh,
+			AR_IMAGE_PROC_FRAME_IMAGE, &(handle->labelInfo), NULL, arc->labelingMTHandle) < 0) return -1;
+	int marker2Count = 0;
+	if (arDetectMarker2(w, h, &(handle->labelInfo), AR_IMAGE_PROC_FRAME_IMAGE, AR_AREA_MAX / (f * f), AR_AREA_MIN / (f * f),
+			AR_SQUARE_FIT_THRESH, handle->markerInfo2, &marker2Count) < 0) return -1;
+
+	// The contour found at full resolution can be up to f pixels outside of the coarse one.
+	std::vector<roi_box> boxes;
+	int margin = 2 * f + 2;
+	for (int i = 0; i < marker2Count; i++) {
+		const ARMarkerInfo2 *marker2 = &(handle->markerInfo2[i]);
+		int x0 = w, y0 = h, x1 = 0, y1 = 0;
+		for (int j = 0; j < marker2->coord_num; j++) {
+			x0 = std::min(x0, marker2->x_coord[j]); x1 = std::max(x1, marker2->x_coord[j]);
+			y0 = std::min(y0, marker2->y_coord[j]); y1 = std::max(y1, marker2->y_coord[j]);
+		}
+		roi_box box;
+		box.x0 = std::max(0, x0 * f - margin);
+		box.y0 = std::max(0, y0 * f - margin);
+		box.x1 = std::min(handle->xsize - 1, (x1 + 1) * f + margin);
+		box.y1 = std::min(handle->ysize - 1, (y1 + 1) * f + margin);
+		boxes.push_back(box);
+	}
+	mergeROIBoxes(&boxes);
+	return detectMarkerInBoxes(arc, boxes);
+}
+
+// The adaptive threshold mode takes detectMarkerFrame() only once the fast adaptive threshold is enabled, the others
+// only to label with several threads or match the patterns with the index.
+static bool detectMarkerFramePossible(arController *arc) {
+	ARHandle *handle = arc->arhandle;
+	if (handle->arDebug != AR_DEBUG_DISABLE || handle->arImageProcMode != AR_IMAGE_PROC_FRAME_IMAGE) return false;
+	bool needed = arc->labelingThreadNum > 1 || pattIndexActive(arc);
+	switch (handle->arLabelingThreshMode) {
+		case AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE: return arc->fastAdaptiveEnabled;
+		case AR_LABELING_THRESH_MODE_MANUAL: return needed;
+		case AR_LABELING_THRESH_MODE_AUTO_MEDIAN:
+		case AR_LABELING_THRESH_MODE_AUTO_OTSU: return needed && handle->arImageProcInfo != NULL;
+		default: return false;
+	}
+}
+
+// arDetectMarker() with the labeling split across labelingThreadNum threads by arLabelingMT(), the auto median
+// and Otsu thresholds updated like arDetectMarker() does, and the adaptive threshold of arThreshAdaptiveBinarize().
+// Like detectMarkerInBoxes(), without tracking history. Returns 0, -1 on error.
+static int detectMarkerFrame(arController *arc) {
+	ARHandle *handle = arc->arhandle;
+	ARUint8 *luma = arc->videoLuma;
+	int thresh = handle->arLabelingThresh;
+	if (handle->arLabelingThreshMode == AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE) {
+		arc->adaptiveBw.resize(handle->xsize * handle->ysize);
+		arc->adaptiveWork.resize(arThreshAdaptiveWorkSize(handle->xsize, AR_LABELING_THRESH_ADAPTIVE_KERNEL_SIZE_DEFAULT));
+		AR_TRACE_BEGIN("arThreshAdaptiveBinarize");
+		int ret = arThreshAdaptiveBinarize(luma, handle->xsize, handle->ysize, AR_LABELING_THRESH_ADAPTIVE_KERNEL_SIZE_DEFAULT,
+			AR_LABELING_THRESH_ADAPTIVE_BIAS_DEFAULT, arc->adaptiveBw.data(), arc->adaptiveWork.data());
+		AR_TRACE_END("arThreshAdaptiveBinarize");
+		if (ret < 0) return -1;
+		luma = arc->adaptiveBw.data();
+		thresh = AR_THRESH_ADAPTIVE_LABELING_THRESH;
+	} else if (handle->arLabelingThreshMode != AR_LABELING_THRESH_MODE_MANUAL) {
+		if (handle->arLabelingThreshAutoIntervalTTL <= 0) {
+			unsigned char value;
+			int ret;
+			if (handle->arLabelingThreshMode == AR_LABELING_THRESH_MODE_AUTO_MEDIAN) {
+				ret = arImageProcLumaHistAndCDFAndMedian(handle->arImageProcInfo, arc->videoLuma, &value);
+			} else {
+				ret = arImageProcLumaHistAndOtsu(handle->arImageProcInfo, arc->videoLuma, &value);
+			}
+			if (ret < 0) return -1;
+			handle->arLabelingThresh = thresh = value;
+			handle->arLabelingThreshAutoIntervalTTL = handle->arLabelingThreshAutoInterval;
+		} else {
+			handle->arLabelingThreshAutoIntervalTTL--;
+		}
+	}
+
+	if (arLabelingMT(luma, handle->xsize, handle->ysize, AR_DEBUG_DISABLE, handle->arLabelingMode, thresh,
+			AR_IMAGE_PROC_FRAME_IMAGE, &(handle->labelInfo), NULL, arc->labelingMTHandle) < 0) return -1;
+	if (arDetectMarker2(handle->xsize, handle->ysize, &(handle->labelInfo), AR_IMAGE_PROC_FRAME_IMAGE, AR_AREA_MAX, AR_AREA_MIN,
+			AR_SQUARE_FIT_THRESH, handle->markerInfo2, &(handle->marker2_num)) < 0) return -1;
+	int found = getMarkerInfo(arc, handle->marker2_num, 0);
+	if (found < 0) return -1;
+	handle->marker_num = found;
+	return 0;
+}
+
+// Markers identified in the last frame can be tracked, until they are to be detected again.
+static bool cornerTrackingPossible(arController *arc) {
+	ARHandle *handle = arc->arhandle;
+	if (arc->cornerTrackInterval <= 0 || arc->cornerTrackFrames + 1 >= arc->cornerTrackInterval) return false;
+	if (!arc->trackPyramidValid || handle->arDebug != AR_DEBUG_DISABLE || handle->arImageProcMode != AR_IMAGE_PROC_FRAME_IMAGE) return false;
+	for (int i = 0; i < handle->marker_num; i++) {
+		if (handle->markerInfo[i].id >= 0) return true;
+	}
+	return false;
+}
+
+static float quadArea(const float v[4][2]) {
+	float area = 0;
+	for (int j = 0; j < 4; j++) area += v[j][0] * v[(j + 1) % 4][1] - v[(j + 1) % 4][0] * v[j][1];
+	return 0.5f * area;
+}
+
+static bool quadConvex(const float v[4][2]) {
+	int sign = 0;
+	for (int j = 0; j < 4; j++) {
+		const float *a = v[j], *b = v[(j + 1) % 4], *c = v[(j + 2) % 4];
+		float cross = (b[0] - a[0]) * (c[1] - b[1]) - (b[1] - a[1]) * (c[0] - b[0]);
+		int s = cross > 0 ? 1 : (cross < 0 ? -1 : 0);
+		if (s == 0 || (sign != 0 && s != sign)) return false;
+		sign = s;
+	}
+	return true;
+}
+
+// Moves the corners of the markers identified in the last frame to where arCornerTrack() finds them in this one,
+// keeping their id, direction and confidence; the unidentified quads are dropped. The lines are those through the
+// corners and the center follows their mean motion. Returns the number of markers, -1 if a marker is lost or its
+// quad degenerates.
+static int trackMarkerCorners(arController *arc) {
+	ARHandle *handle = arc->arhandle;
+	ARParamLTf *paramLTf = &(arc->paramLT->paramLTf);
+	std::vector<ARMarkerInfo> markers;
+	for (int i = 0; i < handle->marker_num; i++) {
+		ARMarkerInfo marker = handle->markerInfo[i];
+		if (marker.id < 0) continue;
+		float prev[4][2], cur[4][2];
+		for (int j = 0; j < 4; j++) {
+			if (arParamIdeal2ObservLTf(paramLTf, (float)marker.vertex[j][0], (float)marker.vertex[j][1], &prev[j][0], &prev[j][1]) < 0) return -1;
+			cur[j][0] = prev[j][0];
+			cur[j][1] = prev[j][1];
+			if (arCornerTrack(arc->trackPyramid.data(), arc->trackPyramidNext.data(), handle->xsize, handle->ysize, prev[j], cur[j]) < 0) return -1;
+		}
+		float ratio = quadArea(cur) / quadArea(prev);
+		if (!quadConvex(cur) || ratio < 0.5f || ratio > 2.0f) return -1;
+
+		ARdouble shiftX = 0, shiftY = 0;
+		for (int j = 0; j < 4; j++) {
+			float x, y;
+			if (arParamObserv2IdealLTf(paramLTf, cur[j][0], cur[j][1], &x, &y) < 0) return -1;
+			shiftX += (x - marker.vertex[j][0]) / 4;
+			shiftY += (y - marker.vertex[j][1]) / 4;
+			marker.vertex[j][0] = x;
+			marker.vertex[j][1] = y;
+		}
+		for (int j = 0; j < 4; j++) {
+			const ARdouble *a = marker.vertex[j], *b = marker.vertex[(j + 1) % 4];
+			ARdouble dx = b[0] - a[0], dy = b[1] - a[1], len = std::sqrt(dx * dx + dy * dy);
+			marker.line[j][0] = dy / len;
+			marker.line[j][1] = -dx / len;
+			marker.line[j][2] = -(marker.line[j][0] * a[0] + marker.line[j][1] * a[1]);
+		}
+		marker.pos[0] += shiftX;
+		marker.pos[1] += shiftY;
+		marker.area = (int)(marker.area * ratio);
+		marker.markerInfo2Ptr = NULL;
+		markers.push_back(marker);
+	}
+	std::copy(markers.begin(), markers.end(), handle->markerInfo);
+	handle->marker_num = markers.size();
+	handle->marker2_num = 0;
+	handle->labelInfo.label_num = 0;
+	return handle->marker_num;
+}
+
+// The markers of interest of the next frame: those identified in this one.
+static bool updateROIMarkers(arController *arc, bool roiFrame) {
+	std::vector<int> ids;
+	ARHandle *handle = arc->arhandle;
+	for (int i = 0; i < handle->marker_num; i++) {
+		if (handle->markerInfo[i].id >= 0) ids.push_back(handle->markerInfo[i].id);
+	}
+	std::sort(ids.begin(), ids.end());
+	bool lost = roiFrame && !std::includes(ids.begin(), ids.end(), arc->roiMarkerIds.begin(), arc->roiMarkerIds.end());
+	arc->roiMarkerIds = ids;
+	return !lost;
+}
+
 extern "C" {
 
+#ifdef HAVE_NFT
+	static void resetNFTTracking(NFTTrackingResult *tracking) {
+		memset(tracking, 0, sizeof(*tracking));
+		tracking->markerIndex = -1;
+		tracking->error = -1;
+		tracking->blurLevel = -1;
+		for (int i = 0; i < 5; i++) tracking->icpErr[i] = -1;
+	}
+
 	/**
 		NFT API bindings
 	*/
@@ -108,6 +802,24 @@ extern "C" {
 
 		if (arc->detectedPage == markerIndex) {
 			int trackResult = ar2TrackingMod(arc->ar2Handle, arc->surfaceSet[arc->detectedPage], arc->videoFrame, trans, &err);
+			const AR2TrackingModStatsT *trackingStats = ar2TrackingModGetStats(arc->ar2Handle);
+			arc->stats.ar2CandidateMs = trackingStats->candidateMs;
+			arc->stats.ar2TemplateMs = trackingStats->templateMs;
+			arc->stats.ar2IcpMs = trackingStats->icpMs;
+			arc->stats.ar2CandidateNum = trackingStats->candidateNum;
+			arc->stats.ar2TrackedFeatureNum = trackingStats->trackedNum;
+			arc->stats.ar2IcpLevel = trackingStats->icpLevel;
+
+			NFTTrackingResult *tracking = &(arc->nftTracking);
+			tracking->markerIndex = markerIndex;
+			tracking->result = trackResult;
+			tracking->error = err;
+			tracking->candidateNum = trackingStats->candidateNum;
+			tracking->trackedNum = trackingStats->trackedNum;
+			tracking->simAverage = trackingStats->simAverage;
+			tracking->blurLevel = trackingStats->blurLevel;
+			tracking->icpLevel = trackingStats->icpLevel;
+			memcpy(tracking->icpErr, trackingStats->icpErr, sizeof(tracking->icpErr));
 			if( trackResult < 0 ) {
 				ARLOGi("Tracking lost. %d\n", trackResult);
 				arc->detectedPage = -2;
@@ -116,85 +828,22 @@ extern "C" {
 			}
         }
 
+		NFTMarkerResult result;
+		result.id = markerIndex;
 		if (arc->detectedPage == markerIndex) {
-			EM_ASM_({
-				var $a = arguments;
-				var i = 0;
-				if (!artoolkit["NFTMarkerInfo"]) {
-					artoolkit["NFTMarkerInfo"] = ({
-						id: 0,
-						error: -1,
-						found: 0,
-						pose: [0,0,0,0, 0,0,0,0, 0,0,0,0]
-					});
-				}
-				var markerInfo = artoolkit["NFTMarkerInfo"];
-				markerInfo["id"] = $a[i++];
-				markerInfo["error"] = $a[i++];
-				markerInfo["found"] = 1;
-				markerInfo["pose"][0] = $a[i++];
-				markerInfo["pose"][1] = $a[i++];
-				markerInfo["pose"][2] = $a[i++];
-				markerInfo["pose"][3] = $a[i++];
-				markerInfo["pose"][4] = $a[i++];
-				markerInfo["pose"][5] = $a[i++];
-				markerInfo["pose"][6] = $a[i++];
-				markerInfo["pose"][7] = $a[i++];
-				markerInfo["pose"][8] = $a[i++];
-				markerInfo["pose"][9] = $a[i++];
-				markerInfo["pose"][10] = $a[i++];
-				markerInfo["pose"][11] = $a[i++];
-			},
-				markerIndex,
-				err,
-
-				trans[0][0],
-				trans[0][1],
-				trans[0][2],
-				trans[0][3],
-
-				trans[1][0],
-				trans[1][1],
-				trans[1][2],
-				trans[1][3],
-
-				trans[2][0],
-				trans[2][1],
-				trans[2][2],
-				trans[2][3]
-            );
-        } else {
-			EM_ASM_({
-				var $a = arguments;
-				var i = 0;
-				if (!artoolkit["NFTMarkerInfo"]) {
-					artoolkit["NFTMarkerInfo"] = ({
-						id: 0,
-						error: -1,
-						found: 0,
-						pose: [0,0,0,0, 0,0,0,0, 0,0,0,0]
-					});
+			result.found = 1;
+			result.error = err;
+			for (int j = 0; j < 3; j++) {
+				for (int k = 0; k < 4; k++) {
+					result.pose[j * 4 + k] = trans[j][k];
 				}
-				var markerInfo = artoolkit["NFTMarkerInfo"];
-				markerInfo["id"] = $a[i++];
-				markerInfo["error"] = -1;
-				markerInfo["found"] = 0;
-				markerInfo["pose"][0] = 0;
-				markerInfo["pose"][1] = 0;
-				markerInfo["pose"][2] = 0;
-				markerInfo["pose"][3] = 0;
-				markerInfo["pose"][4] = 0;
-				markerInfo["pose"][5] = 0;
-				markerInfo["pose"][6] = 0;
-				markerInfo["pose"][7] = 0;
-				markerInfo["pose"][8] = 0;
-				markerInfo["pose"][9] = 0;
-				markerInfo["pose"][10] = 0;
-				markerInfo["pose"][11] = 0;
-			},
-				markerIndex
-			);
-        }
+			}
+		} else {
+			result.found = 0;
+			result.error = -1;
+			memset(result.pose, 0, sizeof(result.pose));
+		}
+		emitNFTMarkerResult(&result);
         return 0;
     }
 
@@ -205,9 +854,19 @@ extern "C" {
 		KpmResult *kpmResult = NULL;
 		int kpmResultNum = -1;
 
+		FrameStatsResult *stats = &(arc->stats);
+		stats->kpmMs = 0;
+		stats->ar2CandidateMs = stats->ar2TemplateMs = stats->ar2IcpMs = 0;
+		stats->ar2CandidateNum = stats->ar2TrackedFeatureNum = stats->ar2IcpLevel = 0;
+		resetNFTTracking(&(arc->nftTracking));
+
 		if (arc->detectedPage == -2) {
+			double t0 = nowMs();
+            AR_TRACE_BEGIN("kpmMatching");
             kpmMatching( arc->kpmHandle, arc->videoLuma );
+            AR_TRACE_END("kpmMatching");
             kpmGetResult( arc->kpmHandle, &kpmResult, &kpmResultNum );
+			stats->kpmMs = nowMs() - t0;
 
 			for(int i = 0; i < kpmResultNum; i++ ) {
 				if (kpmResult[i].camPoseF == 0 ) {
@@ -223,9 +882,49 @@ extern "C" {
                 }
             }
         }
+		stats->kpmResultNum = kpmResultNum;
 		return kpmResultNum;
 	}
 
+	/**
+		Emits the tracking quality of the NFT marker tracked in the last frame (artoolkit.NFTTrackingInfo),
+		with markerIndex -1 if none was tracked.
+	*/
+	int getNFTTrackingInfo(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		NFTTrackingResult *tracking = &(arc->nftTracking);
+		if (arc->ar2Handle != NULL) {
+			tracking->searchFeatureNum = arc->ar2Handle->searchFeatureNum;
+			tracking->simThresh = arc->ar2Handle->simThresh;
+			tracking->trackingThresh = arc->ar2Handle->trackingThresh;
+		}
+		emitNFTTrackingResult(tracking);
+		return 0;
+	}
+
+	/**
+		Sets the number of features AR2 matches per frame, capped by the memory plan's maxSearchFeatureNum.
+		Fewer features are faster, more are more robust.
+	*/
+	int setNFTSearchFeatureNum(int id, int num) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+		if (arc->ar2Handle == NULL) { return -1; }
+
+		if (num > arc->maxSearchFeatureNum) num = arc->maxSearchFeatureNum;
+		return ar2SetSearchFeatureNum(arc->ar2Handle, num);
+	}
+
+	int getNFTSearchFeatureNum(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+		if (arc->ar2Handle == NULL) { return -1; }
+
+		return arc->ar2Handle->searchFeatureNum;
+	}
+
 	KpmHandle *createKpmHandle(ARParamLT *cparamLT) {
 		KpmHandle *kpmHandle;
 	    kpmHandle = kpmCreateHandle(cparamLT);
@@ -249,22 +948,28 @@ extern "C" {
 		arController *arc = &(arControllers[id]);
 		//arc->pixFormat = arVideoGetPixelFormat();
 
-		if ((arc->ar2Handle = ar2CreateHandleMod(arc->paramLT, arc->pixFormat)) == NULL) {
+		// A controller recycled from the pool already has its AR2 handle.
+		if (arc->ar2Handle == NULL && (arc->ar2Handle = ar2CreateHandleMod(arc->paramLT, arc->pixFormat)) == NULL) {
 			ARLOGe("Error: ar2CreateHandle.\n");
 			kpmDeleteHandle(&arc->kpmHandle);
+			return -1;
 		}
 		// Settings for devices with single-core CPUs.
 		ar2SetTrackingThresh(arc->ar2Handle, 5.0);
 		ar2SetSimThresh(arc->ar2Handle, 0.50);
-		ar2SetSearchFeatureNum(arc->ar2Handle, 16);
+		ar2SetSearchFeatureNum(arc->ar2Handle, 16 < arc->maxSearchFeatureNum ? 16 : arc->maxSearchFeatureNum);
 		ar2SetSearchSize(arc->ar2Handle, 6);
 		ar2SetTemplateSize1(arc->ar2Handle, 6);
 		ar2SetTemplateSize2(arc->ar2Handle, 6);
 
-		arc->kpmHandle = createKpmHandle(arc->paramLT);
+		if (arc->kpmHandle == NULL) {
+			arc->kpmHandle = createKpmHandle(arc->paramLT);
+		}
+		resetNFTTracking(&(arc->nftTracking));
 
 		return 0;
 	}
+#endif // HAVE_NFT
 
 	/***************
 	 * Set Log Level
@@ -277,6 +982,32 @@ extern "C" {
 		return arLogLevel;
 	}
 
+	/**
+		Trace spans of the pipeline stages, see ARTrace.h. The spans are global to the module, not per controller.
+	*/
+	void setTraceEnabled(int enable) {
+		arTraceSetEnabled(enable);
+	}
+
+	int getTraceEnabled() {
+		return arTraceEnabled;
+	}
+
+	void clearTrace() {
+		arTraceClear();
+	}
+
+	/**
+		Returns the spans recorded since the last clearTrace() as a Chrome trace JSON object, with pid as process id.
+	*/
+	std::string getTrace(int pid) {
+		char *json = arTraceDump(pid);
+		if (json == NULL) return std::string();
+		std::string trace(json);
+		free(json);
+		return trace;
+	}
+
 	/***********
 	* Teardown *
 	***********/
@@ -291,40 +1022,207 @@ extern "C" {
 			ar3DDeleteHandle(&(arc->ar3DHandle));
 			arc->ar3DHandle = NULL;
 		}
+#ifdef HAVE_NFT
+		if (arc->kpmHandle != NULL) {
+			kpmDeleteHandle(&(arc->kpmHandle));
+			arc->kpmHandle = NULL;
+		}
+		if (arc->ar2Handle != NULL) {
+			ar2DeleteHandleMod(&(arc->ar2Handle));
+			arc->ar2Handle = NULL;
+		}
+#endif
 		if (arc->paramLT != NULL) {
-			arParamLTFree(&(arc->paramLT));
+			releaseParamLT(&(arc->paramLT));
 			arc->paramLT = NULL;
 		}
 	}
 
-	int teardown(int id) {
-		if (arControllers.find(id) == arControllers.end()) { return -1; }
-		arController *arc = &(arControllers[id]);
+	static void freePooledController(pooled_controller *pc) {
+		free(pc->videoFrame);
+		free(pc->videoLuma);
+		if (pc->arhandle != NULL) arDeleteHandle(pc->arhandle);
+		if (pc->ar3DHandle != NULL) ar3DDeleteHandle(&(pc->ar3DHandle));
+#ifdef HAVE_NFT
+		if (pc->ar2Handle != NULL) ar2DeleteHandleMod(&(pc->ar2Handle));
+#endif
+		if (pc->paramLT != NULL) releaseParamLT(&(pc->paramLT));
+	}
 
-        //TODO: Fix Cleanup luma.
-        // if(arc->videoLuma) {
-        //     free(arc->videoLuma);
-        //     arc->videoLuma = NULL;
-        // }
+	/**
+		Frees everything the controller owns except the frame buffers and the
+		size-dependent handles, which are moved to the pool while it has room.
+	*/
+	static void releaseController(arController *arc) {
+#ifdef HAVE_NFT
+		for (int i = 0; i < PAGES_MAX; i++) {
+			if (arc->surfaceSet[i] != NULL) {
+				ar2FreeSurfaceSet(&(arc->surfaceSet[i]));
+				arc->surfaceSet[i] = NULL;
+			}
+		}
+		arc->surfaceSetCount = 0;
+		arc->surfaceSets.clear();
+		if (arc->kpmRefDataSet != NULL) {
+			kpmDeleteRefDataSet(&(arc->kpmRefDataSet));
+		}
+		if (arc->kpmHandle != NULL) {
+			// Holds the reference data of this controller's NFT markers, so it is not reusable.
+			kpmDeleteHandle(&(arc->kpmHandle));
+		}
+#endif
 
-		if (arc->videoFrame) {
-			free(arc->videoFrame);
-			arc->videoFrame = NULL;
-			arc->videoFrameSize = 0;
+		for (size_t i = 0; i < arc->multi_markers.size(); i++) {
+			arMultiFreeConfig(arc->multi_markers[i].multiMarkerHandle);
 		}
+		arc->multi_markers.clear();
+		arc->multiIndexValid = false;
 
-		deleteHandle(arc);
+		if (arc->labelingMTHandle != NULL) arLabelingMTDeleteHandle(&(arc->labelingMTHandle));
+		arc->labelingThreadNum = 1;
 
-		arPattDeleteHandle(arc->arPattHandle);
+		for (auto &pose : arc->squarePoses) {
+			if (pose.second.filter != NULL) arFilterTransMatFinal(pose.second.filter);
+		}
+		arc->squarePoses.clear();
+		arc->arMultiMarkerHandle = NULL;
 
-		arControllers.erase(id);
+		if (arc->arhandle != NULL) {
+			arPattDetach(arc->arhandle);
+		}
+		if (arc->arPattHandle != NULL) {
+			arPattDeleteHandle(arc->arPattHandle);
+			arc->arPattHandle = NULL;
+		}
 
-		for (int i=0; i<arc->multi_markers.size(); i++) {
-			arMultiFreeConfig(arc->multi_markers[i].multiMarkerHandle);
+		pooled_controller pc;
+		pc.width = arc->width;
+		pc.height = arc->height;
+		pc.videoFrame = arc->videoFrame;
+		pc.videoFrameSize = arc->videoFrameSize;
+		pc.videoLuma = arc->videoLuma;
+		pc.frameCapacity = arc->frameCapacity;
+		pc.param = arc->param;
+		pc.paramLT = arc->paramLT;
+		pc.arhandle = arc->arhandle;
+		pc.ar3DHandle = arc->ar3DHandle;
+		pc.ar2Handle = arc->ar2Handle;
+#ifdef HAVE_NFT
+		if (pc.ar2Handle != NULL) {
+			ar2ResetHandleMod(pc.ar2Handle);
 		}
+#endif
+
+		arc->videoFrame = NULL;
+		arc->videoFrameSize = 0;
+		arc->videoLuma = NULL;
+		arc->frameCapacity = 0;
+		arc->paramLT = NULL;
+		arc->arhandle = NULL;
+		arc->ar3DHandle = NULL;
+		arc->ar2Handle = NULL;
+
+		if (controllerPool.size() < CONTROLLER_POOL_MAX) {
+			controllerPool.push_back(pc);
+		} else {
+			freePooledController(&pc);
+		}
+	}
+
+	/**
+		Sets everything the arSet*() functions set on a marker handle, and the state of the auto threshold, which
+		they reset, to those of from, or with from NULL to the values arCreateHandle() starts with. The tracking
+		history and the pixel format are left to the caller.
+	*/
+	static void copyHandleSettings(const ARHandle *from, ARHandle *to) {
+		arSetDebugMode(to, from ? from->arDebug : AR_DEFAULT_DEBUG_MODE);
+		arSetLabelingMode(to, from ? from->arLabelingMode : AR_DEFAULT_LABELING_MODE);
+		arSetImageProcMode(to, from ? from->arImageProcMode : AR_DEFAULT_IMAGE_PROC_MODE);
+		arSetPatternDetectionMode(to, from ? from->arPatternDetectionMode : AR_DEFAULT_PATTERN_DETECTION_MODE);
+		arSetMarkerExtractionMode(to, from ? from->arMarkerExtractionMode : AR_DEFAULT_MARKER_EXTRACTION_MODE);
+		arSetPattRatio(to, from ? from->pattRatio : AR_PATT_RATIO);
+		arSetMatrixCodeType(to, from ? from->matrixCodeType : AR_MATRIX_CODE_TYPE_DEFAULT);
+		arSetLabelingThreshMode(to, from ? from->arLabelingThreshMode : AR_LABELING_THRESH_MODE_DEFAULT);
+		arSetLabelingThreshModeAutoInterval(to, from ? from->arLabelingThreshAutoInterval : AR_LABELING_THRESH_AUTO_INTERVAL_DEFAULT);
+		arSetLabelingThresh(to, from ? from->arLabelingThresh : AR_DEFAULT_LABELING_THRESH);
+		to->arLabelingThreshAutoIntervalTTL = from ? from->arLabelingThreshAutoIntervalTTL : 0;
+		to->arLabelingThreshAutoBracketOver = from ? from->arLabelingThreshAutoBracketOver : 1;
+		to->arLabelingThreshAutoBracketUnder = from ? from->arLabelingThreshAutoBracketUnder : 1;
+	}
+
+	/**
+		Gives arc the frame buffers of a pooled controller of the same size, and its
+		handles too if they were built for the same camera parameters.
+		Returns true if the handles were taken over and setCamera() can be skipped.
+	*/
+	static bool adoptPooledController(arController *arc, const ARParam *param) {
+		for (size_t i = 0; i < controllerPool.size(); i++) {
+			pooled_controller pc = controllerPool[i];
+			if (pc.width != arc->width || pc.height != arc->height || pc.frameCapacity < arc->frameCapacity) continue;
+
+			controllerPool.erase(controllerPool.begin() + i);
+			arc->videoFrame = pc.videoFrame;
+			arc->videoFrameSize = pc.videoFrameSize;
+			arc->videoLuma = pc.videoLuma;
+			arc->frameCapacity = pc.frameCapacity;
+			pc.videoFrame = NULL;
+			pc.videoLuma = NULL;
+
+			if (param == NULL || pc.arhandle == NULL || pc.ar3DHandle == NULL || !paramEquals(&(pc.param), param)) {
+				freePooledController(&pc);
+				return false;
+			}
 
-		delete &arc->multi_markers;
-		delete arc;
+			arc->param = pc.param;
+			arc->paramLT = pc.paramLT;
+			arc->ar3DHandle = pc.ar3DHandle;
+			arc->ar2Handle = pc.ar2Handle;
+			arc->arhandle = pc.arhandle;
+
+			// Back to the values arCreateHandle() starts with.
+			ARHandle *handle = arc->arhandle;
+			copyHandleSettings(NULL, handle);
+			arSetPixelFormat(handle, arc->pixFormat);
+			handle->marker_num = 0;
+			handle->marker2_num = 0;
+			handle->history_num = 0;
+
+			arPattAttach(handle, arc->arPattHandle);
+			arglCameraFrustumRH(&((arc->paramLT)->param), arc->nearPlane, arc->farPlane, arc->cameraLens);
+#ifdef HAVE_NFT
+			arc->kpmHandle = createKpmHandle(arc->paramLT);
+#endif
+
+			return true;
+		}
+		return false;
+	}
+
+	/**
+		Frees the allocations kept from torn down controllers.
+	*/
+	void clearControllerPool() {
+		for (size_t i = 0; i < controllerPool.size(); i++) {
+			freePooledController(&(controllerPool[i]));
+		}
+		controllerPool.clear();
+	}
+
+	/**
+		Frees the cached lookup tables that no controller is using any more.
+	*/
+	void clearParamLTCache() {
+		trimParamLTCache(0);
+	}
+
+	int teardown(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return -1; }
+		arController *arc = &(arControllers[id]);
+
+		releaseController(arc);
+
+		// arc points into the map entry, so this has to come last.
+		arControllers.erase(id);
 
 		return 0;
 	}
@@ -353,6 +1251,7 @@ extern "C" {
 
 		if (cameraParams.find(cameraID) == cameraParams.end()) { return -1; }
 
+		arc->cameraID = cameraID;
 		arc->param = cameraParams[cameraID];
 
 		if (arc->param.xsize != arc->width || arc->param.ysize != arc->height) {
@@ -365,7 +1264,7 @@ extern "C" {
 
 		deleteHandle(arc);
 
-		if ((arc->paramLT = arParamLTCreate(&(arc->param), AR_PARAM_LT_DEFAULT_OFFSET)) == NULL) {
+		if ((arc->paramLT = acquireParamLT(&(arc->param), AR_PARAM_LT_DEFAULT_OFFSET)) == NULL) {
 			ARLOGe("setCamera(): Error: arParamLTCreate.\n");
 			return -1;
 		}
@@ -378,7 +1277,9 @@ extern "C" {
 			return -1;
 		}
 		// AR_DEFAULT_PIXEL_FORMAT
-		int set = arSetPixelFormat(arc->arhandle, arc->pixFormat);
+		if (arSetPixelFormat(arc->arhandle, arc->pixFormat) < 0) {
+			ARLOGe("setCamera(): Error: arSetPixelFormat.\n");
+		}
 
 		// ARLOGi("setCamera(): arCreateHandle done\n");
 
@@ -395,7 +1296,12 @@ extern "C" {
 
 		arglCameraFrustumRH(&((arc->paramLT)->param), arc->nearPlane, arc->farPlane, arc->cameraLens);
 
+#ifdef HAVE_NFT
 		arc->kpmHandle = createKpmHandle(arc->paramLT);
+		if (arc->kpmRefDataSet != NULL) {
+			kpmSetRefDataSet(arc->kpmHandle, arc->kpmRefDataSet);
+		}
+#endif
 
 		return 0;
 	}
@@ -408,7 +1314,7 @@ extern "C" {
 	*****************/
 
 
-	static int loadMarker(const char *patt_name, int *patt_id, ARHandle *arhandle, ARPattHandle **pattHandle_p) {
+	static int loadMarker(const char *patt_name, int *patt_id, ARPattHandle **pattHandle_p) {
 		// Loading only 1 pattern in this example.
 		if ((*patt_id = arPattLoad(*pattHandle_p, patt_name)) < 0) {
 			ARLOGe("loadMarker(): Error loading pattern file %s.\n", patt_name);
@@ -443,14 +1349,16 @@ extern "C" {
 
 		// const char *patt_name
 		// Load marker(s).
-		if (!loadMarker(patt_name.c_str(), &(arc->patt_id), arc->arhandle, &(arc->arPattHandle))) {
+		if (!loadMarker(patt_name.c_str(), &(arc->patt_id), &(arc->arPattHandle))) {
 			ARLOGe("ARToolKitJS(): Unable to set up AR marker.\n");
 			return -1;
 		}
+		arc->pattIndex.clear();
 
 		return arc->patt_id;
 	}
 
+#ifdef HAVE_NFT
     std::vector<int> addNFTMarkers(int id, std::vector<std::string> &datasetPathnames) {
 		if (arControllers.find(id) == arControllers.end()) { return {}; }
 		arController *arc = &(arControllers[id]);
@@ -467,7 +1375,7 @@ extern "C" {
 
         std::vector<int> markerIds = {};
 
-        for (int i = 0; i < datasetPathnames.size(); i++) {
+        for (size_t i = 0; i < datasetPathnames.size(); i++) {
             ARLOGi("add NFT marker- '%s' \n", datasetPathnames[i].c_str());
 
             const char* datasetPathname = datasetPathnames[i].c_str();
@@ -506,7 +1414,10 @@ extern "C" {
             ARLOGe("Error: kpmSetRefDataSet\n");
             return {};
         }
-        kpmDeleteRefDataSet(&refDataSet);
+        if (arc->kpmRefDataSet != NULL) {
+            kpmDeleteRefDataSet(&(arc->kpmRefDataSet));
+        }
+        arc->kpmRefDataSet = refDataSet;
 
         ARLOGi("Loading of NFT data complete.\n");
 
@@ -514,6 +1425,7 @@ extern "C" {
 
         return markerIds;
     }
+#endif // HAVE_NFT
 
 	int addMultiMarker(int id, std::string patt_name) {
 		if (arControllers.find(id) == arControllers.end()) { return -1; }
@@ -525,6 +1437,7 @@ extern "C" {
 			ARLOGe("ARToolKitJS(): Unable to set up AR multimarker.\n");
 			return -1;
 		}
+		arc->pattIndex.clear();
 
 		int multiMarker_id = arc->multi_markers.size();
 		multi_marker marker = multi_marker();
@@ -532,6 +1445,7 @@ extern "C" {
 		marker.multiMarkerHandle = arc->arMultiMarkerHandle;
 
 		arc->multi_markers.push_back(marker);
+		arc->multiIndexValid = false;
 
 		return marker.id;
 	}
@@ -541,7 +1455,7 @@ extern "C" {
 		arController *arc = &(arControllers[id]);
 
 		int mId = multiMarker_id;
-		if (mId < 0 || arc->multi_markers.size() <= mId) {
+		if (mId < 0 || (int)arc->multi_markers.size() <= mId) {
 			return -1;
 		}
 		return (arc->multi_markers[mId].multiMarkerHandle)->marker_num;
@@ -720,8 +1634,30 @@ extern "C" {
 		return -1;
 	}
 
+	/**
+		Estimates the auto median and Otsu thresholds from the pixels of a grid of sampleStep pixels, every interval
+		frames or as soon as the mean brightness of the frame shifts by more than maxBrightnessShift (0: never),
+		instead of from the histogram of the whole frame every frame. The estimates are smoothed:
+		threshold = smoothing * threshold + (1 - smoothing) * estimate, except after a brightness shift.
+		sampleStep 0 restores the thresholds of arDetectMarker().
+	*/
+	int setThresholdEstimation(int id, int sampleStep, int interval, int maxBrightnessShift, double smoothing) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		if (sampleStep < 0 || interval < 1 || maxBrightnessShift < 0 || !(smoothing >= 0 && smoothing < 1)) return -1;
+		if (sampleStep == 0 && arc->threshSampleStep > 0) arc->arhandle->arLabelingThreshAutoIntervalTTL = 0;
+		arc->threshSampleStep = sampleStep;
+		arc->threshInterval = interval;
+		arc->threshMaxShift = maxBrightnessShift;
+		arc->threshSmoothing = smoothing;
+		arc->threshSmoothed = -1;
+		arc->threshFramesSinceUpdate = 0;
+		return 0;
+	}
+
 	int setDebugMode(int id, int enable) {
-		if (arControllers.find(id) == arControllers.end()) { return NULL; }
+		if (arControllers.find(id) == arControllers.end()) { return -1; }
 		arController *arc = &(arControllers[id]);
 
 		arSetDebugMode(arc->arhandle, enable ? AR_DEBUG_ENABLE : AR_DEBUG_DISABLE);
@@ -730,15 +1666,16 @@ extern "C" {
 		return enable;
 	}
 
-	int getProcessingImage(int id) {
-		if (arControllers.find(id) == arControllers.end()) { return NULL; }
+	// Address of the binarized image in the heap, -1 if the controller isn't found.
+	intptr_t getProcessingImage(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return -1; }
 		arController *arc = &(arControllers[id]);
 
-		return (int)arc->arhandle->labelInfo.bwImage;
+		return (intptr_t)arc->arhandle->labelInfo.bwImage;
 	}
 
 	int getDebugMode(int id) {
-		if (arControllers.find(id) == arControllers.end()) { return NULL; }
+		if (arControllers.find(id) == arControllers.end()) { return -1; }
 		arController *arc = &(arControllers[id]);
 
 		int enable;
@@ -769,6 +1706,152 @@ extern "C" {
 		return -1;
 	}
 
+	/**
+		Sets how often detectMarker() scans the whole frame. In between, the markers identified in the last frame are
+		only looked for in the regions around them, which saves most of the labeling of large frames. New markers are
+		found at the next full scan, a marker lost at once. 0 or 1 (default 0) scans every frame in full.
+	*/
+	int setROIFullScanInterval(int id, int frames) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		if (frames < 0) return -1;
+		arc->roiFullScanInterval = frames;
+		arc->roiFramesSinceFullScan = 0;
+		return 0;
+	}
+
+	int getROIFullScanInterval(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		return arc->roiFullScanInterval;
+	}
+
+	/**
+		Sets the factor (1, 2 or 4) the luma is downscaled by for thresholding and labeling. The quads found are
+		then extracted again from the full resolution luma, in boxes around them, before their pattern is read,
+		which keeps the accuracy of the corners for a fraction of the labeling cost. Markers smaller than about
+		8 * factor pixels are not found. The auto median and Otsu thresholds are computed on the downscaled luma.
+		The debug mode, the field image mode and the adaptive and bracketing threshold modes label at full resolution.
+	*/
+	int setCoarseDetectionFactor(int id, int factor) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		if (factor != 1 && factor != 2 && factor != 4) return -1;
+		arc->coarseFactor = factor;
+		return 0;
+	}
+
+	int getCoarseDetectionFactor(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		return arc->coarseFactor;
+	}
+
+	/**
+		Sets the number of threads the square marker labeling is split across, in horizontal strips of the frame.
+		The labels are those of the single threaded labeling. Only builds with pthreads (native, artoolkit_wasm_mt.js)
+		run the strips concurrently. The debug mode, the field image mode, the bracketing threshold mode and the
+		adaptive threshold mode without setFastAdaptiveThresholdEnabled() label with arDetectMarker() in a single
+		thread, and the tracking history of arDetectMarker() is not kept with more than one thread.
+	*/
+	int setLabelingThreadNum(int id, int threadNum) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		if (threadNum < 1 || threadNum > AR_LABELING_MT_THREAD_MAX) return -1;
+		if (threadNum == arc->labelingThreadNum) return 0;
+
+		// The workers are started here once and kept until the thread count changes or the controller is torn down.
+		if (arc->labelingMTHandle != NULL) arLabelingMTDeleteHandle(&(arc->labelingMTHandle));
+		if (threadNum > 1 && (arc->labelingMTHandle = arLabelingMTCreateHandle(threadNum)) == NULL) {
+			ARLOGe("setLabelingThreadNum(): Error: arLabelingMTCreateHandle.\n");
+			arc->labelingThreadNum = 1;
+			return -1;
+		}
+		arc->labelingThreadNum = threadNum;
+		return 0;
+	}
+
+	int getLabelingThreadNum(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		return arc->labelingThreadNum;
+	}
+
+	/**
+		Binarizes the frame of the adaptive threshold mode with arThreshAdaptiveBinarize(), whose running box sums
+		cost about as much as the manual threshold, and labels it with arLabelingMT(). The markers are those of
+		arDetectMarker(), but its tracking history, which keeps the ids of markers whose pattern was not read in the
+		frame, is not used. Off by default; the debug mode and the field image mode always take arDetectMarker().
+	*/
+	int setFastAdaptiveThresholdEnabled(int id, int enable) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		arc->fastAdaptiveEnabled = enable != 0;
+		return 0;
+	}
+
+	int getFastAdaptiveThresholdEnabled(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		return arc->fastAdaptiveEnabled;
+	}
+
+	/**
+		Enables the index of the template patterns. The pattern read from each quad is then correlated in full
+		only with the patterns whose correlation bound, from 4 x 4 block sums, comes close to the best one, instead
+		of with all the patterns in their four orientations, so a library of hundreds of patterns costs about as
+		much as a few. The markers found are the same; only the pattern id and confidence reported for quads below
+		the confidence cutoff may differ. The index is built by the first frame after patterns are loaded. The debug
+		mode, the field image mode and the bracketing threshold mode match all the patterns with arDetectMarker().
+	*/
+	int setPatternIndexEnabled(int id, int enable) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		arc->pattIndexEnabled = enable != 0;
+		return 0;
+	}
+
+	int getPatternIndexEnabled(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		return arc->pattIndexEnabled;
+	}
+
+	/**
+		Tracks the corners of the identified square markers from frame to frame, with the pyramidal Lucas-Kanade
+		optical flow on the luma, instead of detecting them: no labeling and no pattern matching. The markers are
+		detected, and their patterns verified, every given number of frames, and as soon as a corner is lost or a
+		quad degenerates. Markers that enter the view are only found by a detection, and the tracking history of
+		arDetectMarker() is not kept across tracked frames.
+	*/
+	int setCornerTrackingInterval(int id, int frames) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		if (frames < 0) return -1;
+		arc->cornerTrackInterval = frames;
+		arc->cornerTrackFrames = 0;
+		arc->trackPyramidValid = false;
+		return 0;
+	}
+
+	int getCornerTrackingInterval(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		return arc->cornerTrackInterval;
+	}
+
 
 
 
@@ -793,7 +1876,12 @@ extern "C" {
 		}
 		ARMarkerInfo* marker = markerIndex < 0 ? &gMarkerInfo : &((arc->arhandle)->markerInfo[markerIndex]);
 
+		double t0 = nowMs();
+		AR_TRACE_BEGIN("arGetTransMatSquare");
 		arGetTransMatSquare(arc->ar3DHandle, marker, markerWidth, gTransform);
+		AR_TRACE_END("arGetTransMatSquare");
+		arc->stats.squarePoseMs += nowMs() - t0;
+		arc->stats.squarePoseNum++;
 
 		return 0;
 	}
@@ -807,11 +1895,156 @@ extern "C" {
 		}
 		ARMarkerInfo* marker = markerIndex < 0 ? &gMarkerInfo : &((arc->arhandle)->markerInfo[markerIndex]);
 
+		double t0 = nowMs();
+		AR_TRACE_BEGIN("arGetTransMatSquareCont");
 		arGetTransMatSquareCont(arc->ar3DHandle, marker, gTransform, markerWidth, gTransform);
+		AR_TRACE_END("arGetTransMatSquareCont");
+		arc->stats.squarePoseMs += nowMs() - t0;
+		arc->stats.squarePoseNum++;
+
+		return 0;
+	}
+
+	static int squareMarkerKey(int type, int markerId) {
+		return markerId * 2 + type;
+	}
+
+	// The type ARController.prototype.process() gives the marker, and its pattern or matrix code id.
+	static int squareMarkerType(const ARMarkerInfo *marker, int *markerId) {
+		if (marker->idPatt > -1 && (marker->id == marker->idPatt || marker->idMatrix == -1)) {
+			*markerId = marker->idPatt;
+			return SQUARE_MARKER_PATTERN;
+		}
+		if (marker->idMatrix > -1) {
+			*markerId = marker->idMatrix;
+			return SQUARE_MARKER_BARCODE;
+		}
+		return SQUARE_MARKER_UNKNOWN;
+	}
+
+	/**
+		Registers the width of the pattern (type 0) or matrix code (type 1) marker markerId for
+		getTransMatSquareBatch(). A width of 0 or less unregisters it.
+	*/
+	int setSquareMarkerWidth(int id, int type, int markerId, ARdouble width) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
 
+		if ((type != SQUARE_MARKER_PATTERN && type != SQUARE_MARKER_BARCODE) || markerId < 0) return -1;
+		int key = squareMarkerKey(type, markerId);
+		if (width <= 0) {
+			auto it = arc->squarePoses.find(key);
+			if (it == arc->squarePoses.end()) return 0;
+			if (it->second.filter != NULL) arFilterTransMatFinal(it->second.filter);
+			arc->squarePoses.erase(it);
+		} else {
+			arc->squarePoses[key].width = width;
+		}
 		return 0;
 	}
 
+	/**
+		Smooths the poses of getTransMatSquareBatch() with arFilterTransMat(): a low-pass filter per marker, of
+		cutoff frequency cutoffFreq (Hz) for poses coming at sampleRate (Hz, the frame rate). The filter of a marker
+		restarts from its pose when it was not found in the previous frame. Markers whose id is found more than once
+		in a frame are not filtered, and their filter restarts in the next frame. A cutoffFreq of 0 or less turns the
+		filtering off.
+	*/
+	int setPoseFilter(int id, ARdouble cutoffFreq, ARdouble sampleRate) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		if (cutoffFreq > 0 && sampleRate <= 0) return -1;
+		arc->poseFilterCutoff = cutoffFreq > 0 ? cutoffFreq : 0;
+		arc->poseFilterSampleRate = sampleRate;
+		for (auto &pose : arc->squarePoses) {
+			if (pose.second.filter == NULL) continue;
+			if (arc->poseFilterCutoff > 0) {
+				arFilterTransMatSetParams(pose.second.filter, sampleRate, cutoffFreq);
+			} else {
+				arFilterTransMatFinal(pose.second.filter);
+				pose.second.filter = NULL;
+			}
+		}
+		return 0;
+	}
+
+	ARdouble getPoseFilterCutoff(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		return arc->poseFilterCutoff;
+	}
+
+	/**
+		Estimates the poses of all the square markers of the last detectMarker() whose id has a width registered
+		with setSquareMarkerWidth(), in one call: with arGetTransMatSquareCont() from the marker's pose of the
+		previous frame if it had one, arGetTransMatSquare() otherwise, and always for ids found more than once. The direction of each marker is set to that
+		of its pattern or matrix code first, like ARController.prototype.process() does. The pose of the marker of
+		index i goes to batchTrans[i], its type to batchTypes[i] (-1 when not estimated) and its error to
+		batchErrors[i]; the arrays are reported by artoolkit.frameMalloc. With setPoseFilter(), batchTrans[i] is the
+		filtered pose, the next frame continues from the unfiltered one. batchGL[i] is batchTrans[i] as a float
+		OpenGL model-view matrix, as arglCameraViewRH() makes it. Returns the number of poses.
+	*/
+	int getTransMatSquareBatch(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		ARHandle *handle = arc->arhandle;
+		int frameNum = arc->stats.frameNum;
+		int num = 0;
+		double t0 = nowMs();
+		AR_TRACE_BEGIN("getTransMatSquareBatch");
+		int types[AR_SQUARE_MAX], keys[AR_SQUARE_MAX];
+		for (int i = 0; i < handle->marker_num; i++) {
+			int markerId = -1;
+			types[i] = squareMarkerType(&(handle->markerInfo[i]), &markerId);
+			keys[i] = types[i] == SQUARE_MARKER_UNKNOWN ? -1 : squareMarkerKey(types[i], markerId);
+		}
+		for (int i = 0; i < handle->marker_num; i++) {
+			ARMarkerInfo *marker = &(handle->markerInfo[i]);
+			int type = types[i];
+			arc->batchTypes[i] = SQUARE_MARKER_UNKNOWN;
+			if (type == SQUARE_MARKER_UNKNOWN) continue;
+			auto it = arc->squarePoses.find(keys[i]);
+			if (it == arc->squarePoses.end()) continue;
+
+			square_pose *pose = &(it->second);
+			marker->dir = type == SQUARE_MARKER_PATTERN ? marker->dirPatt : marker->dirMatrix;
+			// Markers sharing an id in the frame can't tell which one the pose and filter of the id belong to.
+			bool duplicate = false;
+			for (int j = 0; j < handle->marker_num && !duplicate; j++) duplicate = j != i && keys[j] == keys[i];
+			if (duplicate) {
+				// Neither is continued from nor filtered, and the next frame starts afresh.
+				arc->batchErrors[i] = arGetTransMatSquare(arc->ar3DHandle, marker, pose->width, arc->batchTrans[i]);
+				pose->frameNum = -1;
+			} else {
+				bool cont = pose->frameNum == frameNum - 1;
+				if (cont) {
+					arc->batchErrors[i] = arGetTransMatSquareCont(arc->ar3DHandle, marker, pose->trans, pose->width, pose->trans);
+				} else {
+					arc->batchErrors[i] = arGetTransMatSquare(arc->ar3DHandle, marker, pose->width, pose->trans);
+				}
+				pose->frameNum = frameNum;
+				matrixCopy(pose->trans, arc->batchTrans[i]);
+				if (arc->poseFilterCutoff > 0) {
+					if (pose->filter == NULL) pose->filter = arFilterTransMatInit(arc->poseFilterSampleRate, arc->poseFilterCutoff);
+					if (pose->filter != NULL) arFilterTransMat(pose->filter, arc->batchTrans[i], cont ? 0 : 1);
+				}
+			}
+			ARdouble modelView[16];
+			arglCameraViewRH(arc->batchTrans[i], modelView, 1.0);
+			for (int k = 0; k < 16; k++) arc->batchGL[i][k] = (float)modelView[k];
+			arc->batchTypes[i] = type;
+			num++;
+		}
+		AR_TRACE_END("getTransMatSquareBatch");
+		arc->stats.squarePoseMs += nowMs() - t0;
+		arc->stats.squarePoseNum += num;
+
+		return num;
+	}
+
 	int setMarkerInfoDir(int id, int markerIndex, int dir) {
 		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
 		arController *arc = &(arControllers[id]);
@@ -856,13 +2089,18 @@ extern "C" {
 		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
 		arController *arc = &(arControllers[id]);
 
-		if (arc->multi_markers.size() <= multiMarkerId || multiMarkerId < 0) {
+		if ((int)arc->multi_markers.size() <= multiMarkerId || multiMarkerId < 0) {
 			return MULTIMARKER_NOT_FOUND;
 		}
 		multi_marker *multiMatch = &(arc->multi_markers[multiMarkerId]);
 		ARMultiMarkerInfoT *arMulti = multiMatch->multiMarkerHandle;
 
+		double t0 = nowMs();
+		AR_TRACE_BEGIN("arGetTransMatMultiSquareRobust");
 		arGetTransMatMultiSquareRobust( arc->ar3DHandle, arc->arhandle->markerInfo, arc->arhandle->marker_num, arMulti );
+		AR_TRACE_END("arGetTransMatMultiSquareRobust");
+		arc->stats.multiPoseMs += nowMs() - t0;
+		arc->stats.multiPoseNum++;
 		matrixCopy(arMulti->trans, gTransform);
 
 		return 0;
@@ -872,31 +2110,273 @@ extern "C" {
 		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
 		arController *arc = &(arControllers[id]);
 
-		if (arc->multi_markers.size() <= multiMarkerId || multiMarkerId < 0) {
+		if ((int)arc->multi_markers.size() <= multiMarkerId || multiMarkerId < 0) {
 			return MULTIMARKER_NOT_FOUND;
 		}
 		multi_marker *multiMatch = &(arc->multi_markers[multiMarkerId]);
 		ARMultiMarkerInfoT *arMulti = multiMatch->multiMarkerHandle;
 
+		double t0 = nowMs();
+		AR_TRACE_BEGIN("arGetTransMatMultiSquare");
 		arGetTransMatMultiSquare( arc->ar3DHandle, arc->arhandle->markerInfo, arc->arhandle->marker_num, arMulti );
+		AR_TRACE_END("arGetTransMatMultiSquare");
+		arc->stats.multiPoseMs += nowMs() - t0;
+		arc->stats.multiPoseNum++;
 		matrixCopy(arMulti->trans, gTransform);
 
 		return 0;
 	}
 
+	static void addMultiMarkerIndex(std::vector<int> *multiMarkerIds, int multiMarkerId) {
+		if (multiMarkerIds->empty() || multiMarkerIds->back() != multiMarkerId) {
+			multiMarkerIds->push_back(multiMarkerId);
+		}
+	}
+
+	// Indexes the multimarkers by the ids their sub-markers are detected with. A matrix sub-marker with a global id
+	// is indexed by both, whichever arGetTransMatMultiSquare() matches it by.
+	static void buildMultiMarkerIndex(arController *arc) {
+		arc->multiPattIndex.clear();
+		arc->multiMatrixIndex.clear();
+		arc->multiGlobalIndex.clear();
+		for (int m = 0; m < (int)arc->multi_markers.size(); m++) {
+			ARMultiMarkerInfoT *config = arc->multi_markers[m].multiMarkerHandle;
+			for (int j = 0; j < config->marker_num; j++) {
+				ARMultiEachMarkerInfoT *each = &(config->marker[j]);
+				if (each->patt_type == AR_MULTI_PATTERN_TYPE_TEMPLATE) {
+					addMultiMarkerIndex(&(arc->multiPattIndex[each->patt_id]), m);
+				} else {
+					addMultiMarkerIndex(&(arc->multiMatrixIndex[each->patt_id]), m);
+					if (each->globalID != 0) addMultiMarkerIndex(&(arc->multiGlobalIndex[each->globalID]), m);
+				}
+			}
+		}
+		arc->multiIndexValid = true;
+	}
+
+	static void markMultiMarkersInView(const std::vector<int> &multiMarkerIds, std::vector<char> *inView) {
+		for (int m : multiMarkerIds) (*inView)[m] = 1;
+	}
+
+	/**
+		Estimates the poses of all the multimarkers of the controller in one call, with arGetTransMatMultiSquareRobust()
+		if robust is set, arGetTransMatMultiSquare() otherwise. Only the multimarkers with a sub-marker among the
+		markers of the last detectMarker() (by pattern id, matrix code or global id, the confidence cutoffs left to
+		arGetTransMatMultiSquare()) are estimated; the sub-markers of the others are set not visible, as
+		arGetTransMatMultiSquare() would. The pose, number of visible sub-markers and error of each multimarker are
+		reported by artoolkit.multiMarkerBatch. Returns the number of multimarkers with a visible sub-marker.
+	*/
+	int getTransMatMultiSquareBatch(int id, int robust) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		if (!arc->multiIndexValid) buildMultiMarkerIndex(arc);
+		int multiMarkerNum = arc->multi_markers.size();
+		arc->multiInView.assign(multiMarkerNum, 0);
+		arc->multiBatchTrans.resize(multiMarkerNum * 12);
+		arc->multiBatchVisible.assign(multiMarkerNum, 0);
+		arc->multiBatchErrors.assign(multiMarkerNum, -1);
+
+		ARHandle *handle = arc->arhandle;
+		for (int i = 0; i < handle->marker_num; i++) {
+			ARMarkerInfo *marker = &(handle->markerInfo[i]);
+			auto patt = arc->multiPattIndex.find(marker->idPatt);
+			if (patt != arc->multiPattIndex.end()) markMultiMarkersInView(patt->second, &(arc->multiInView));
+			auto matrix = arc->multiMatrixIndex.find(marker->idMatrix);
+			if (matrix != arc->multiMatrixIndex.end()) markMultiMarkersInView(matrix->second, &(arc->multiInView));
+			if (marker->globalID != 0) {
+				auto global = arc->multiGlobalIndex.find(marker->globalID);
+				if (global != arc->multiGlobalIndex.end()) markMultiMarkersInView(global->second, &(arc->multiInView));
+			}
+		}
+
+		int num = 0, estimated = 0;
+		double t0 = nowMs();
+		AR_TRACE_BEGIN("getTransMatMultiSquareBatch");
+		for (int m = 0; m < multiMarkerNum; m++) {
+			ARMultiMarkerInfoT *config = arc->multi_markers[m].multiMarkerHandle;
+			if (arc->multiInView[m]) {
+				if (robust) {
+					arc->multiBatchErrors[m] = arGetTransMatMultiSquareRobust(arc->ar3DHandle, handle->markerInfo, handle->marker_num, config);
+				} else {
+					arc->multiBatchErrors[m] = arGetTransMatMultiSquare(arc->ar3DHandle, handle->markerInfo, handle->marker_num, config);
+				}
+				estimated++;
+			} else {
+				// What arGetTransMatMultiSquare() leaves when none of the sub-markers is found.
+				for (int j = 0; j < config->marker_num; j++) {
+					config->marker[j].visible = config->marker[j].visibleR = -1;
+				}
+				config->prevF = 0;
+			}
+			for (int j = 0; j < config->marker_num; j++) {
+				if (config->marker[j].visible >= 0) arc->multiBatchVisible[m]++;
+			}
+			if (arc->multiBatchVisible[m] > 0) {
+				num++;
+			} else {
+				arc->multiBatchErrors[m] = -1;
+			}
+			for (int r = 0; r < 3; r++) {
+				for (int c = 0; c < 4; c++) arc->multiBatchTrans[m * 12 + r * 4 + c] = config->trans[r][c];
+			}
+		}
+		AR_TRACE_END("getTransMatMultiSquareBatch");
+		arc->stats.multiPoseMs += nowMs() - t0;
+		arc->stats.multiPoseNum += estimated;
+
+		MultiMarkerBatchResult result;
+		result.multiMarkerNum = multiMarkerNum;
+		result.trans = arc->multiBatchTrans.data();
+		result.visibleNum = arc->multiBatchVisible.data();
+		result.errors = arc->multiBatchErrors.data();
+		emitMultiMarkerBatchResult(&result);
+
+		return num;
+	}
+
 	int detectMarker(int id) {
 		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
 		arController *arc = &(arControllers[id]);
 
 		// Convert video frame to AR2VideoBufferT
-    AR2VideoBufferT buff = {0};
+    AR2VideoBufferT buff = {};
     buff.buff = arc->videoFrame;
     buff.fillFlag = 1;
 
     buff.buffLuma = arc->videoLuma;
 
+		// A new frame: the pose times add up until the next one, the NFT times are set by detectNFTMarker().
+		FrameStatsResult *stats = &(arc->stats);
+		stats->frameNum++;
+		stats->squarePoseMs = stats->multiPoseMs = 0;
+		stats->squarePoseNum = stats->multiPoseNum = 0;
+
+		double t0 = nowMs();
+		int ret = 0;
+		stats->roiNum = 0;
+		stats->coarseFactor = 1;
+		stats->pattShortlistNum = -1;
+		stats->trackedMarkerNum = 0;
+		if (arc->cornerTrackInterval > 0) {
+			arc->trackPyramidNext.resize(arCornerTrackPyramidSize(arc->arhandle->xsize, arc->arhandle->ysize));
+			AR_TRACE_BEGIN("arCornerTrackPyramid");
+			arCornerTrackPyramid(arc->videoLuma, arc->arhandle->xsize, arc->arhandle->ysize, arc->trackPyramidNext.data());
+			AR_TRACE_END("arCornerTrackPyramid");
+		}
+		if (cornerTrackingPossible(arc)) {
+			AR_TRACE_BEGIN("trackMarkerCorners");
+			int tracked = trackMarkerCorners(arc);
+			AR_TRACE_END("trackMarkerCorners");
+			if (tracked > 0) {
+				stats->trackedMarkerNum = tracked;
+				arc->cornerTrackFrames++;
+				arc->historySkipped = true;
+			}
+		}
+		if (stats->trackedMarkerNum == 0) {
+			// A lost marker, or the markers are due to be verified: they are detected again.
+			if (thresholdEstimationActive(arc)) {
+				AR_TRACE_BEGIN("estimateThreshold");
+				estimateThreshold(arc);
+				AR_TRACE_END("estimateThreshold");
+			}
+			if (roiDetectionPossible(arc)) {
+				AR_TRACE_BEGIN("detectMarkerROI");
+				stats->roiNum = detectMarkerROI(arc);
+				AR_TRACE_END("detectMarkerROI");
+			}
+			if (stats->roiNum > 0) {
+				arc->roiFramesSinceFullScan++;
+				arc->historySkipped = true;
+				// Lost markers are looked for in the whole next frame.
+				if (!updateROIMarkers(arc, true)) arc->roiFramesSinceFullScan = arc->roiFullScanInterval;
+			} else {
+				// A full scan, at coarse or full resolution.
+				int coarse = -1, frame = -1;
+				if (coarseDetectionPossible(arc)) {
+					AR_TRACE_BEGIN("detectMarkerCoarse");
+					coarse = detectMarkerCoarse(arc);
+					AR_TRACE_END("detectMarkerCoarse");
+				}
+				if (coarse < 0 && detectMarkerFramePossible(arc)) {
+					AR_TRACE_BEGIN("detectMarkerFrame");
+					frame = detectMarkerFrame(arc);
+					AR_TRACE_END("detectMarkerFrame");
+				}
+				if (coarse >= 0) {
+					stats->roiNum = coarse;
+					stats->coarseFactor = arc->coarseFactor;
+					arc->historySkipped = true;
+				} else if (frame >= 0) {
+					stats->roiNum = 0;
+					arc->historySkipped = true;
+				} else {
+					stats->roiNum = 0;
+					// The history is that of the last arDetectMarker(), the frames in between had none.
+					if (arc->historySkipped) arc->arhandle->history_num = 0;
+					arc->historySkipped = false;
+					AR_TRACE_BEGIN("arDetectMarker");
+					ret = arDetectMarker( arc->arhandle, &buff);
+					AR_TRACE_END("arDetectMarker");
+				}
+				arc->roiFramesSinceFullScan = 0;
+				updateROIMarkers(arc, false);
+			}
+			arc->cornerTrackFrames = 0;
+		}
+		if (arc->cornerTrackInterval > 0) {
+			arc->trackPyramid.swap(arc->trackPyramidNext);
+			arc->trackPyramidValid = true;
+		}
+		stats->detectMs = nowMs() - t0;
+		stats->labelNum = arc->arhandle->labelInfo.label_num;
+		stats->candidateQuadNum = arc->arhandle->marker2_num;
+		stats->markerNum = arc->arhandle->marker_num;
+		stats->threshold = arc->arhandle->arLabelingThresh;
 
-		return arDetectMarker( arc->arhandle, &buff);
+		return ret;
+	}
+
+	/**
+		Emits the timings and counters of the controller's last frame (artoolkit.frameStats).
+	*/
+	int getFrameStats(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		emitFrameStatsResult(&(arc->stats));
+		return 0;
+	}
+
+	/**
+		Forgets the state carried from frame to frame: the square marker history, the auto threshold interval
+		and the tracked NFT page. The next frames are then processed as by a new controller, which is what
+		capture and replay need to produce the same results.
+	*/
+	int resetTracking(int id) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
+
+		if (arc->arhandle != NULL) {
+			arc->arhandle->history_num = 0;
+			arc->arhandle->arLabelingThreshAutoIntervalTTL = 0;
+		}
+		arc->roiMarkerIds.clear();
+		arc->roiFramesSinceFullScan = 0;
+		arc->historySkipped = false;
+		arc->threshSmoothed = -1;
+		arc->threshFramesSinceUpdate = 0;
+		arc->cornerTrackFrames = 0;
+		arc->trackPyramidValid = false;
+		for (auto &pose : arc->squarePoses) pose.second.frameNum = -1;
+#ifdef HAVE_NFT
+		for (int i = 0; i < arc->surfaceSetCount; i++) {
+			if (arc->surfaceSet[i] != NULL) arc->surfaceSet[i]->contNum = 0;
+		}
+		arc->detectedPage = -2;
+#endif
+		return 0;
 	}
 
 
@@ -911,7 +2391,7 @@ extern "C" {
 		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
 		arController *arc = &(arControllers[id]);
 
-		if (arc->multi_markers.size() <= multiMarkerId || multiMarkerId < 0) {
+		if ((int)arc->multi_markers.size() <= multiMarkerId || multiMarkerId < 0) {
 			return MULTIMARKER_NOT_FOUND;
 		}
 		multi_marker *multiMatch = &(arc->multi_markers[multiMarkerId]);
@@ -924,21 +2404,12 @@ extern "C" {
 		ARMultiEachMarkerInfoT *marker = &(arMulti->marker[markerIndex]);
 		matrixCopy(marker->trans, gTransform);
 
-		EM_ASM_({
-			if (!artoolkit["multiEachMarkerInfo"]) {
-				artoolkit["multiEachMarkerInfo"] = ({});
-			}
-			var multiEachMarker = artoolkit["multiEachMarkerInfo"];
-			multiEachMarker['visible'] = $0;
-			multiEachMarker['pattId'] = $1;
-			multiEachMarker['pattType'] = $2;
-			multiEachMarker['width'] = $3;
-		},
-			marker->visible,
-			marker->patt_id,
-			marker->patt_type,
-			marker->width
-		);
+		MultiEachMarkerResult result;
+		result.visible = marker->visible;
+		result.pattId = marker->patt_id;
+		result.pattType = marker->patt_type;
+		result.width = marker->width;
+		emitMultiEachMarkerResult(&result);
 
 		return 0;
 	}
@@ -952,102 +2423,7 @@ extern "C" {
 		}
 		ARMarkerInfo* markerInfo = markerIndex < 0 ? &gMarkerInfo : &((arc->arhandle)->markerInfo[markerIndex]);
 
-		EM_ASM_({
-			var $a = arguments;
-			var i = 12;
-			if (!artoolkit["markerInfo"]) {
-				artoolkit["markerInfo"] = ({
-					pos: [0,0],
-					line: [[0,0,0], [0,0,0], [0,0,0], [0,0,0]],
-					vertex: [[0,0], [0,0], [0,0], [0,0]]
-				});
-			}
-			var markerInfo = artoolkit["markerInfo"];
-			markerInfo["area"] = $0;
-			markerInfo["id"] = $1;
-			markerInfo["idPatt"] = $2;
-			markerInfo["idMatrix"] = $3;
-			markerInfo["dir"] = $4;
-			markerInfo["dirPatt"] = $5;
-			markerInfo["dirMatrix"] = $6;
-			markerInfo["cf"] = $7;
-			markerInfo["cfPatt"] = $8;
-			markerInfo["cfMatrix"] = $9;
-			markerInfo["pos"][0] = $10;
-			markerInfo["pos"][1] = $11;
-			markerInfo["line"][0][0] = $a[i++];
-			markerInfo["line"][0][1] = $a[i++];
-			markerInfo["line"][0][2] = $a[i++];
-			markerInfo["line"][1][0] = $a[i++];
-			markerInfo["line"][1][1] = $a[i++];
-			markerInfo["line"][1][2] = $a[i++];
-			markerInfo["line"][2][0] = $a[i++];
-			markerInfo["line"][2][1] = $a[i++];
-			markerInfo["line"][2][2] = $a[i++];
-			markerInfo["line"][3][0] = $a[i++];
-			markerInfo["line"][3][1] = $a[i++];
-			markerInfo["line"][3][2] = $a[i++];
-			markerInfo["vertex"][0][0] = $a[i++];
-			markerInfo["vertex"][0][1] = $a[i++];
-			markerInfo["vertex"][1][0] = $a[i++];
-			markerInfo["vertex"][1][1] = $a[i++];
-			markerInfo["vertex"][2][0] = $a[i++];
-			markerInfo["vertex"][2][1] = $a[i++];
-			markerInfo["vertex"][3][0] = $a[i++];
-			markerInfo["vertex"][3][1] = $a[i++];
-			markerInfo["errorCorrected"] = $a[i++];
-			// markerInfo["globalID"] = $a[i++];
-		},
-			markerInfo->area,
-			markerInfo->id,
-			markerInfo->idPatt,
-			markerInfo->idMatrix,
-			markerInfo->dir,
-			markerInfo->dirPatt,
-			markerInfo->dirMatrix,
-			markerInfo->cf,
-			markerInfo->cfPatt,
-			markerInfo->cfMatrix,
-
-			markerInfo->pos[0],
-			markerInfo->pos[1],
-
-			markerInfo->line[0][0],
-			markerInfo->line[0][1],
-			markerInfo->line[0][2],
-
-			markerInfo->line[1][0],
-			markerInfo->line[1][1],
-			markerInfo->line[1][2],
-
-			markerInfo->line[2][0],
-			markerInfo->line[2][1],
-			markerInfo->line[2][2],
-
-			markerInfo->line[3][0],
-			markerInfo->line[3][1],
-			markerInfo->line[3][2],
-
-			//
-
-			markerInfo->vertex[0][0],
-			markerInfo->vertex[0][1],
-
-			markerInfo->vertex[1][0],
-			markerInfo->vertex[1][1],
-
-			markerInfo->vertex[2][0],
-			markerInfo->vertex[2][1],
-
-			markerInfo->vertex[3][0],
-			markerInfo->vertex[3][1],
-
-			//
-
-			markerInfo->errorCorrected
-
-			// markerInfo->globalID
-		);
+		emitMarkerInfoResult(markerInfo);
 
 		return 0;
 	}
@@ -1057,51 +2433,218 @@ extern "C" {
 	* Setup *
 	********/
 
-	int setup(int width, int height, int cameraID) {
+	static void emitFrameMalloc(arController *arc) {
+		FrameMallocResult result;
+		result.id = arc->id;
+		result.framepointer = arc->videoFrame;
+		result.framesize = arc->videoFrameSize;
+		result.camera = arc->cameraLens;
+		result.transform = (ARdouble *)gTransform;
+		result.videoLumaPointer = arc->videoLuma;
+		result.ardoubleSize = (int)sizeof(ARdouble); // 8, or 4 in the ARDOUBLE_IS_FLOAT build
+		result.squarePoses = (ARdouble *)arc->batchTrans;
+		result.squarePoseTypes = arc->batchTypes;
+		result.squarePoseErrors = arc->batchErrors;
+		result.squarePosesGL = (float *)arc->batchGL;
+		result.squarePoseMax = AR_SQUARE_MAX;
+		emitFrameMallocResult(&result);
+	}
+
+	static int setupController(int width, int height, int cameraID, int maxWidth, int maxHeight, int maxPatterns, int maxSearchFeatureNum) {
 		int id = gARControllerID++;
 		arController *arc = &(arControllers[id]);
 		arc->id = id;
 
 		arc->width = width;
 		arc->height = height;
+		arc->frameCapacity = maxWidth * maxHeight;
+		if (arc->frameCapacity < width * height) arc->frameCapacity = width * height;
+		if (maxSearchFeatureNum > 0 && maxSearchFeatureNum < AR2_SEARCH_FEATURE_MAX) {
+			arc->maxSearchFeatureNum = maxSearchFeatureNum;
+		}
 
-		arc->videoFrameSize = width * height * 4 * sizeof(ARUint8);
-		arc->videoFrame = (ARUint8*) malloc(arc->videoFrameSize);
-		arc->videoLuma = (ARUint8*) malloc(arc->videoFrameSize / 4);
-
-		if ((arc->arPattHandle = arPattCreateHandle()) == NULL) {
+		if (maxPatterns > 0) {
+			arc->arPattHandle = arPattCreateHandle2(AR_PATT_SIZE1, maxPatterns);
+		} else {
+			arc->arPattHandle = arPattCreateHandle();
+		}
+		if (arc->arPattHandle == NULL) {
 			ARLOGe("setup(): Error: arPattCreateHandle.\n");
 		}
 
-		setCamera(id, cameraID);
+		bool adopted = false;
+		if (cameraParams.find(cameraID) != cameraParams.end()) {
+			ARParam param = cameraParams[cameraID];
+			if (param.xsize != width || param.ysize != height) {
+				arParamChangeSize(&param, width, height, &param);
+			}
+			adopted = adoptPooledController(arc, &param);
+		} else {
+			adopted = adoptPooledController(arc, NULL);
+		}
+
+		if (arc->videoFrame == NULL) {
+			arc->videoFrame = (ARUint8*) malloc(arc->frameCapacity * 4 * sizeof(ARUint8));
+			arc->videoLuma = (ARUint8*) malloc(arc->frameCapacity);
+		}
+		arc->videoFrameSize = width * height * 4 * sizeof(ARUint8);
+
+		if (adopted) {
+			arc->cameraID = cameraID;
+		} else {
+			setCamera(id, cameraID);
+		}
 
 		ARLOGi("Allocated videoFrameSize %d\n", arc->videoFrameSize);
 
-		EM_ASM_({
-			if (!artoolkit["frameMalloc"]) {
-				artoolkit["frameMalloc"] = ({});
-			}
-			var frameMalloc = artoolkit["frameMalloc"];
-			frameMalloc["framepointer"] = $1;
-			frameMalloc["framesize"] = $2;
-			frameMalloc["camera"] = $3;
-			frameMalloc["transform"] = $4;
-			frameMalloc["videoLumaPointer"] = $5;
-		},
-			arc->id,
-			arc->videoFrame,
-			arc->videoFrameSize,
-			arc->cameraLens,
-			gTransform,
-			arc->videoLuma          //$5
-		);
+		emitFrameMalloc(arc);
 
 
 		return arc->id;
 	}
 
+	int setup(int width, int height, int cameraID) {
+		return setupController(width, height, cameraID, width, height, 0, 0);
+	}
+
+	/**
+		Like setup(), but the controller declares its limits up front: the frame buffers
+		are sized for maxWidth x maxHeight so resizeController() within that never
+		reallocates them, the pattern handle is created with room for maxPatterns, and
+		NFT tracking never searches more than maxSearchFeatureNum features per frame.
+		Pass 0 for a limit to keep the default.
+
+		The plan does not cover everything. A heap built without memory growth must leave room for:
+		- Allocations made and freed within each frame: the ICP scratch of arGetTransMatSquare(),
+		  arGetTransMatMultiSquare() and ar2Tracking() (a few dozen bytes per point, at most
+		  maxSearchFeatureNum points for NFT), the pattern sample of arGetMarkerInfo() for every candidate
+		  square, and the keypoints and FREAK descriptors KPM extracts from the frame (a few hundred KB at
+		  640x480).
+		- Allocations made on the first frame and kept until the size changes: the KPM scale-space and DoG
+		  pyramids (several MB at 640x480), the ROI, coarse and adaptive luma copies, the pattern index with
+		  its scratch, and the labeling trace buffers when tracing is enabled.
+		Labeling itself works in the label buffers arCreateHandle() sizes for the frame.
+	*/
+	int setupWithMemoryPlan(int width, int height, int cameraID, int maxWidth, int maxHeight, int maxPatterns, int maxSearchFeatureNum) {
+		return setupController(width, height, cameraID, maxWidth, maxHeight, maxPatterns, maxSearchFeatureNum);
+	}
+
+	/**
+		Changes the frame size of an existing controller. Only the frame buffers and the
+		handles that depend on the image size are rebuilt; loaded patterns, multimarkers,
+		NFT data and the detection settings are kept.
+	*/
+	int resizeController(int id, int width, int height) {
+		if (arControllers.find(id) == arControllers.end()) { return ARCONTROLLER_NOT_FOUND; }
+		arController *arc = &(arControllers[id]);
 
+		if (cameraParams.find(arc->cameraID) == cameraParams.end()) { return -1; }
+
+		if (width == arc->width && height == arc->height) {
+			return 0;
+		}
+
+		int videoFrameSize = width * height * 4 * sizeof(ARUint8);
+		if (width * height > arc->frameCapacity) {
+			ARUint8 *videoFrame = (ARUint8*) realloc(arc->videoFrame, videoFrameSize);
+			if (videoFrame == NULL) {
+				ARLOGe("resizeController(): Error allocating frame.\n");
+				return -1;
+			}
+			arc->videoFrame = videoFrame;
+			ARUint8 *videoLuma = (ARUint8*) realloc(arc->videoLuma, videoFrameSize / 4);
+			if (videoLuma == NULL) {
+				ARLOGe("resizeController(): Error allocating luma.\n");
+				return -1;
+			}
+			arc->videoLuma = videoLuma;
+			arc->frameCapacity = width * height;
+		}
+		arc->videoFrameSize = videoFrameSize;
+		arc->width = width;
+		arc->height = height;
+
+		arc->param = cameraParams[arc->cameraID];
+		if (arc->param.xsize != width || arc->param.ysize != height) {
+			arParamChangeSize(&(arc->param), width, height, &(arc->param));
+		}
+
+		ARParamLT *paramLT = acquireParamLT(&(arc->param), AR_PARAM_LT_DEFAULT_OFFSET);
+		if (paramLT == NULL) {
+			ARLOGe("resizeController(): Error: arParamLTCreate.\n");
+			return -1;
+		}
+
+		// The marker handle keeps its size-dependent work buffers, so recreate it and carry the settings over.
+		ARHandle *arhandle = arCreateHandle(paramLT);
+		if (arhandle == NULL) {
+			ARLOGe("resizeController(): Error: arCreateHandle.\n");
+			releaseParamLT(&paramLT);
+			return -1;
+		}
+		if (arc->arhandle != NULL) {
+			ARHandle *old = arc->arhandle;
+			copyHandleSettings(old, arhandle);
+			arPattDetach(old);
+			arDeleteHandle(old);
+		}
+		arSetPixelFormat(arhandle, arc->pixFormat);
+		arPattAttach(arhandle, arc->arPattHandle);
+		arc->arhandle = arhandle;
+
+		// The tracked corners, the ROIs and the square marker poses refer to the old image size.
+		arc->trackPyramidValid = false;
+		arc->cornerTrackFrames = 0;
+		arc->roiMarkerIds.clear();
+		arc->roiFramesSinceFullScan = 0;
+		for (auto &pose : arc->squarePoses) {
+			pose.second.frameNum = -1;
+			if (pose.second.filter != NULL) {
+				arFilterTransMatFinal(pose.second.filter);
+				pose.second.filter = NULL;
+			}
+		}
+
+		if (arc->ar3DHandle != NULL) {
+			ar3DChangeCpara(arc->ar3DHandle, arc->param.mat);
+		}
+
+#ifdef HAVE_NFT
+		if (arc->kpmHandle != NULL) {
+			kpmDeleteHandle(&(arc->kpmHandle));
+			arc->kpmHandle = createKpmHandle(paramLT);
+			if (arc->kpmRefDataSet != NULL) {
+				kpmSetRefDataSet(arc->kpmHandle, arc->kpmRefDataSet);
+			}
+		}
+
+		if (arc->ar2Handle != NULL) {
+			ar2ChangeSizeMod(arc->ar2Handle, paramLT);
+		}
+		// Previous NFT poses and feature positions refer to the old image size.
+		for (int i = 0; i < arc->surfaceSetCount; i++) {
+			if (arc->surfaceSet[i] != NULL) arc->surfaceSet[i]->contNum = 0;
+		}
+		arc->detectedPage = -2;
+#endif
+
+		if (arc->paramLT != NULL) {
+			releaseParamLT(&(arc->paramLT));
+		}
+		arc->paramLT = paramLT;
+
+		arglCameraFrustumRH(&((arc->paramLT)->param), arc->nearPlane, arc->farPlane, arc->cameraLens);
+
+		ARLOGi("Resized controller %d to %d, %d\n", arc->id, width, height);
+
+		emitFrameMalloc(arc);
+
+		return 0;
+	}
 
 }
 
+#ifdef __EMSCRIPTEN__
+#include "ARResultEM.cpp"
 #include "ARBindEM.cpp"
+#endif
@@ -0,0 +1,205 @@
+/*
+ * Per-thread ring buffers of trace events, see ARTrace.h.
+ *
+ * Each thread only writes its own buffer and publishes an event by incrementing the buffer's head.
+ * The buffers are never freed, so that the events of finished threads can still be dumped, and are
+ * found through a list that threads prepend to with a compare and swap. A thread that ends gives its
+ * buffer back, and the next thread to trace takes it over instead of allocating one, continuing its
+ * ring under the same tid. A dump copies the events, then drops those the owner may have overwritten
+ * in the meantime.
+ */
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define AR_TRACE_PTHREADS
+#include <pthread.h>
+#endif
+#include "ARTrace.h"
+
+typedef struct {
+    double      ts; // us
+    const char *name;
+    char        phase;
+} ARTraceEventT;
+
+// Relaxed atomics, which compile to plain loads and stores, since a dump may read an event being overwritten.
+typedef struct {
+    _Atomic double             ts;
+    _Atomic(const char *)      name;
+    _Atomic char               phase;
+} ARTraceSlotT;
+
+typedef struct ARTraceBuffer {
+    ARTraceSlotT           events[AR_TRACE_BUFFER_SIZE];
+    atomic_uint            head; // Events written, the last AR_TRACE_BUFFER_SIZE are in events.
+    atomic_uint            tail; // head at the last arTraceClear().
+    atomic_int             owned; // 0 once the thread writing the buffer has ended.
+    int                    tid;
+    struct ARTraceBuffer  *next;
+} ARTraceBuffer;
+
+int arTraceEnabled = 0;
+
+static _Atomic(ARTraceBuffer *) buffers = NULL;
+static atomic_int threadCount = 0;
+static _Thread_local ARTraceBuffer *threadBuffer = NULL;
+#ifdef AR_TRACE_PTHREADS
+static pthread_key_t  bufferKey;
+static pthread_once_t bufferKeyOnce = PTHREAD_ONCE_INIT;
+
+static void releaseBuffer( void *buffer )
+{
+    atomic_store( &((ARTraceBuffer *)buffer)->owned, 0 );
+}
+
+static void createBufferKey( void )
+{
+    pthread_key_create( &bufferKey, releaseBuffer );
+}
+#endif
+
+static double nowUs( void )
+{
+#ifdef __EMSCRIPTEN__
+    return emscripten_get_now() * 1000.0;
+#else
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+#endif
+}
+
+void arTraceSetEnabled( int enable )
+{
+    arTraceEnabled = enable ? 1 : 0;
+}
+
+void arTraceEvent( const char *name, char phase )
+{
+    ARTraceBuffer *buffer = threadBuffer;
+    ARTraceSlotT  *slot;
+    unsigned int   head;
+
+    if( buffer == NULL ) {
+        for( buffer = atomic_load( &buffers ); buffer != NULL; buffer = buffer->next ) {
+            int owned = 0;
+            if( atomic_compare_exchange_strong( &buffer->owned, &owned, 1 ) ) break;
+        }
+        if( buffer == NULL ) {
+            buffer = (ARTraceBuffer *)calloc( 1, sizeof(ARTraceBuffer) );
+            if( buffer == NULL ) return;
+            atomic_store( &buffer->owned, 1 );
+            buffer->tid = atomic_fetch_add( &threadCount, 1 ) + 1;
+            buffer->next = atomic_load( &buffers );
+            while( !atomic_compare_exchange_weak( &buffers, &buffer->next, buffer ) );
+        }
+#ifdef AR_TRACE_PTHREADS
+        // The key's destructor gives the buffer back when the thread ends.
+        pthread_once( &bufferKeyOnce, createBufferKey );
+        pthread_setspecific( bufferKey, buffer );
+#endif
+        threadBuffer = buffer;
+    }
+
+    head = atomic_load_explicit( &buffer->head, memory_order_relaxed );
+    slot = &buffer->events[head % AR_TRACE_BUFFER_SIZE];
+    // A dump that reads the new values of the slot also reads a head of at least head, see arTraceDump().
+    atomic_thread_fence( memory_order_release );
+    atomic_store_explicit( &slot->ts, nowUs(), memory_order_relaxed );
+    atomic_store_explicit( &slot->name, name, memory_order_relaxed );
+    atomic_store_explicit( &slot->phase, phase, memory_order_relaxed );
+    atomic_store_explicit( &buffer->head, head + 1, memory_order_release );
+}
+
+void arTraceClear( void )
+{
+    ARTraceBuffer *buffer;
+
+    for( buffer = atomic_load( &buffers ); buffer != NULL; buffer = buffer->next ) {
+        atomic_store( &buffer->tail, atomic_load_explicit( &buffer->head, memory_order_acquire ) );
+    }
+}
+
+typedef struct {
+    char   *data;
+    size_t  size;
+    size_t  capacity;
+} ARTraceJSON;
+
+static void append( ARTraceJSON *json, const char *format, ... )
+{
+    va_list  args;
+    char    *data;
+    int      n;
+
+    if( json->data == NULL ) return;
+    for( ;; ) {
+        va_start( args, format );
+        n = vsnprintf( json->data + json->size, json->capacity - json->size, format, args );
+        va_end( args );
+        if( n < 0 ) return;
+        if( json->size + n < json->capacity ) break;
+        data = (char *)realloc( json->data, json->capacity * 2 + n );
+        if( data == NULL ) {
+            free( json->data );
+            json->data = NULL;
+            return;
+        }
+        json->data = data;
+        json->capacity = json->capacity * 2 + n;
+    }
+    json->size += n;
+}
+
+char *arTraceDump( int pid )
+{
+    ARTraceEventT  *events;
+    ARTraceBuffer  *buffer;
+    ARTraceJSON     json;
+    unsigned int    head, tail, first, written, i;
+    int             count = 0;
+
+    events = (ARTraceEventT *)malloc( sizeof(ARTraceEventT) * AR_TRACE_BUFFER_SIZE );
+    if( events == NULL ) return NULL;
+    json.capacity = 4096;
+    json.size = 0;
+    json.data = (char *)malloc( json.capacity );
+    append( &json, "{\"traceEvents\":[" );
+
+    for( buffer = atomic_load( &buffers ); buffer != NULL; buffer = buffer->next ) {
+        head = atomic_load_explicit( &buffer->head, memory_order_acquire );
+        tail = atomic_load( &buffer->tail );
+        first = head - tail > AR_TRACE_BUFFER_SIZE ? head - AR_TRACE_BUFFER_SIZE : tail;
+        for( i = first; i != head; i++ ) {
+            ARTraceSlotT *slot = &buffer->events[i % AR_TRACE_BUFFER_SIZE];
+            events[i - first].ts = atomic_load_explicit( &slot->ts, memory_order_relaxed );
+            events[i - first].name = atomic_load_explicit( &slot->name, memory_order_relaxed );
+            events[i - first].phase = atomic_load_explicit( &slot->phase, memory_order_relaxed );
+        }
+
+        // The owner may have overwritten the oldest events while they were copied: the slot of event
+        // written is being written, those of the events up to written - AR_TRACE_BUFFER_SIZE were.
+        atomic_thread_fence( memory_order_acquire );
+        written = atomic_load_explicit( &buffer->head, memory_order_relaxed );
+        i = written - first >= AR_TRACE_BUFFER_SIZE ? written - first - AR_TRACE_BUFFER_SIZE + 1 : 0;
+        if( i > head - first ) i = head - first;
+
+        append( &json, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                count++ ? "," : "", pid, buffer->tid, buffer->tid );
+        for( ; i < head - first; i++ ) {
+            append( &json, ",{\"name\":\"%s\",\"cat\":\"artoolkit\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                    events[i].name, events[i].phase, events[i].ts, pid, buffer->tid );
+        }
+    }
+    append( &json, "],\"displayTimeUnit\":\"ms\"}" );
+    free( events );
+    return json.data;
+}
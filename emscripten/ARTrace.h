@@ -0,0 +1,47 @@
+/*
+ * Trace spans of the processing pipeline, dumped as Chrome trace events (chrome://tracing, Perfetto).
+ *
+ *   AR_TRACE_BEGIN("arDetectMarker");
+ *   arDetectMarker(...);
+ *   AR_TRACE_END("arDetectMarker");
+ *
+ * Tracing is off until arTraceSetEnabled(1). The events go into a ring buffer of the calling thread,
+ * which keeps the last AR_TRACE_BUFFER_SIZE events and is written without locks, so threads don't wait
+ * on each other. The buffer of a thread that ends is reused by the next new thread. arTraceDump() can
+ * be called from any thread, also while tracing. Span names must be string literals, only their
+ * pointers are stored.
+ *
+ * Disabled, a span costs a test of arTraceEnabled. Building with -D AR_TRACE_DISABLE removes them.
+ */
+
+#ifndef AR_TRACE_H
+#define AR_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AR_TRACE_BUFFER_SIZE 16384 // Events kept per thread.
+
+extern int arTraceEnabled;
+
+void arTraceSetEnabled(int enable);
+void arTraceEvent(const char *name, char phase);
+// Forgets the events recorded so far.
+void arTraceClear(void);
+// Returns the events of all threads as a Chrome trace JSON object, with the given process id,
+// to be freed by the caller.
+char *arTraceDump(int pid);
+
+#ifdef AR_TRACE_DISABLE
+#define AR_TRACE_BEGIN(name) do {} while (0)
+#define AR_TRACE_END(name) do {} while (0)
+#else
+#define AR_TRACE_BEGIN(name) do { if (arTraceEnabled) arTraceEvent((name), 'B'); } while (0)
+#define AR_TRACE_END(name) do { if (arTraceEnabled) arTraceEvent((name), 'E'); } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif // AR_TRACE_H
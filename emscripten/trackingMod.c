@@ -37,9 +37,11 @@
  *
  */
  #include "trackingMod.h"
+ #include "ARTrace.h"
  #include <AR/ar.h>
  #include <stdio.h>
  #include <stdlib.h>
+ #include <string.h>
  #ifndef _WIN32
  #include <strings.h>
  #endif
@@ -49,6 +51,29 @@
  #include <AR2/imageSet.h>
  #include <AR2/featureSet.h>
  #include <AR2/template.h>
+ #ifdef __EMSCRIPTEN__
+ #include <emscripten.h>
+ #else
+ #include <time.h>
+ #endif
+
+ // native/nft_microbench compiles this file with AR2_TRACKING_MOD_BENCH to call the kernels below directly.
+ #ifdef AR2_TRACKING_MOD_BENCH
+ #define AR2_MOD_KERNEL
+ #else
+ #define AR2_MOD_KERNEL static
+ #endif
+
+// The handles of ar2CreateHandleMod() carry the state of ar2TrackingMod() after the AR2HandleT, so controllers
+// tracking on other threads share nothing.
+typedef struct {
+    AR2HandleT            handle;
+    AR2TrackingModStatsT  stats;
+    // Scratch space for the ICP input. num never exceeds the handle's searchFeatureNum, which is
+    // capped at AR2_SEARCH_FEATURE_MAX, so tracking does not allocate per frame.
+    ICP2DCoordT           icpScreenCoord[AR2_SEARCH_FEATURE_MAX];
+    ICP3DCoordT           icpWorldCoord[AR2_SEARCH_FEATURE_MAX];
+} AR2HandleModT;
 
 AR2HandleT *ar2CreateHandleMod( ARParamLT *cparamLT, AR_PIXEL_FORMAT pixFormat/*, int threadNum*/ )
 {
@@ -69,7 +94,11 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
     AR2HandleT   *ar2Handle;
     int           i;
 
-    arMalloc(ar2Handle, AR2HandleT, 1);
+    ar2Handle = (AR2HandleT *)calloc( 1, sizeof(AR2HandleModT) );
+    if( ar2Handle == NULL ) {
+        ARLOGe("Out of memory!!\n");
+        exit(1);
+    }
     ar2Handle->pixFormat         = pixFormat;
     ar2Handle->xsize             = xsize;
     ar2Handle->ysize             = ysize;
@@ -99,38 +128,146 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
     return ar2Handle;
 }
 
- static float  ar2GetTransMat            ( ICPHandleT *icpHandle, float  initConv[3][4],
+int ar2DeleteHandleMod( AR2HandleT **ar2Handle )
+{
+    int           i;
+
+    if( ar2Handle == NULL || *ar2Handle == NULL ) return -1;
+
+    // Unlike ar2DeleteHandle(), no tracking threads to stop here.
+    for( i = 0; i < (*ar2Handle)->threadNum; i++ ) {
+        free( (*ar2Handle)->arg[i].mfImage );
+        if( (*ar2Handle)->arg[i].templ != NULL ) ar2FreeTemplate( (*ar2Handle)->arg[i].templ );
+    }
+    if( (*ar2Handle)->icpHandle != NULL ) icpDeleteHandle( &((*ar2Handle)->icpHandle) );
+
+    free( *ar2Handle );
+    *ar2Handle = NULL;
+
+    return 0;
+}
+
+int ar2ResetHandleMod( AR2HandleT *ar2Handle )
+{
+    int           i;
+
+    if( ar2Handle == NULL ) return -1;
+
+    // Templates are sized by the template size settings, which the next user may change.
+    for( i = 0; i < ar2Handle->threadNum; i++ ) {
+        if( ar2Handle->arg[i].templ != NULL ) {
+            ar2FreeTemplate( ar2Handle->arg[i].templ );
+            ar2Handle->arg[i].templ = NULL;
+        }
+    }
+    ar2Handle->searchSize        = AR2_DEFAULT_SEARCH_SIZE;
+    ar2Handle->templateSize1     = AR2_DEFAULT_TS1;
+    ar2Handle->templateSize2     = AR2_DEFAULT_TS2;
+    ar2Handle->searchFeatureNum  = AR2_DEFAULT_SEARCH_FEATURE_NUM;
+    if( ar2Handle->searchFeatureNum > AR2_SEARCH_FEATURE_MAX ) {
+        ar2Handle->searchFeatureNum = AR2_SEARCH_FEATURE_MAX;
+    }
+    ar2Handle->simThresh         = AR2_DEFAULT_SIM_THRESH;
+    ar2Handle->trackingThresh    = AR2_DEFAULT_TRACKING_THRESH;
+
+    return 0;
+}
+
+int ar2ChangeSizeMod( AR2HandleT *ar2Handle, ARParamLT *cparamLT )
+{
+    int           xsize, ysize;
+    int           i;
+
+    if( ar2Handle == NULL || cparamLT == NULL ) return -1;
+
+    xsize = cparamLT->param.xsize;
+    ysize = cparamLT->param.ysize;
+    if( xsize != ar2Handle->xsize || ysize != ar2Handle->ysize ) {
+        for( i = 0; i < ar2Handle->threadNum; i++ ) {
+            free( ar2Handle->arg[i].mfImage );
+            arMalloc( ar2Handle->arg[i].mfImage, ARUint8, xsize*ysize );
+        }
+        ar2Handle->xsize = xsize;
+        ar2Handle->ysize = ysize;
+    }
+
+    ar2Handle->cparamLT = cparamLT;
+    icpDeleteHandle( &(ar2Handle->icpHandle) );
+    ar2Handle->icpHandle = icpCreateHandle( cparamLT->param.mat );
+    icpSetInlierProbability( ar2Handle->icpHandle, 0.0 );
+
+    return 0;
+}
+
+ AR2_MOD_KERNEL float  ar2GetTransMat            ( AR2HandleT *ar2Handle, float  initConv[3][4],
                                            float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4], int robustMode );
- static float  ar2GetTransMatHomography        ( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num,
+ AR2_MOD_KERNEL float  ar2GetTransMatHomography        ( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num,
                                            float  conv[3][4], int robustMode, float inlierProb );
- static float  ar2GetTransMatHomography2       ( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4] );
- static float  ar2GetTransMatHomographyRobust  ( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4], float inlierProb );
- static int    extractVisibleFeatures    ( const ARParamLT *cparamLT, const float  trans1[][3][4], AR2SurfaceSetT *surfaceSet,
+ AR2_MOD_KERNEL float  ar2GetTransMatHomography2       ( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4] );
+ AR2_MOD_KERNEL float  ar2GetTransMatHomographyRobust  ( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4], float inlierProb );
+ AR2_MOD_KERNEL int    extractVisibleFeatures    ( const ARParamLT *cparamLT, const float  trans1[][3][4], AR2SurfaceSetT *surfaceSet,
                                            AR2TemplateCandidateT candidate[],
                                            AR2TemplateCandidateT candidate2[] );
- static int    extractVisibleFeaturesHomography( int xsize, int ysize, float  trans1[][3][4], AR2SurfaceSetT *surfaceSet,
+ AR2_MOD_KERNEL int    extractVisibleFeaturesHomography( int xsize, int ysize, float  trans1[][3][4], AR2SurfaceSetT *surfaceSet,
                                            AR2TemplateCandidateT candidate[],
                                            AR2TemplateCandidateT candidate2[] );
- static int    getDeltaS( float  H[8], float  dU[], float  J_U_H[][8], int n );
+ AR2_MOD_KERNEL int    getDeltaS( float  H[8], float  dU[], float  J_U_H[][8], int n );
+
+ static double nowMs( void )
+ {
+ #ifdef __EMSCRIPTEN__
+     return emscripten_get_now();
+ #else
+     struct timespec ts;
+     clock_gettime( CLOCK_MONOTONIC, &ts );
+     return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+ #endif
+ }
+
+ const AR2TrackingModStatsT *ar2TrackingModGetStats( const AR2HandleT *ar2Handle )
+ {
+     if( ar2Handle == NULL ) return NULL;
+     return &(((const AR2HandleModT *)ar2Handle)->stats);
+ }
+
+ static int ar2TrackingModSub( AR2HandleT *ar2Handle, AR2SurfaceSetT *surfaceSet, ARUint8 *dataPtr, float  trans[3][4], float  *err );
 
  int ar2TrackingMod( AR2HandleT *ar2Handle, AR2SurfaceSetT *surfaceSet, ARUint8 *dataPtr, float  trans[3][4], float  *err )
+ {
+     int ret;
+
+     AR_TRACE_BEGIN("ar2TrackingMod");
+     ret = ar2TrackingModSub( ar2Handle, surfaceSet, dataPtr, trans, err );
+     AR_TRACE_END("ar2TrackingMod");
+     return ret;
+ }
+
+ static int ar2TrackingModSub( AR2HandleT *ar2Handle, AR2SurfaceSetT *surfaceSet, ARUint8 *dataPtr, float  trans[3][4], float  *err )
  {
      AR2TemplateCandidateT  *candidatePtr;
      AR2TemplateCandidateT  *cp[AR2_THREAD_MAX];
  #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
      float                   aveBlur;
  #endif
+     AR2TrackingModStatsT   *stats;
      int                     num, num2;
      int                     i, j, k;
+     double                  t0, t1;
 
-     if (!ar2Handle || !surfaceSet || !dataPtr || !trans || !err) return (-1);
+     if( ar2Handle == NULL ) return -1;
+     stats = &(((AR2HandleModT *)ar2Handle)->stats);
+     memset( stats, 0, sizeof(*stats) );
+     for( i = 0; i < AR2_TRACKING_MOD_ICP_LEVELS; i++ ) stats->icpErr[i] = -1.0F;
+     stats->blurLevel = -1.0F;
+     if (!surfaceSet || !dataPtr || !trans || !err) return (stats->result = -1);
 
      if( surfaceSet->contNum <= 0  ) {
          ARLOGd("ar2Tracking() error: ar2SetInitTrans() must be called first.\n");
-         return -2;
+         return (stats->result = -2);
      }
 
      *err = 0.0F;
+     t0 = nowMs();
 
      for( i = 0; i < surfaceSet->num; i++ ) {
          arUtilMatMulf( (const float (*)[4])surfaceSet->trans1, (const float (*)[4])surfaceSet->surface[i].trans, ar2Handle->wtrans1[i] );
@@ -138,12 +275,19 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
          if( surfaceSet->contNum > 2 ) arUtilMatMulf( (const float (*)[4])surfaceSet->trans3, (const float (*)[4])surfaceSet->surface[i].trans, ar2Handle->wtrans3[i] );
      }
 
+     AR_TRACE_BEGIN("extractVisibleFeatures");
      if( ar2Handle->trackingMode == AR2_TRACKING_6DOF ) {
          extractVisibleFeatures(ar2Handle->cparamLT, ar2Handle->wtrans1, surfaceSet, ar2Handle->candidate, ar2Handle->candidate2);
      }
      else {
          extractVisibleFeaturesHomography(ar2Handle->xsize, ar2Handle->ysize, ar2Handle->wtrans1, surfaceSet, ar2Handle->candidate, ar2Handle->candidate2);
      }
+     AR_TRACE_END("extractVisibleFeatures");
+
+     for( i = 0; ar2Handle->candidate[i].flag != -1; i++ ) stats->candidateNum++;
+     t1 = nowMs();
+     stats->candidateMs = (float)(t1 - t0);
+     t0 = t1;
 
      candidatePtr = ar2Handle->candidate;
  #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
@@ -185,8 +329,10 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
          for( j = 0; j < k; j++ ) {
              {
                  AR2Tracking2DParamT* arg = &ar2Handle->arg[j];
+                 AR_TRACE_BEGIN("ar2Tracking2dSub");
                  arg->ret = ar2Tracking2dSub(arg->ar2Handle, arg->surfaceSet, arg->candidate,
                                              arg->dataPtr, arg->mfImage, &(arg->templ), &(arg->result));
+                 AR_TRACE_END("ar2Tracking2dSub");
              }
              //threadEndWait( ar2Handle->threadHandle[j] );
 
@@ -221,6 +367,7 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
  #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
                  aveBlur += ar2Handle->arg[j].result.blurLevel;
  #endif
+                 stats->simAverage += ar2Handle->arg[j].result.sim;
                  num++;
              }
          }
@@ -230,36 +377,52 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
      }
      surfaceSet->prevFeature[num].flag = -1;
  //ARLOG("------\nNum = %d\n", num);
+     t1 = nowMs();
+     stats->templateMs = (float)(t1 - t0);
+     stats->trackedNum = num;
+     if( num > 0 ) stats->simAverage /= num;
+ #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
+     if( num > 0 ) stats->blurLevel = aveBlur / num;
+ #endif
+     t0 = t1;
 
      if( ar2Handle->trackingMode == AR2_TRACKING_6DOF ) {
          if( num < 3 ) {
              surfaceSet->contNum = 0;
-             return -3;
+             return (stats->result = -3);
          }
-         *err = ar2GetTransMat( ar2Handle->icpHandle, surfaceSet->trans1, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 0 );
+         AR_TRACE_BEGIN("ar2GetTransMat");
+         *err = ar2GetTransMat( ar2Handle, surfaceSet->trans1, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 0 );
+         stats->icpErr[stats->icpLevel++] = *err;
  //ARLOG("outlier  0%%: err = %f, num = %d\n", *err, num);
          if( *err > ar2Handle->trackingThresh ) {
              icpSetInlierProbability( ar2Handle->icpHandle, 0.8F );
-             *err = ar2GetTransMat( ar2Handle->icpHandle, trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1 );
+             *err = ar2GetTransMat( ar2Handle, trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1 );
+             stats->icpErr[stats->icpLevel++] = *err;
  //ARLOG("outlier 20%%: err = %f, num = %d\n", *err, num);
              if( *err > ar2Handle->trackingThresh ) {
                  icpSetInlierProbability( ar2Handle->icpHandle, 0.6F );
-                 *err = ar2GetTransMat( ar2Handle->icpHandle, trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1 );
+                 *err = ar2GetTransMat( ar2Handle, trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1 );
+                 stats->icpErr[stats->icpLevel++] = *err;
  //ARLOG("outlier 60%%: err = %f, num = %d\n", *err, num);
                  if( *err > ar2Handle->trackingThresh ) {
                      icpSetInlierProbability( ar2Handle->icpHandle, 0.4F );
-                     *err = ar2GetTransMat( ar2Handle->icpHandle, trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1 );
+                     *err = ar2GetTransMat( ar2Handle, trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1 );
+                     stats->icpErr[stats->icpLevel++] = *err;
  //ARLOG("outlier 60%%: err = %f, num = %d\n", *err, num);
                      if( *err > ar2Handle->trackingThresh ) {
                          icpSetInlierProbability( ar2Handle->icpHandle, 0.0F );
-                         *err = ar2GetTransMat( ar2Handle->icpHandle, trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1 );
+                         *err = ar2GetTransMat( ar2Handle, trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1 );
+                         stats->icpErr[stats->icpLevel++] = *err;
  //ARLOG("outlier Max: err = %f, num = %d\n", *err, num);
                          if( *err > ar2Handle->trackingThresh ) {
                              surfaceSet->contNum = 0;
  #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
                              if( ar2Handle->blurMethod == AR2_ADAPTIVE_BLUR ) ar2Handle->blurLevel = AR2_DEFAULT_BLUR_LEVEL; // Reset the blurLevel.
  #endif
-                             return -4;
+                             stats->icpMs = (float)(nowMs() - t0);
+                             AR_TRACE_END("ar2GetTransMat");
+                             return (stats->result = -4);
                          }
                      }
                  }
@@ -269,28 +432,36 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
      else {
          if( num < 3 ) {
              surfaceSet->contNum = 0;
-             return -3;
+             return (stats->result = -3);
          }
+         AR_TRACE_BEGIN("ar2GetTransMatHomography");
          *err = ar2GetTransMatHomography( surfaceSet->trans1, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 0, 1.0F );
+         stats->icpErr[stats->icpLevel++] = *err;
  //ARLOG("outlier  0%%: err = %f, num = %d\n", *err, num);
          if( *err > ar2Handle->trackingThresh ) {
              *err = ar2GetTransMatHomography( trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1, 0.8F );
+             stats->icpErr[stats->icpLevel++] = *err;
  //ARLOG("outlier 20%%: err = %f, num = %d\n", *err, num);
              if( *err > ar2Handle->trackingThresh ) {
                  *err = ar2GetTransMatHomography( trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1, 0.6F );
+                 stats->icpErr[stats->icpLevel++] = *err;
  //ARLOG("outlier 40%%: err = %f, num = %d\n", *err, num);
                  if( *err > ar2Handle->trackingThresh ) {
                      *err = ar2GetTransMatHomography( trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1, 0.4F );
+                     stats->icpErr[stats->icpLevel++] = *err;
  //ARLOG("outlier 60%%: err = %f, num = %d\n", *err, num);
                      if( *err > ar2Handle->trackingThresh ) {
                          *err = ar2GetTransMatHomography( trans, ar2Handle->pos2d, ar2Handle->pos3d, num, trans, 1, 0.0F );
+                         stats->icpErr[stats->icpLevel++] = *err;
  //ARLOG("outlier Max: err = %f, num = %d\n", *err, num);
                          if( *err > ar2Handle->trackingThresh ) {
                              surfaceSet->contNum = 0;
  #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
                              if( ar2Handle->blurMethod == AR2_ADAPTIVE_BLUR ) ar2Handle->blurLevel = AR2_DEFAULT_BLUR_LEVEL; // Reset the blurLevel.
  #endif
-                             return -4;
+                             stats->icpMs = (float)(nowMs() - t0);
+                             AR_TRACE_END("ar2GetTransMatHomography");
+                             return (stats->result = -4);
                          }
                      }
                  }
@@ -298,6 +469,9 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
          }
      }
 
+     stats->icpMs = (float)(nowMs() - t0);
+     AR_TRACE_END(ar2Handle->trackingMode == AR2_TRACKING_6DOF ? "ar2GetTransMat" : "ar2GetTransMatHomography");
+
  #if AR2_CAPABLE_ADAPTIVE_TEMPLATE
      if( ar2Handle->blurMethod == AR2_ADAPTIVE_BLUR ) {
          aveBlur = aveBlur/num + 0.5F;
@@ -321,7 +495,7 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
      return 0;
  }
 
- static int extractVisibleFeatures(const ARParamLT *cparamLT, const float  trans1[][3][4], AR2SurfaceSetT *surfaceSet,
+ AR2_MOD_KERNEL int extractVisibleFeatures(const ARParamLT *cparamLT, const float  trans1[][3][4], AR2SurfaceSetT *surfaceSet,
                                    AR2TemplateCandidateT candidate[],  // candidates inside DPI range of [mindpi, maxdpi].
                                    AR2TemplateCandidateT candidate2[]) // candidates inside DPI range of [mindpi/2, maxdpi*2].
  {
@@ -408,7 +582,7 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
      return 0;
  }
 
- static int extractVisibleFeaturesHomography(int xsize, int ysize, float  trans1[][3][4], AR2SurfaceSetT *surfaceSet,
+ AR2_MOD_KERNEL int extractVisibleFeaturesHomography(int xsize, int ysize, float  trans1[][3][4], AR2SurfaceSetT *surfaceSet,
                                        AR2TemplateCandidateT candidate[],
                                        AR2TemplateCandidateT candidate2[])
  {
@@ -493,17 +667,24 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
      return 0;
  }
 
- static float  ar2GetTransMat( ICPHandleT *icpHandle, float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num,
+ AR2_MOD_KERNEL float  ar2GetTransMat( AR2HandleT *ar2Handle, float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num,
                                float  conv[3][4], int robustMode )
  {
      ICPDataT       data;
      float          dx, dy, dz;
      ARdouble       initMat[3][4], mat[3][4];
      ARdouble       err;
+     AR2HandleModT *mod = (AR2HandleModT *)ar2Handle;
      int            i, j;
 
-     arMalloc( data.screenCoord, ICP2DCoordT, num );
-     arMalloc( data.worldCoord,  ICP3DCoordT, num );
+     if( num <= AR2_SEARCH_FEATURE_MAX ) {
+         data.screenCoord = mod->icpScreenCoord;
+         data.worldCoord  = mod->icpWorldCoord;
+     }
+     else {
+         arMalloc( data.screenCoord, ICP2DCoordT, num );
+         arMalloc( data.worldCoord,  ICP3DCoordT, num );
+     }
 
      dx = dy = dz = 0.0;
      for( i = 0; i < num; i++ ) {
@@ -532,18 +713,20 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
      initMat[2][3] = (ARdouble)(initConv[2][0] * dx + initConv[2][1] * dy + initConv[2][2] * dz + initConv[2][3]);
 
      if( robustMode == 0 ) {
-         if( icpPoint( icpHandle, &data, initMat, mat, &err ) < 0 ) {
+         if( icpPoint( ar2Handle->icpHandle, &data, initMat, mat, &err ) < 0 ) {
              err = 100000000.0F;
          }
      }
      else {
-         if( icpPointRobust( icpHandle, &data, initMat, mat, &err ) < 0 ) {
+         if( icpPointRobust( ar2Handle->icpHandle, &data, initMat, mat, &err ) < 0 ) {
              err = 100000000.0F;
          }
      }
 
-     free( data.screenCoord );
-     free( data.worldCoord );
+     if( data.screenCoord != mod->icpScreenCoord ) {
+         free( data.screenCoord );
+         free( data.worldCoord );
+     }
 
      for( j = 0; j < 3; j++ ) {
          for( i = 0; i < 3; i++ ) conv[j][i] = (float)mat[j][i];
@@ -555,7 +738,7 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
      return (float)err;
  }
 
- static float  ar2GetTransMatHomography( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num,
+ AR2_MOD_KERNEL float  ar2GetTransMatHomography( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num,
                                    float  conv[3][4], int robustMode, float inlierProb )
  {
      if( robustMode == 0 ) {
@@ -566,7 +749,7 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
      }
  }
 
- static float  ar2GetTransMatHomography2( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4] )
+ AR2_MOD_KERNEL float  ar2GetTransMatHomography2( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4] )
  {
      float         err = 100000000.0F;
      float        *J_U_H;
@@ -671,7 +854,7 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
      return 0;
  }
 
- static float  ar2GetTransMatHomographyRobust  ( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4], float inlierProb )
+ AR2_MOD_KERNEL float  ar2GetTransMatHomographyRobust  ( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4], float inlierProb )
  {
      float         err = 100000000.0F;
      float        *J_U_H;
@@ -832,7 +1015,7 @@ AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int th
      return err1;
  }
 
- static int getDeltaS( float  H[8], float  dU[], float  J_U_H[][8], int n )
+ AR2_MOD_KERNEL int getDeltaS( float  H[8], float  dU[], float  J_U_H[][8], int n )
  {
      ARMatf  matH, matU, matJ;
      ARMatf *matJt, *matJtJ, *matJtU;
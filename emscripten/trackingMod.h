@@ -64,16 +64,62 @@
 extern "C" {
 #endif
 
+#define    AR2_TRACKING_MOD_ICP_LEVELS         5
+
+/*!
+    @typedef AR2TrackingModStatsT
+    @abstract Timings (ms), counters and quality of the last ar2TrackingMod() call.
+    @field result The return value: 0 tracked, -1 invalid arguments, -2 ar2SetInitTrans() not called,
+        -3 fewer than 3 features matched, -4 error above the tracking threshold at every level of the cascade.
+    @field candidateMs Projection of the surface features into the frame (candidate extraction).
+    @field templateMs Template selection and matching.
+    @field icpMs Pose estimation, all levels of the robust cascade.
+    @field candidateNum Visible features the templates were selected from.
+    @field trackedNum Features matched above the similarity threshold.
+    @field simAverage Average similarity of the matched features.
+    @field blurLevel Average blur level of the matched features, -1 without adaptive templates.
+    @field icpLevel Pose estimations run, 1 if the first was below the tracking threshold, up to 5; 0 if not reached.
+    @field icpErr Error after each pose estimation: without outlier rejection, then with inlier
+        probabilities 0.8, 0.6, 0.4 and 0.0; -1 for the levels not reached.
+ */
+typedef struct {
+    int    result;
+    float  candidateMs;
+    float  templateMs;
+    float  icpMs;
+    int    candidateNum;
+    int    trackedNum;
+    float  simAverage;
+    float  blurLevel;
+    int    icpLevel;
+    float  icpErr[AR2_TRACKING_MOD_ICP_LEVELS];
+} AR2TrackingModStatsT;
+
 int ar2Tracking2dSub ( AR2HandleT *handle, AR2SurfaceSetT *surfaceSet, AR2TemplateCandidateT *candidate,
                               ARUint8 *dataPtr, ARUint8 *mfImage, AR2TemplateT **templ,
                               AR2Tracking2DResultT *result );
 
 AR2HandleT *ar2CreateHandleMod( ARParamLT *cparamLT, AR_PIXEL_FORMAT pixFormat/*, int threadNum*/ );
 AR2HandleT *ar2CreateHandleSubMod( int pixFormat, int xsize, int ysize/*, int threadNum*/ );
+int         ar2DeleteHandleMod( AR2HandleT **ar2Handle );
+int         ar2ResetHandleMod( AR2HandleT *ar2Handle );
+int         ar2ChangeSizeMod( AR2HandleT *ar2Handle, ARParamLT *cparamLT );
 
 int             ar2TrackingMod              ( AR2HandleT *ar2Handle, AR2SurfaceSetT *surfaceSet,
                                            ARUint8 *dataPtr, float  trans[3][4], float  *err );
 int             ar2SetInitTrans          ( AR2SurfaceSetT *surfaceSet, float  trans[3][4]    );
+const AR2TrackingModStatsT *ar2TrackingModGetStats( const AR2HandleT *ar2Handle );
+
+#ifdef AR2_TRACKING_MOD_BENCH
+// The kernels of ar2TrackingMod(), only visible outside trackingMod.c in the build of native/nft_microbench.
+float  ar2GetTransMat                  ( AR2HandleT *ar2Handle, float  initConv[3][4],
+                                         float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4], int robustMode );
+float  ar2GetTransMatHomography2       ( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4] );
+float  ar2GetTransMatHomographyRobust  ( float  initConv[3][4], float  pos2d[][2], float  pos3d[][3], int num, float  conv[3][4], float inlierProb );
+int    extractVisibleFeatures          ( const ARParamLT *cparamLT, const float  trans1[][3][4], AR2SurfaceSetT *surfaceSet,
+                                         AR2TemplateCandidateT candidate[], AR2TemplateCandidateT candidate2[] );
+int    getDeltaS                       ( float  H[8], float  dU[], float  J_U_H[][8], int n );
+#endif
 
 #ifdef __cplusplus
 }
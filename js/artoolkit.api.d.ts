@@ -11,6 +11,7 @@ export declare interface artoolkit {
     public static readonly AR_TEMPLATE_MATCHING_COLOR_AND_MATRIX;
     public static readonly AR_TEMPLATE_MATCHING_MONO_AND_MATRIX;
     public readonly frameMalloc: FrameMalloc;
+    readCapture(buffer: ArrayBuffer | Uint8Array): Capture;
 }
 
 export class ARController {
@@ -49,9 +50,10 @@ export class ARController {
     marker_transform_mat: any;
     videoLumaPointer: any;
 
-    constructor(width: number, height: number, cameraData: string | ARCameraParam);
+    constructor(width: number, height: number, cameraData: string | ARCameraParam, memoryPlan?: MemoryPlan);
 
     onload(): void;
+    resize(width: number, height: number): number;
     debugSetup(): void;
     process(image: any): void;
     getCameraMatrix(): ArrayLike<number>;
@@ -59,6 +61,16 @@ export class ARController {
     debugDraw(): void;
     getMarkerNum(): number;
     getMarker(index: number): ARMarkerInfo;
+    getFrameStats(): FrameStats;
+    getNFTTrackingInfo(): NFTTrackingInfo;
+    setNFTSearchFeatureNum(num: number): void;
+    getNFTSearchFeatureNum(): number;
+    resetTracking(): void;
+    startCapture(options?: { rgba?: boolean, maxFrames?: number }): void;
+    stopCapture(): Uint8Array;
+    loadCaptureFrame(frame: CaptureFrame): void;
+    replayFrame(frame: CaptureFrame): string[];
+    static fromCapture(capture: Capture | ArrayBuffer | Uint8Array, onSuccess: (arController: ARController, markerIds: number[]) => void, onError?: (error: any) => void): void;
     getTransMatSquare(markerIndex: number, markerWidth: number, dst: Float64Array): void;
     getTransMatSquareCont(markerIndex: number, markerWidth: number, previousMarkerTransform: Float64Array, dst: Float64Array): void;
     transMatToGLMat(transMat: Float64Array, glMat?: Float64Array | Float64Array, scale?: number): Float64Array;
@@ -145,6 +157,13 @@ declare interface GetUserMediaARControllerConfig{
     facingMode : string | object;
 }
 
+export declare interface MemoryPlan {
+    maxWidth?: number;
+    maxHeight?: number;
+    maxPatterns?: number;
+    maxSearchFeatureNum?: number;
+}
+
 export declare interface FrameMalloc {
     framepointer: number;
     framesize: number;
@@ -153,6 +172,79 @@ export declare interface FrameMalloc {
     videoLumaPointer: number;
 }
 
+/**
+ * Timings in ms and counters of the last frame, see ARController.getFrameStats().
+ */
+export declare interface FrameStats {
+    frameNum: number;
+    lumaMs: number;
+    detectMs: number;
+    labelNum: number;
+    candidateQuadNum: number;
+    markerNum: number;
+    squarePoseMs: number;
+    squarePoseNum: number;
+    multiPoseMs: number;
+    multiPoseNum: number;
+    kpmMs: number;
+    kpmResultNum: number;
+    ar2CandidateMs: number;
+    ar2TemplateMs: number;
+    ar2IcpMs: number;
+    ar2CandidateNum: number;
+    ar2TrackedFeatureNum: number;
+    ar2IcpLevel: number;
+}
+
+/**
+ * Quality of the NFT tracking in the last frame, see ARController.getNFTTrackingInfo().
+ */
+export declare interface NFTTrackingInfo {
+    markerIndex: number;
+    result: number;
+    error: number;
+    candidateNum: number;
+    trackedNum: number;
+    simAverage: number;
+    blurLevel: number;
+    icpLevel: number;
+    icpErr: number[];
+    searchFeatureNum: number;
+    simThresh: number;
+    trackingThresh: number;
+}
+
+/**
+ * Capture log recorded with ARController.startCapture(), see artoolkit.readCapture().
+ */
+export declare interface Capture {
+    width: number;
+    height: number;
+    rgba: boolean;
+    files: { path: string, data: Uint8Array }[];
+    settings: {
+        thresholdMode: number;
+        threshold: number;
+        patternDetectionMode: number;
+        matrixCodeType: number;
+        labelingMode: number;
+        imageProcMode: number;
+        pattRatio: number;
+        nftSearchFeatureNum: number;
+    };
+    markers: { type: number, path: string }[];
+    frames: CaptureFrame[];
+}
+
+export declare interface CaptureFrame {
+    time: number;
+    nftDetect: boolean;
+    luma: Uint8Array;
+    rgba: Uint8Array | null;
+    markers: { idPatt: number, idMatrix: number, dir: number, cf: number, pos: number[] }[];
+    nft: { index: number, found: number, pose: Float32Array }[];
+}
+
 //export declare interface ARControllerStatic{}
 
 export declare class ARCameraParam {
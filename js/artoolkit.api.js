@@ -4,8 +4,10 @@
     var scope;
     if (typeof window !== 'undefined') {
         scope = window;
-    } else {
+    } else if (typeof self !== 'undefined') {
         scope = self;
+    } else {
+        scope = global; // node.js
     };
     if (scope.artoolkit_wasm_url) {
         var downloadWasm = function(url) {
@@ -60,14 +62,22 @@
 		If the camera argument is an URL, it is loaded into a new ARCameraParam, and the ARController dispatches
 		a 'load' event and calls the onload method if it is defined.
 
+		The optional memory plan declares the controller's limits up front so that its working memory is
+		reserved once: { maxWidth, maxHeight, maxPatterns, maxSearchFeatureNum }. Frame buffers are sized for
+		maxWidth x maxHeight, so resize() within that does not reallocate them. Combine it with a build made with
+		`node tools/makem.js --no-memory-growth` to keep the heap at a fixed size. KPM, AR2 and the pose estimation
+		still allocate scratch memory every frame and KPM keeps its image pyramids once the first frame is processed,
+		so the heap must cover those on top of the plan; setupWithMemoryPlan() in emscripten/ARToolKitJS.cpp lists them.
+
 	 	@exports ARController
 	 	@constructor
 
 		@param {number} width The width of the images to process.
 		@param {number} height The height of the images to process.
 		@param {ARCameraParam | string} camera The ARCameraParam to use for image processing. If this is a string, the ARController treats it as an URL and tries to load it as a ARCameraParam definition file, calling ARController#onload on success.
+		@param {Object} [memoryPlan] Optional limits for the controller, see above.
 	*/
-    var ARController = function (width, height, cameraPara) {
+    var ARController = function (width, height, cameraPara, memoryPlan) {
         this.id = undefined;
         var w = width, h = height;
 
@@ -77,6 +87,7 @@
 
         if (typeof width !== 'number') {
             var image = width;
+            memoryPlan = cameraPara;
             cameraPara = height;
             w = image.videoWidth || image.width;
             h = image.videoHeight || image.height;
@@ -106,6 +117,8 @@
         this.videoHeight = h;
         this.videoSize = this.videoWidth * this.videoHeight;
 
+        this.memoryPlan = memoryPlan || null;
+
         this.framepointer = null;
         this.framesize = null;
         this.dataHeap = null;
@@ -115,6 +128,10 @@
         this.videoLumaPointer = null;
         this._bwpointer = undefined;
         this._lumaCtx = undefined;
+        this._nft = null; // Controller in the NFT module, see _initNFTModule.
+        this._lumaMs = 0; // See getFrameStats.
+        this._markerSources = []; // Files of the loaded markers, see startCapture.
+        this._capture = null;
 
         if (typeof cameraPara === 'string') {
             this.cameraParam = new ARCameraParam(cameraPara, function () {
@@ -140,6 +157,9 @@
         if (this.id > -1) {
             artoolkit.teardown(this.id);
         }
+        if (this._nft) {
+            this._nft.module.teardown(this._nft.id);
+        }
 
         if (this.image && this.image.srcObject) {
             ARController._teardownVideo(this.image);
@@ -150,6 +170,49 @@
         }
     };
 
+	/**
+		Changes the size of the images passed to process, e.g. after a device rotation or a camera stream
+		resolution change. Unlike disposing and re-creating the ARController, the loaded pattern, multimarker
+		and NFT markers and the detection settings are kept.
+
+		@param {number} width The new image width.
+		@param {number} height The new image height.
+		@return {number} 0 on success, a negative value on error.
+	*/
+    ARController.prototype.resize = function (width, height) {
+        var ret = artoolkit.resizeController(this.id, width, height);
+        if (ret < 0) {
+            return ret;
+        }
+
+        this.width = width;
+        this.height = height;
+        this.videoWidth = width;
+        this.videoHeight = height;
+        this.videoSize = this.videoWidth * this.videoHeight;
+
+        if (this.canvas) {
+            this.canvas.width = width;
+            this.canvas.height = height;
+        }
+        if (this._lumaCtx) {
+            this._lumaCtx.canvas.width = width;
+            this._lumaCtx.canvas.height = height;
+        }
+        if (this._bwpointer) {
+            this._bwpointer = this.getProcessingImage();
+        }
+
+        this._initFrameViews();
+
+        if (this._nft) {
+            this._nft.module.resizeController(this._nft.id, width, height);
+            this._initNFTFrameViews();
+        }
+
+        return 0;
+    };
+
 	/**
 		Detects markers in the given image. The process method dispatches marker detection events during its run.
 
@@ -194,8 +257,11 @@
             console.error("detectMarker error: " + result);
         }
 
-        // get markers
+        // get markers, with the poses of those whose width is registered estimated in one call
         var markerNum = this.getMarkerNum();
+        if (markerNum > 0) {
+            this.getTransMatSquareBatch();
+        }
         var k, o;
         for (k in this.patternMarkers) {
             o = this.patternMarkers[k]
@@ -237,7 +303,10 @@
                 }
             }
 
-            if (markerType !== artoolkit.UNKNOWN_MARKER && visible.inPrevious) {
+            var batched = markerType !== artoolkit.UNKNOWN_MARKER && this.squarePoseTypes[i] === markerType;
+            if (batched) {
+                visible.matrix.set(this.squarePoses.subarray(i * 12, i * 12 + 12));
+            } else if (markerType !== artoolkit.UNKNOWN_MARKER && visible.inPrevious) {
                 this.getTransMatSquareCont(i, visible.markerWidth, visible.matrix, visible.matrix);
             } else {
                 this.getTransMatSquare(i, visible.markerWidth, visible.matrix);
@@ -245,7 +314,7 @@
 
             visible.inCurrent = true;
             this.transMatToGLMat(visible.matrix, this.transform_mat);
-            this.transformGL_RH = this.arglCameraViewRHf(this.transform_mat);
+            this.transformGL_RH = batched ? this.squarePosesGL.subarray(i * 16, i * 16 + 16) : this.arglCameraViewRHf(this.transform_mat);
             this.dispatchEvent({
                 name: 'getMarker',
                 target: this,
@@ -313,49 +382,44 @@
             }
         }
 
-        // detect multiple markers
+        // detect multiple markers, estimating in one call the poses of those with a sub-marker in view
         var multiMarkerCount = this.getMultiMarkerCount();
+        if (multiMarkerCount > 0) {
+            this.getTransMatMultiSquareBatch(true);
+        }
         for (var i = 0; i < multiMarkerCount; i++) {
+            if (this.multiMarkerVisibleNum[i] === 0) {
+                continue;
+            }
             var subMarkerCount = this.getMultiMarkerPatternCount(i);
-            var visible = false;
 
-            artoolkit.getTransMatMultiSquareRobust(this.id, i);
-            this.transMatToGLMat(this.marker_transform_mat, this.transform_mat);
+            this.transMatToGLMat(this.multiMarkerPoses.subarray(i * 12, i * 12 + 12), this.transform_mat);
             this.transformGL_RH = this.arglCameraViewRHf(this.transform_mat);
+            this.dispatchEvent({
+                name: 'getMultiMarker',
+                target: this,
+                data: {
+                    multiMarkerId: i,
+                    matrix: this.transform_mat,
+                    matrixGL_RH: this.transformGL_RH
+                }
+            });
 
             for (var j = 0; j < subMarkerCount; j++) {
                 var multiEachMarkerInfo = this.getMultiEachMarker(i, j);
-                if (multiEachMarkerInfo.visible >= 0) {
-                    visible = true;
-                    this.dispatchEvent({
-                        name: 'getMultiMarker',
-                        target: this,
-                        data: {
-                            multiMarkerId: i,
-                            matrix: this.transform_mat,
-                            matrixGL_RH: this.transformGL_RH
-                        }
-                    });
-                    break;
-                }
-            }
-            if (visible) {
-                for (var j = 0; j < subMarkerCount; j++) {
-                    var multiEachMarkerInfo = this.getMultiEachMarker(i, j);
-                    this.transMatToGLMat(this.marker_transform_mat, this.transform_mat);
-                    this.transformGL_RH = this.arglCameraViewRHf(this.transform_mat);
-                    this.dispatchEvent({
-                        name: 'getMultiMarkerSub',
-                        target: this,
-                        data: {
-                            multiMarkerId: i,
-                            markerIndex: j,
-                            marker: multiEachMarkerInfo,
-                            matrix: this.transform_mat,
-                            matrixGL_RH: this.transformGL_RH
-                        }
-                    });
-                }
+                this.transMatToGLMat(this.marker_transform_mat, this.transform_mat);
+                this.transformGL_RH = this.arglCameraViewRHf(this.transform_mat);
+                this.dispatchEvent({
+                    name: 'getMultiMarkerSub',
+                    target: this,
+                    data: {
+                        multiMarkerId: i,
+                        markerIndex: j,
+                        marker: multiEachMarkerInfo,
+                        matrix: this.transform_mat,
+                        matrixGL_RH: this.transformGL_RH
+                    }
+                });
             }
         }
 
@@ -368,7 +432,14 @@
     with the given tracked id.
   */
     ARController.prototype.detectNFTMarker = function () {
-        artoolkit.detectNFTMarker(this.id);
+        if (this._capture && this._capture.frame) {
+            this._capture.frame.nftDetect = true;
+        }
+        if (this._nft) {
+            this._nft.module.detectNFTMarker(this._nft.id);
+        } else if (artoolkit.detectNFTMarker) { // Not in the square marker build until an NFT marker is loaded.
+            artoolkit.detectNFTMarker(this.id);
+        }
     }
 
 	/**
@@ -385,6 +456,7 @@
 	*/
     ARController.prototype.trackPatternMarkerId = function (id, markerWidth) {
         var obj = this.patternMarkers[id];
+        var registered = !!obj;
         if (!obj) {
             this.patternMarkers[id] = obj = {
                 inPrevious: false,
@@ -397,6 +469,10 @@
         if (markerWidth) {
             obj.markerWidth = markerWidth;
         }
+        // For getTransMatSquareBatch once the controller is set up, until then process() poses the marker by itself.
+        if (id >= 0 && this.id >= 0 && (!registered || markerWidth)) {
+            artoolkit.setSquareMarkerWidth(this.id, artoolkit.PATTERN_MARKER, id, obj.markerWidth);
+        }
         return obj;
     };
 
@@ -414,6 +490,7 @@
 	*/
     ARController.prototype.trackBarcodeMarkerId = function (id, markerWidth) {
         var obj = this.barcodeMarkers[id];
+        var registered = !!obj;
         if (!obj) {
             this.barcodeMarkers[id] = obj = {
                 inPrevious: false,
@@ -426,6 +503,10 @@
         if (markerWidth) {
             obj.markerWidth = markerWidth;
         }
+        // For getTransMatSquareBatch once the controller is set up, until then process() poses the marker by itself.
+        if (id >= 0 && this.id >= 0 && (!registered || markerWidth)) {
+            artoolkit.setSquareMarkerWidth(this.id, artoolkit.BARCODE_MARKER, id, obj.markerWidth);
+        }
         return obj;
     };
 
@@ -554,8 +635,12 @@
 		@param {function} onError - The error callback. Called with the encountered error if the load fails.
 	*/
     ARController.prototype.loadMarker = function (markerURL, onSuccess, onError) {
+        var self = this;
         if (markerURL) {
-            artoolkit.addMarker(this.id, markerURL, onSuccess, onError);
+            artoolkit.addMarker(this.id, markerURL, function (id, filename) {
+                self._markerSources.push({ type: CAPTURE_MARKER_PATTERN, path: filename, files: [filename], fs: FS });
+                if (onSuccess) onSuccess(id);
+            }, onError);
         }
         else {
             if (onError) {
@@ -572,16 +657,34 @@
 
 		arController.loadNFTMarker(markerURL, onSuccess, onError);
 
+		With the square marker build (artoolkit_wasm_square.js), the first call loads the NFT module
+		artoolkit_nft.js from the directory of artoolkit_wasm_url, or from artoolkit_nft_url if it is set.
+
 		@param {string} markerURLs - List of The URL prefix of the NFT markers to load.
 		@param {function} onSuccess - The success callback. Called with the id of the loaded marker on a successful load.
 		@param {function} onError - The error callback. Called with the encountered error if the load fails.
 	*/
     ARController.prototype.loadNFTMarkers = function (markerURLs, onSuccess, onError) {
         var self = this;
-        artoolkit.addNFTMarkers(this.id, markerURLs, function(ids) {
+        if (!artoolkit.setupAR2 && !this._nft) {
+            loadNFTModule(function (nftModule) {
+                if (!self._nft) {
+                    self._initNFTModule(nftModule);
+                }
+                self.loadNFTMarkers(markerURLs, onSuccess, onError);
+            }, onError);
+            return;
+        }
+        var id = this._nft ? this._nft.id : this.id;
+        var module = this._nft ? this._nft.module : Module;
+        var fs = this._nft ? module.FS : FS;
+        artoolkit.addNFTMarkers(id, markerURLs, function(ids, prefixes) {
             self.nftMarkerCount += ids.length;
+            prefixes.forEach(function (prefix) {
+                self._markerSources.push({ type: CAPTURE_MARKER_NFT, path: prefix, files: [prefix + '.fset', prefix + '.iset', prefix + '.fset3'], fs: fs });
+            });
             onSuccess(ids);
-        }, onError);
+        }, onError, module);
     };
 
     // backward compatible for loading single marker. can use loadNFTMarkers instead
@@ -611,7 +714,11 @@
 		@param {function} onError - The error callback. Called with the encountered error if the load fails.
 	*/
     ARController.prototype.loadMultiMarker = function (markerURL, onSuccess, onError) {
-        return artoolkit.addMultiMarker(this.id, markerURL, onSuccess, onError);
+        var self = this;
+        return artoolkit.addMultiMarker(this.id, markerURL, function (id, markerNum, files) {
+            self._markerSources.push({ type: CAPTURE_MARKER_MULTI, path: files[0], files: files, fs: FS });
+            if (onSuccess) onSuccess(id, markerNum);
+        }, onError);
     };
 
 	/**
@@ -625,6 +732,7 @@
 	 */
     ARController.prototype.getTransMatSquare = function (markerUID, markerWidth, dst) {
         artoolkit.getTransMatSquare(this.id, markerUID, markerWidth);
+        this._checkHeapViews();
         dst.set(this.marker_transform_mat);
         return dst;
     };
@@ -641,12 +749,80 @@
 	 * @return	{Float64Array} The dst array.
 	 */
     ARController.prototype.getTransMatSquareCont = function (markerUID, markerWidth, previousMarkerTransform, dst) {
+        this._checkHeapViews();
         this.marker_transform_mat.set(previousMarkerTransform);
         artoolkit.getTransMatSquareCont(this.id, markerUID, markerWidth);
+        this._checkHeapViews();
         dst.set(this.marker_transform_mat);
         return dst;
     };
 
+  /**
+    Estimates the poses of all the square markers of the last detectMarker whose id has a width registered (by
+    trackPatternMarkerId and trackBarcodeMarkerId, which process() calls), in one call to the native code: from the
+    marker's pose of the previous frame when it had one (as getTransMatSquareCont does), from scratch otherwise.
+    The direction of each marker is set to that of its pattern or matrix code first. process() calls it.
+
+    The pose of the marker of index i is then this.squarePoses.subarray(i * 12, i * 12 + 12), a 3x4 matrix,
+    this.squarePoseTypes[i] its type (artoolkit.PATTERN_MARKER or artoolkit.BARCODE_MARKER, -1 if it was not
+    estimated) and this.squarePoseErrors[i] its error. this.squarePosesGL.subarray(i * 16, i * 16 + 16) is the pose
+    as a column-major OpenGL right-handed model-view matrix (the matrixGL_RH of the getMarker event), in float32. The
+    arrays are views on the heap, overwritten by the next call. See setPoseFilter to smooth the poses.
+
+    @return {number} The number of poses estimated.
+  */
+    ARController.prototype.getTransMatSquareBatch = function () {
+        var num = artoolkit.getTransMatSquareBatch(this.id);
+        this._checkHeapViews();
+        return num;
+    };
+
+  /**
+    Smooths the poses of getTransMatSquareBatch, so those of process(), with a low-pass filter per marker run by the
+    native code (arFilterTransMat). Lower cutoff frequencies reduce the jitter more, and add more lag. A marker's
+    filter restarts when it wasn't found in the previous frame. The state is kept per marker id, so when several
+    markers with the same id are in a frame, their poses are estimated each from scratch and not filtered, and the
+    filter of the id restarts in the next frame.
+
+    @param {number} cutoffFreq The cutoff frequency in Hz, 0 to turn the filtering off (the default).
+    @param {number} sampleRate The rate of the poses in Hz, the frame rate of the video [optional, 30 by default].
+    @return {number} 0 on success, -1 for a sample rate of 0 or less.
+  */
+    ARController.prototype.setPoseFilter = function (cutoffFreq, sampleRate) {
+        return artoolkit.setPoseFilter(this.id, cutoffFreq, sampleRate === undefined ? 30 : sampleRate);
+    };
+
+  /**
+    @return {number} The cutoff frequency of the pose filter in Hz, 0 when the poses are not filtered.
+  */
+    ARController.prototype.getPoseFilterCutoff = function () {
+        return artoolkit.getPoseFilterCutoff(this.id);
+    };
+
+  /**
+    Estimates the poses of all the multimarkers of this ARController in one call to the native code, robustly (as
+    getTransMatMultiSquareRobust) if robust is true. The multimarkers none of whose sub-markers is among the markers
+    of the last detectMarker are not estimated, their sub-markers are set not visible. process() calls it.
+
+    The pose of the multimarker i is then this.multiMarkerPoses.subarray(i * 12, i * 12 + 12), a 3x4 matrix,
+    this.multiMarkerVisibleNum[i] the number of its sub-markers visible (0 when it is out of view, its pose is then
+    the last one found) and this.multiMarkerErrors[i] its error (-1 when out of view). The arrays are views on the
+    heap, overwritten by the next call.
+
+    @param {boolean} robust Whether to reject the outlier sub-markers.
+    @return {number} The number of multimarkers with a visible sub-marker.
+  */
+    ARController.prototype.getTransMatMultiSquareBatch = function (robust) {
+        var num = artoolkit.getTransMatMultiSquareBatch(this.id, robust ? 1 : 0);
+        var batch = artoolkit.multiMarkerBatch;
+        var n = batch.multiMarkerNum;
+        this.multiMarkerPoses = new this._ARdoubleArray(Module.HEAPU8.buffer, batch.trans, n * 12);
+        this.multiMarkerVisibleNum = new Int32Array(Module.HEAPU8.buffer, batch.visibleNum, n);
+        this.multiMarkerErrors = new this._ARdoubleArray(Module.HEAPU8.buffer, batch.errors, n);
+        this._checkHeapViews();
+        return num;
+    };
+
 	/**
 	 * Populates the provided float array with the current transformation for the specified multimarker. After
 	 * a call to detectMarker, all marker information will be current. Marker transformations can then be
@@ -658,6 +834,7 @@
 	 */
     ARController.prototype.getTransMatMultiSquare = function (markerUID, dst) {
         artoolkit.getTransMatMultiSquare(this.id, markerUID);
+        this._checkHeapViews();
         dst.set(this.marker_transform_mat);
         return dst;
     };
@@ -672,6 +849,7 @@
 	 */
     ARController.prototype.getTransMatMultiSquareRobust = function (markerUID, dst) {
         artoolkit.getTransMatMultiSquare(this.id, markerUID);
+        this._checkHeapViews();
         dst.set(this.marker_transform_mat);
         return dst;
     };
@@ -779,7 +957,11 @@
 	*/
     ARController.prototype.detectMarker = function (image) {
         if (this._copyImageToHeap(image)) {
-            return artoolkit.detectMarker(this.id);
+            var ret = artoolkit.detectMarker(this.id);
+            if (this._capture) {
+                this._captureFrame();
+            }
+            return ret;
         }
         return -99;
     };
@@ -845,11 +1027,344 @@
     @returns {Object} The NFTmarkerInfo struct.
   */
     ARController.prototype.getNFTMarker = function (markerIndex) {
-        if (0 === artoolkit.getNFTMarker(this.id, markerIndex)) {
+        var ret = this._nft ? this._nft.module.getNFTMarker(this._nft.id, markerIndex) : artoolkit.getNFTMarker(this.id, markerIndex);
+        if (0 === ret) {
+            if (this._capture && this._capture.frame) {
+                this._capture.frame.nft.push(captureNFTResult(markerIndex, artoolkit.NFTMarkerInfo));
+            }
             return artoolkit.NFTMarkerInfo;
         }
     };
 
+  /**
+    Returns the timings (in ms) and counters of the last frame processed, for profiling and telemetry:
+
+        {
+            frameNum,                  // frames processed since the controller was created
+            lumaMs,                    // luma conversion of the frame in _copyImageToHeap
+            detectMs,                  // detectMarker(): thresholding, labeling, pattern and matrix decoding
+            labelNum, candidateQuadNum, markerNum,
+            roiNum,                    // regions scanned around the last markers or the coarse quads, 0 for a full frame scan
+            coarseFactor,              // downscaling of the labeling, 1 at full resolution, see setCoarseDetectionFactor
+            threshold,                 // labeling threshold of the frame, unused in the adaptive threshold mode
+            pattShortlistNum,          // patterns left by the pattern index to correlate with the quads, -1 without, see setPatternIndexEnabled
+            trackedMarkerNum,          // square markers tracked from the last frame instead of detected, see setCornerTrackingInterval
+            squarePoseMs, squarePoseNum,
+            multiPoseMs, multiPoseNum,
+            kpmMs, kpmResultNum,       // detectNFTMarker(): KPM feature extraction and matching, 0 and -1 while tracking
+            ar2CandidateMs, ar2TemplateMs, ar2IcpMs,
+            ar2CandidateNum, ar2TrackedFeatureNum,
+            ar2IcpLevel                // 1-5, the level of the robust ICP cascade AR2 tracking stopped at
+        }
+
+    The pose times add up over the getTransMat* calls made since the last detectMarker().
+    The returned object is a copy and is not updated by later frames.
+
+    @returns {Object} The frame statistics.
+  */
+    ARController.prototype.getFrameStats = function () {
+        var stats = {};
+        var k;
+        artoolkit.getFrameStats(this.id);
+        for (k in artoolkit.frameStats) {
+            stats[k] = artoolkit.frameStats[k];
+        }
+        if (this._nft) {
+            // The NFT stages run in the NFT module.
+            this._nft.module.getFrameStats(this._nft.id);
+            for (k in artoolkit.frameStats) {
+                if (k.indexOf('kpm') === 0 || k.indexOf('ar2') === 0) {
+                    stats[k] = artoolkit.frameStats[k];
+                }
+            }
+        }
+        stats.lumaMs = this._lumaMs;
+        return stats;
+    };
+
+  /**
+    Returns the quality of the NFT tracking in the last frame:
+
+        {
+            markerIndex,        // the NFT marker tracked, -1 if none (no marker loaded or still being detected by KPM)
+            result,             // 0 tracked, -3 fewer than 3 features matched, -4 error above trackingThresh after the cascade
+            error,              // final tracking error
+            candidateNum,       // visible features
+            trackedNum,         // features matched above simThresh
+            simAverage,         // average similarity of the matched features
+            blurLevel,          // average blur level of the matched features, -1 without adaptive templates
+            icpLevel,           // pose estimations run in the robust cascade (1-5)
+            icpErr,             // error after each: no outlier rejection, inlier probability 0.8, 0.6, 0.4 and 0.0; -1 if not run
+            searchFeatureNum, simThresh, trackingThresh  // current AR2 settings
+        }
+
+    The returned object is the global artoolkit.NFTTrackingInfo object and will be overwritten
+    by subsequent calls.
+
+    @returns {Object} The NFT tracking info.
+  */
+    ARController.prototype.getNFTTrackingInfo = function () {
+        if (this._nft) {
+            this._nft.module.getNFTTrackingInfo(this._nft.id);
+        } else if (artoolkit.getNFTTrackingInfo) {
+            artoolkit.getNFTTrackingInfo(this.id);
+        }
+        return artoolkit.NFTTrackingInfo;
+    };
+
+  /**
+    Sets the number of features NFT tracking matches per frame (16 by default), e.g. lower while tracking
+    is stable to save time and higher when it degrades. Capped by the maxSearchFeatureNum of the memory plan.
+    @param {number} num The number of features.
+  */
+    ARController.prototype.setNFTSearchFeatureNum = function (num) {
+        if (this._nft) {
+            this._nft.module.setNFTSearchFeatureNum(this._nft.id, num);
+        } else if (artoolkit.setNFTSearchFeatureNum) {
+            artoolkit.setNFTSearchFeatureNum(this.id, num);
+        }
+    };
+
+  /**
+    @returns {number} The number of features NFT tracking matches per frame, -1 without NFT.
+  */
+    ARController.prototype.getNFTSearchFeatureNum = function () {
+        if (this._nft) {
+            return this._nft.module.getNFTSearchFeatureNum(this._nft.id);
+        }
+        return artoolkit.getNFTSearchFeatureNum ? artoolkit.getNFTSearchFeatureNum(this.id) : -1;
+    };
+
+  /**
+    Forgets the state carried from frame to frame (square marker history, auto threshold interval and the
+    tracked NFT marker), so the next frame is processed as by a new controller.
+    @return {number} 0 (void)
+  */
+    ARController.prototype.resetTracking = function () {
+        artoolkit.resetTracking(this.id);
+        if (this._nft) {
+            this._nft.module.resetTracking(this._nft.id);
+        }
+    };
+
+  /**
+    Starts recording the frames passed to detectMarker() into a capture log, to reproduce field issues
+    offline with ARController.fromCapture() or artoolkit_cli -r. The log holds the camera parameters,
+    the files of the markers loaded so far, the detection settings and, for every frame, the luma image
+    (and with { rgba: true } the RGBA image), the square markers detected and the results of the
+    getNFTMarker() calls.
+
+    The tracking state is reset when the capture starts, so that a replay starts from the same state.
+    Luma frames are enough to replay mono and matrix code detection and NFT exactly; replaying color
+    pattern matching (AR_TEMPLATE_MATCHING_COLOR, the default) needs { rgba: true }.
+
+    @param {Object} [options] { rgba: false, maxFrames: 300 }. Frames after maxFrames are not recorded.
+    @return {number} 0 (void)
+  */
+    ARController.prototype.startCapture = function (options) {
+        options = options || {};
+        var rgba = !!options.rgba;
+        var writer = new CaptureWriter();
+        var files = [camera_files[this.cameraParam.id]];
+        var fsOf = [FS];
+        var i, j;
+
+        this.resetTracking();
+
+        writer.u32(CAPTURE_MAGIC);
+        writer.u32(CAPTURE_VERSION);
+        writer.u32(this.width);
+        writer.u32(this.height);
+        writer.u32(rgba ? CAPTURE_FLAG_RGBA : 0);
+
+        for (i = 0; i < this._markerSources.length; i++) {
+            var source = this._markerSources[i];
+            for (j = 0; j < source.files.length; j++) {
+                if (files.indexOf(source.files[j]) === -1) {
+                    files.push(source.files[j]);
+                    fsOf.push(source.fs);
+                }
+            }
+        }
+        var capturePath = capturePathMapper(files.concat(this._markerSources.map(function (source) { return source.path; })));
+        writer.u32(files.length);
+        for (i = 0; i < files.length; i++) {
+            writer.string(capturePath(files[i]));
+            var data = fsOf[i].readFile(files[i], { encoding: 'binary' });
+            writer.u32(data.length);
+            writer.bytes(data);
+        }
+
+        writer.i32(this.getThresholdMode());
+        writer.i32(this.getThreshold());
+        writer.i32(this.getPatternDetectionMode());
+        writer.i32(this.getMatrixCodeType());
+        writer.i32(this.getLabelingMode());
+        writer.i32(this.getImageProcMode());
+        writer.f32(this.getPattRatio());
+        writer.i32(this.getNFTSearchFeatureNum());
+
+        writer.u32(this._markerSources.length);
+        for (i = 0; i < this._markerSources.length; i++) {
+            writer.u8(this._markerSources[i].type);
+            writer.string(capturePath(this._markerSources[i].path));
+        }
+
+        this._capture = {
+            writer: writer,
+            rgba: rgba,
+            maxFrames: options.maxFrames || 300,
+            frameNum: 0,
+            start: now(),
+            frame: null
+        };
+    };
+
+  /**
+    Stops the capture started by startCapture().
+    @return {Uint8Array} The capture log, undefined if no capture was started.
+  */
+    ARController.prototype.stopCapture = function () {
+        var capture = this._capture;
+        if (!capture) return;
+        this._flushCaptureFrame();
+        this._capture = null;
+        return capture.writer.result();
+    };
+
+    ARController.prototype._captureFrame = function () {
+        var capture = this._capture;
+        this._flushCaptureFrame();
+        if (capture.frameNum >= capture.maxFrames) return;
+        capture.frameNum++;
+
+        var frame = {
+            time: now() - capture.start,
+            nftDetect: false,
+            luma: this.videoLuma.slice(),
+            rgba: capture.rgba ? this.dataHeap.slice() : null,
+            markers: [],
+            nft: []
+        };
+        var markerNum = artoolkit.getMarkerNum(this.id);
+        for (var i = 0; i < markerNum; i++) {
+            artoolkit.getMarker(this.id, i);
+            var info = artoolkit.markerInfo;
+            frame.markers.push({ idPatt: info.idPatt, idMatrix: info.idMatrix, dir: info.dir, cf: info.cf, pos: [info.pos[0], info.pos[1]] });
+        }
+        capture.frame = frame;
+    };
+
+    // The NFT results of a frame are known once the application is done with it, at the next detectMarker().
+    ARController.prototype._flushCaptureFrame = function () {
+        var capture = this._capture;
+        var frame = capture.frame;
+        if (!frame) return;
+        capture.frame = null;
+
+        var writer = capture.writer;
+        var i, k;
+        writer.f64(frame.time);
+        writer.u32(frame.nftDetect ? CAPTURE_FRAME_NFT_DETECT : 0);
+        writer.bytes(frame.luma);
+        if (capture.rgba) writer.bytes(frame.rgba);
+        writer.u32(frame.markers.length);
+        for (i = 0; i < frame.markers.length; i++) {
+            var marker = frame.markers[i];
+            writer.i32(marker.idPatt);
+            writer.i32(marker.idMatrix);
+            writer.i32(marker.dir);
+            writer.f32(marker.cf);
+            writer.f32(marker.pos[0]);
+            writer.f32(marker.pos[1]);
+        }
+        writer.u32(frame.nft.length);
+        for (i = 0; i < frame.nft.length; i++) {
+            var nft = frame.nft[i];
+            writer.i32(nft.index);
+            writer.i32(nft.found);
+            for (k = 0; k < 12; k++) writer.f32(nft.pose[k]);
+        }
+    };
+
+  /**
+    Copies a frame of a capture log (see artoolkit.readCapture) to the controller, in place of
+    _copyImageToHeap. Frames captured without RGBA are copied as gray RGBA images made from the luma.
+    @param {Object} frame A frame of capture.frames.
+    @return {number} 0 (void)
+  */
+    ARController.prototype.loadCaptureFrame = function (frame) {
+        this._checkHeapViews();
+        this.videoLuma.set(frame.luma);
+        if (frame.rgba) {
+            this.dataHeap.set(frame.rgba);
+        } else {
+            var data = this.dataHeap;
+            for (var p = 0, q = 0; p < this.videoSize; p++, q += 4) {
+                data[q] = data[q + 1] = data[q + 2] = frame.luma[p];
+                data[q + 3] = 255;
+            }
+        }
+        if (this._nft) {
+            this._checkNFTHeapViews();
+            this._nft.dataHeap.set(this.dataHeap);
+            this._nft.videoLuma.set(frame.luma);
+        }
+    };
+
+  /**
+    Processes a frame of a capture log like the application did when it was recorded: detectMarker(),
+    detectNFTMarker() if it was called and getNFTMarker() for the NFT markers it was called for, then
+    compares the results with the recorded ones. The controller must come from ARController.fromCapture()
+    and the frames be replayed in order.
+
+    @param {Object} frame A frame of capture.frames.
+    @return {Array} The differences with the recorded results, as strings. Empty if the results are the same.
+  */
+    ARController.prototype.replayFrame = function (frame) {
+        var differences = [];
+        var differ = function (what, value, recorded) {
+            differences.push(what + ' ' + value + ', recorded ' + recorded);
+        };
+        var i, k;
+
+        this.loadCaptureFrame(frame);
+        artoolkit.detectMarker(this.id);
+
+        var markerNum = artoolkit.getMarkerNum(this.id);
+        if (markerNum !== frame.markers.length) {
+            differ('marker count', markerNum, frame.markers.length);
+        }
+        for (i = 0; i < Math.min(markerNum, frame.markers.length); i++) {
+            artoolkit.getMarker(this.id, i);
+            var info = artoolkit.markerInfo, recorded = frame.markers[i];
+            ['idPatt', 'idMatrix', 'dir'].forEach(function (key) {
+                if (info[key] !== recorded[key]) differ('marker ' + i + ' ' + key, info[key], recorded[key]);
+            });
+            if (Math.abs(info.cf - recorded.cf) > CAPTURE_TOLERANCE) differ('marker ' + i + ' cf', info.cf, recorded.cf);
+            for (k = 0; k < 2; k++) {
+                if (Math.abs(info.pos[k] - recorded.pos[k]) > CAPTURE_TOLERANCE) differ('marker ' + i + ' pos[' + k + ']', info.pos[k], recorded.pos[k]);
+            }
+        }
+
+        if (frame.nftDetect) {
+            this.detectNFTMarker();
+        }
+        for (i = 0; i < frame.nft.length; i++) {
+            var nft = frame.nft[i];
+            var result = this.getNFTMarker(nft.index);
+            var found = result ? result.found : 0;
+            if (found !== nft.found) {
+                differ('NFT marker ' + nft.index + ' found', found, nft.found);
+                continue;
+            }
+            for (k = 0; found && k < 12; k++) {
+                if (Math.abs(result.pose[k] - nft.pose[k]) > CAPTURE_TOLERANCE) differ('NFT marker ' + nft.index + ' pose[' + k + ']', result.pose[k], nft.pose[k]);
+            }
+        }
+        return differences;
+    };
+
 	/**
 		Set marker vertices to the given vertexData[4][2] array.
 
@@ -863,6 +1378,7 @@
 	 	@param {*} vertexData
 	*/
     ARController.prototype.setMarkerInfoVertex = function (markerIndex, vertexData) {
+        this._checkHeapViews();
         for (var i = 0; i < vertexData.length; i++) {
             this.marker_transform_mat[i * 2 + 0] = vertexData[i][0];
             this.marker_transform_mat[i * 2 + 1] = vertexData[i][1];
@@ -924,6 +1440,7 @@
 	 * @return {Float64Array} The 16-element WebGL camera matrix for the ARController camera parameters.
 	 */
     ARController.prototype.getCameraMatrix = function () {
+        this._checkHeapViews();
         return this.camera_mat;
     };
 
@@ -934,6 +1451,7 @@
 		@return {Float64Array} The 12-element 3x4 row-major marker transformation matrix used by ARToolKit.
 	*/
     ARController.prototype.getMarkerTransformationMatrix = function () {
+        this._checkHeapViews();
         return this.marker_transform_mat;
     };
 
@@ -986,6 +1504,41 @@
         return artoolkit.getLogLevel();
     };
 
+  /**
+    Starts or stops recording trace spans of the pipeline stages: arDetectMarker, kpmMatching, ar2TrackingMod
+    and its steps, and the pose solvers. Off by default, and almost free when off.
+    The spans are recorded for all the controllers of the page, see getTrace.
+
+    @param {boolean} enable true to record the spans.
+  */
+    ARController.prototype.setTraceEnabled = function (enable) {
+        artoolkit.setTraceEnabled(enable ? 1 : 0);
+        if (this._nft) this._nft.module.setTraceEnabled(enable ? 1 : 0);
+    };
+
+  /**
+    Returns the spans recorded since the last clearTrace() in the Chrome trace event format: save it with
+    JSON.stringify() and open it in chrome://tracing or https://ui.perfetto.dev. The spans of the NFT module
+    (artoolkit_nft.js) have pid 2. Each thread keeps its last 16384 events.
+
+    @return {Object} The trace, { traceEvents: [...] }.
+  */
+    ARController.prototype.getTrace = function () {
+        var trace = JSON.parse(artoolkit.getTrace(1));
+        if (this._nft) {
+            trace.traceEvents = trace.traceEvents.concat(JSON.parse(this._nft.module.getTrace(2)).traceEvents);
+        }
+        return trace;
+    };
+
+  /**
+    Forgets the spans recorded so far.
+  */
+    ARController.prototype.clearTrace = function () {
+        artoolkit.clearTrace();
+        if (this._nft) this._nft.module.clearTrace();
+    };
+
   /**
     Sets the dir (direction) of the marker. Direction that tells about the rotation
     about the marker (possible values are 0, 1, 2 or 3).
@@ -1044,11 +1597,35 @@
 	        AR_LABELING_THRESH_MODE_AUTO_OTSU,
 	        AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE,
 	        AR_LABELING_THRESH_MODE_AUTO_BRACKETING
+
+	    AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE compares each pixel with the mean of the 9x9 box around it, minus 7,
+	    which keeps markers in uneven lighting. setFastAdaptiveThresholdEnabled makes it cost about as much as the
+	    manual mode.
 	 */
     ARController.prototype.setThresholdMode = function (mode) {
         return artoolkit.setThresholdMode(this.id, mode);
     };
 
+  /**
+    Makes the AR_LABELING_THRESH_MODE_AUTO_MEDIAN and AR_LABELING_THRESH_MODE_AUTO_OTSU thresholds cheaper:
+    the histogram is taken from a grid of pixels instead of the whole frame, and only every interval frames
+    or when the mean brightness of the frame shifts by more than maxBrightnessShift. The estimates are smoothed
+    over time (threshold = smoothing * threshold + (1 - smoothing) * estimate), a brightness shift is followed at once.
+    getFrameStats().threshold reports the threshold of each frame.
+
+        arController.setThresholdEstimation({ sampleStep: 4, interval: 15, maxBrightnessShift: 10, smoothing: 0.5 });
+
+    @param {Object} options { sampleStep, interval (default 1), maxBrightnessShift (default 0, never), smoothing
+        (default 0, in [0, 1)) }. A sampleStep of 0 (default) restores the full frame thresholds of ARToolKit.
+    @return {number} 0, -1 if an option is out of range.
+  */
+    ARController.prototype.setThresholdEstimation = function (options) {
+        options = options || {};
+        return artoolkit.setThresholdEstimation(this.id, options.sampleStep || 0,
+            options.interval === undefined ? 1 : options.interval,
+            options.maxBrightnessShift || 0, options.smoothing || 0);
+    };
+
 	/**
 	 * Gets the current threshold mode used for image binarization.
 	 * @return	{number}		The current threshold mode
@@ -1260,6 +1837,164 @@
         return artoolkit.getImageProcMode(this.id);
     };
 
+  /**
+    Sets how often detectMarker scans the whole frame for square markers. In the frames in between, the markers
+    identified in the previous frame are only looked for in regions around them, which skips most of the labeling
+    of large frames when few markers are tracked. New markers appear at the next full scan; when a marker is lost,
+    the next frame is scanned in full. getFrameStats().roiNum tells which frames were scanned in regions.
+
+    The debug mode, the field image mode and the adaptive threshold mode always scan in full. The other auto
+    threshold modes keep the threshold of the last full scan.
+
+    @param {number} frames Frames between two full scans, 0 (default) or 1 to scan every frame in full.
+    @return {number} 0, -1 if frames is negative.
+  */
+    ARController.prototype.setROIFullScanInterval = function (frames) {
+        return artoolkit.setROIFullScanInterval(this.id, frames);
+    };
+
+  /**
+    Gets the number of frames between two full scans, see setROIFullScanInterval.
+
+    @return {number} The interval, 0 if every frame is scanned in full.
+  */
+    ARController.prototype.getROIFullScanInterval = function () {
+        return artoolkit.getROIFullScanInterval(this.id);
+    };
+
+  /**
+    Sets the factor the frame is downscaled by before the square marker detection thresholds and labels it.
+    The quads found are extracted again at full resolution, in regions around them, before their pattern is
+    read, so the marker corners keep their full resolution accuracy while most of the labeling runs on a 4 or
+    16 times smaller image. Markers smaller than about 8 * factor pixels are missed.
+
+    The auto median and Otsu thresholds are computed on the downscaled frame, at the auto threshold interval.
+    The debug mode, the field image mode and the adaptive and bracketing threshold modes label at full resolution.
+    getFrameStats().coarseFactor tells which frames were labeled downscaled.
+
+    @param {number} factor 1 (default, full resolution), 2 or 4.
+    @return {number} 0, -1 if the factor is not supported.
+  */
+    ARController.prototype.setCoarseDetectionFactor = function (factor) {
+        return artoolkit.setCoarseDetectionFactor(this.id, factor);
+    };
+
+  /**
+    Gets the downscaling factor of the square marker labeling, see setCoarseDetectionFactor.
+
+    @return {number} 1, 2 or 4.
+  */
+    ARController.prototype.getCoarseDetectionFactor = function () {
+        return artoolkit.getCoarseDetectionFactor(this.id);
+    };
+
+  /**
+    Sets the number of threads the square marker labeling is split across. The frame is cut into horizontal strips
+    labeled concurrently, then the labels crossing the strips are joined, which gives the labels, contours and
+    markers of the single threaded labeling. Only artoolkit_wasm_mt.js (built with tools/makem.js --pthreads) and
+    the native build run the strips in parallel, the other builds label them one after the other. The threads are
+    started by this call and kept until the thread count changes or the controller is disposed.
+
+    The debug mode, the field image mode and the bracketing threshold mode label in a single thread, and so does the
+    adaptive threshold mode unless setFastAdaptiveThresholdEnabled is on.
+    With more than one thread (or with the fast adaptive threshold), the tracking history of arDetectMarker (which keeps the ids of markers whose pattern
+    was not read in the frame) is not used, like with setROIFullScanInterval.
+
+    @param {number} threadNum 1 (default) to 16.
+    @return {number} 0, -1 if threadNum is out of range or the threads could not be set up.
+  */
+    ARController.prototype.setLabelingThreadNum = function (threadNum) {
+        return artoolkit.setLabelingThreadNum(this.id, threadNum);
+    };
+
+  /**
+    Gets the number of threads of the square marker labeling, see setLabelingThreadNum.
+
+    @return {number} The number of threads.
+  */
+    ARController.prototype.getLabelingThreadNum = function () {
+        return artoolkit.getLabelingThreadNum(this.id);
+    };
+
+  /**
+    Speeds up AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE: the mean of the box around each pixel is computed with running
+    box sums as the frame is binarized, which costs about as much as the manual threshold, and the binarized frame
+    is labeled like with setLabelingThreadNum. The markers and their vertices are those of arDetectMarker, but its
+    tracking history (which keeps the ids of markers whose pattern was not read in the frame) is not used, so a
+    marker whose pattern is misread in a frame is reported unidentified.
+
+    The debug mode and the field image mode always use arDetectMarker.
+
+    @param {boolean} enable true to use the fast adaptive threshold, false (default) to detect with arDetectMarker.
+    @return {number} 0
+  */
+    ARController.prototype.setFastAdaptiveThresholdEnabled = function (enable) {
+        return artoolkit.setFastAdaptiveThresholdEnabled(this.id, enable ? 1 : 0);
+    };
+
+  /**
+    Gets whether the adaptive threshold mode uses the fast adaptive threshold, see setFastAdaptiveThresholdEnabled.
+
+    @return {number} 1 if enabled, 0 otherwise.
+  */
+    ARController.prototype.getFastAdaptiveThresholdEnabled = function () {
+        return artoolkit.getFastAdaptiveThresholdEnabled(this.id);
+    };
+
+  /**
+    Enables the index of the template patterns, for large pattern libraries. The pattern read from each quad is
+    correlated in full only with the patterns whose correlation bound, computed from 4 x 4 block sums, comes close to
+    the best correlation found, instead of with every pattern in its four orientations. The markers found are the
+    same as without the index; only the pattern id and confidence of quads below the confidence cutoff may differ.
+    The index is built on the first frame after patterns are loaded. getFrameStats().pattShortlistNum reports the
+    patterns left to correlate.
+
+    The debug mode, the field image mode and the bracketing threshold mode match all the patterns, and like with
+    setLabelingThreadNum the tracking history of arDetectMarker is not used with the index.
+
+    @param {boolean} enable true to match the patterns through the index, false (default) to match them all.
+    @return {number} 0
+  */
+    ARController.prototype.setPatternIndexEnabled = function (enable) {
+        return artoolkit.setPatternIndexEnabled(this.id, enable ? 1 : 0);
+    };
+
+  /**
+    Gets whether the template patterns are matched through the index, see setPatternIndexEnabled.
+
+    @return {number} 1 if enabled, 0 otherwise.
+  */
+    ARController.prototype.getPatternIndexEnabled = function () {
+        return artoolkit.getPatternIndexEnabled(this.id);
+    };
+
+  /**
+    Tracks the corners of the identified square markers from frame to frame instead of detecting them, with the
+    pyramidal Lucas-Kanade optical flow on the luma: tracked frames skip the labeling and the pattern matching, and
+    the markers keep the id, direction and confidence they were detected with. The markers are detected again, which
+    verifies their patterns, every given number of frames, and on the next frame as soon as a corner is lost or a
+    quad degenerates. Markers entering the view are only found by these detections. The tracked corners can be fed
+    to getTransMatSquareCont like detected ones. getFrameStats().trackedMarkerNum reports the markers tracked.
+
+    The debug mode and the field image mode detect the markers in every frame.
+
+    @param {number} frames 0 (default) to detect the markers in every frame, otherwise the number of frames
+      between detections, 1 included.
+    @return {number} 0, -1 if frames is negative.
+  */
+    ARController.prototype.setCornerTrackingInterval = function (frames) {
+        return artoolkit.setCornerTrackingInterval(this.id, frames);
+    };
+
+  /**
+    Gets the number of frames between detections of the tracked square markers, see setCornerTrackingInterval.
+
+    @return {number} The interval, 0 if the markers are not tracked.
+  */
+    ARController.prototype.getCornerTrackingInterval = function () {
+        return artoolkit.getCornerTrackingInterval(this.id);
+    };
+
 
 	/**
 		Draw the black and white image and debug markers to the ARController canvas.
@@ -1303,20 +2038,17 @@
       @return {number} 0 (void)
     */
     ARController.prototype._initialize = function () {
-        this.id = artoolkit.setup(this.width, this.height, this.cameraParam.id);
+        if (this.memoryPlan) {
+            var plan = this.memoryPlan;
+            this.id = artoolkit.setupWithMemoryPlan(this.width, this.height, this.cameraParam.id,
+                plan.maxWidth || 0, plan.maxHeight || 0, plan.maxPatterns || 0, plan.maxSearchFeatureNum || 0);
+        } else {
+            this.id = artoolkit.setup(this.width, this.height, this.cameraParam.id);
+        }
 
         this._initNFT();
 
-        var params = artoolkit.frameMalloc;
-        this.framepointer = params.framepointer;
-        this.framesize = params.framesize;
-        this.videoLumaPointer = params.videoLumaPointer;
-
-        this.dataHeap = new Uint8Array(Module.HEAPU8.buffer, this.framepointer, this.framesize);
-        this.videoLuma = new Uint8Array(Module.HEAPU8.buffer, this.videoLumaPointer, this.framesize / 4);
-
-        this.camera_mat = new Float64Array(Module.HEAPU8.buffer, params.camera, 16);
-        this.marker_transform_mat = new Float64Array(Module.HEAPU8.buffer, params.transform, 12);
+        this._initFrameViews();
 
         this.setProjectionNearPlane(0.1)
         this.setProjectionFarPlane(1000);
@@ -1332,12 +2064,109 @@
         }.bind(this), 1);
     };
 
+  /**
+    Creates the typed array views on the frame, luma, camera and transform buffers reported in artoolkit.frameMalloc.
+    @return {number} 0 (void)
+  */
+    ARController.prototype._initFrameViews = function () {
+        var params = artoolkit.frameMalloc;
+        this.framepointer = params.framepointer;
+        this.framesize = params.framesize;
+        this.videoLumaPointer = params.videoLumaPointer;
+        this._cameraPointer = params.camera;
+        this._transformPointer = params.transform;
+        this._squarePosesPointer = params.squarePoses;
+        this._squarePoseTypesPointer = params.squarePoseTypes;
+        this._squarePoseErrorsPointer = params.squarePoseErrors;
+        this._squarePoseMax = params.squarePoseMax;
+        this._squarePosesGLPointer = params.squarePosesGL;
+        // ARdouble is float in the ARDOUBLE_IS_FLOAT build.
+        this._ARdoubleArray = params.ardoubleSize === 4 ? Float32Array : Float64Array;
+
+        this._createHeapViews();
+    };
+
+    ARController.prototype._createHeapViews = function () {
+        this.dataHeap = new Uint8Array(Module.HEAPU8.buffer, this.framepointer, this.framesize);
+        this.videoLuma = new Uint8Array(Module.HEAPU8.buffer, this.videoLumaPointer, this.framesize / 4);
+
+        this.camera_mat = new this._ARdoubleArray(Module.HEAPU8.buffer, this._cameraPointer, 16);
+        this.marker_transform_mat = new this._ARdoubleArray(Module.HEAPU8.buffer, this._transformPointer, 12);
+        this.squarePoses = new this._ARdoubleArray(Module.HEAPU8.buffer, this._squarePosesPointer, this._squarePoseMax * 12);
+        this.squarePoseTypes = new Int32Array(Module.HEAPU8.buffer, this._squarePoseTypesPointer, this._squarePoseMax);
+        this.squarePoseErrors = new this._ARdoubleArray(Module.HEAPU8.buffer, this._squarePoseErrorsPointer, this._squarePoseMax);
+        this.squarePosesGL = new Float32Array(Module.HEAPU8.buffer, this._squarePosesGLPointer, this._squarePoseMax * 16);
+    };
+
+  /**
+    Re-creates the heap views if the Emscripten heap has grown since they were made. Growing the heap
+    replaces Module.HEAPU8.buffer and leaves the old views detached.
+    @return {number} 0 (void)
+  */
+    ARController.prototype._checkHeapViews = function () {
+        if (this.dataHeap && this.dataHeap.buffer !== Module.HEAPU8.buffer) {
+            this._createHeapViews();
+        }
+    };
+
   /**
     Init the necessary kpm handle for NFT and the settings for the CPU.
     @return {number} 0 (void)
   */
     ARController.prototype._initNFT = function () {
-        artoolkit.setupAR2(this.id);
+        // The square marker build has no NFT, see _initNFTModule.
+        if (artoolkit.setupAR2) {
+            artoolkit.setupAR2(this.id);
+        }
+    };
+
+  /**
+    Creates the controller's counterpart in the NFT module, with the same size and camera parameters.
+    The frames are copied to it in _copyImageToHeap and the NFT functions are called on it.
+    @return {number} 0 (void)
+  */
+    ARController.prototype._initNFTModule = function (nftModule) {
+        var cameraFile = camera_files[this.cameraParam.id];
+        nftModule.FS.writeFile(cameraFile, FS.readFile(cameraFile), { encoding: 'binary' });
+        var cameraID = nftModule._loadCamera(cameraFile);
+
+        var id;
+        if (this.memoryPlan) {
+            var plan = this.memoryPlan;
+            id = nftModule.setupWithMemoryPlan(this.width, this.height, cameraID,
+                plan.maxWidth || 0, plan.maxHeight || 0, plan.maxPatterns || 0, plan.maxSearchFeatureNum || 0);
+        } else {
+            id = nftModule.setup(this.width, this.height, cameraID);
+        }
+        nftModule.setupAR2(id);
+        nftModule.setTraceEnabled(artoolkit.getTraceEnabled());
+
+        this._nft = { module: nftModule, id: id };
+        this._initNFTFrameViews();
+    };
+
+  /**
+    Creates the views on the NFT module's frame and luma buffers. Its setup writes them to artoolkit.frameMalloc
+    like the main module's.
+    @return {number} 0 (void)
+  */
+    ARController.prototype._initNFTFrameViews = function () {
+        var params = artoolkit.frameMalloc;
+        var nft = this._nft;
+        nft.framepointer = params.framepointer;
+        nft.framesize = params.framesize;
+        nft.videoLumaPointer = params.videoLumaPointer;
+        nft.dataHeap = null;
+        this._checkNFTHeapViews();
+    };
+
+    ARController.prototype._checkNFTHeapViews = function () {
+        var nft = this._nft;
+        var buffer = nft.module.HEAPU8.buffer;
+        if (!nft.dataHeap || nft.dataHeap.buffer !== buffer) {
+            nft.dataHeap = new Uint8Array(buffer, nft.framepointer, nft.framesize);
+            nft.videoLuma = new Uint8Array(buffer, nft.videoLumaPointer, nft.framesize / 4);
+        }
     };
 
   /**
@@ -1367,10 +2196,13 @@
 
             var imageData = this.ctx.getImageData(0, 0, this.canvas.width, this.canvas.height);
         }
+        this._checkHeapViews();
+
         var data = imageData.data;  // this is of type Uint8ClampedArray: The Uint8ClampedArray typed array represents an array of 8-bit unsigned integers clamped to 0-255 (https://developer.mozilla.org/en-US/docs/Web/JavaScript/Reference/Global_Objects/Uint8ClampedArray)
 
         //Here we have access to the unmodified video image. We now need to add the videoLuma chanel to be able to serve the underlying ARTK API
         if (this.videoLuma) {
+            var t0 = now();
             var q = 0;
             //Create luma from video data assuming Pixelformat AR_PIXEL_FORMAT_RGBA (ARToolKitJS.cpp L: 43)
 
@@ -1380,6 +2212,13 @@
                 this.videoLuma[p] = (r + r + r + b + g + g + g + g) >> 3;
                 q += 4;
             }
+            this._lumaMs = now() - t0;
+        }
+
+        if (this._nft) {
+            this._checkNFTHeapViews();
+            this._nft.dataHeap.set(data);
+            this._nft.videoLuma.set(this.videoLuma);
         }
 
         if (this.dataHeap) {
@@ -1431,6 +2270,101 @@
 
     // static
 
+	/**
+		Creates an ARController to replay a capture log recorded with startCapture(): writes its files to the
+		Emscripten file system, loads its camera parameters and markers and applies its detection settings.
+		Then call replayFrame() or loadCaptureFrame() for each frame of capture.frames.
+
+		ARController.fromCapture(capture, function (arController, markerIds) {
+			capture.frames.forEach(function (frame) { console.log(arController.replayFrame(frame)); });
+		});
+
+		@param {Object} capture The capture log, as an ArrayBuffer or Uint8Array or read by artoolkit.readCapture.
+		@param {function} onSuccess Called with the ARController and the ids of the markers, in the order of capture.markers.
+		@param {function} [onError] Called with the error if the camera parameters or the NFT module fail to load.
+	*/
+    ARController.fromCapture = function (capture, onSuccess, onError) {
+        if (!capture.frames) {
+            capture = readCapture(capture);
+        }
+        onError = onError || function (err) { console.error("ARController.fromCapture", err); };
+        var dir = '/capture_' + capture_count++;
+
+        var loadMarkers = function (arController) {
+            var ids = [];
+            var nftPrefixes = [], nftSlots = [];
+            var i;
+
+            writeCaptureFiles(FS, dir, capture.files);
+            if (arController._nft) {
+                writeCaptureFiles(arController._nft.module.FS, dir, capture.files);
+            }
+            for (i = 0; i < capture.markers.length; i++) {
+                var marker = capture.markers[i];
+                var path = dir + '/' + marker.path;
+                if (marker.type === CAPTURE_MARKER_PATTERN) {
+                    ids.push(Module._addMarker(arController.id, path));
+                    arController._markerSources.push({ type: marker.type, path: path, files: [path], fs: FS });
+                } else if (marker.type === CAPTURE_MARKER_MULTI) {
+                    ids.push(Module._addMultiMarker(arController.id, path));
+                    var parent = path.replace(/[^\/]*$/, '');
+                    var files = [path].concat(parseMultiFile(FS.readFile(path, { encoding: 'binary' })).map(function (file) {
+                        return parent + file;
+                    }));
+                    arController._markerSources.push({ type: marker.type, path: path, files: files, fs: FS });
+                } else {
+                    ids.push(-1);
+                    nftSlots.push(i);
+                    nftPrefixes.push(path);
+                }
+            }
+
+            if (nftPrefixes.length) {
+                var nft = arController._nft;
+                var module = nft ? nft.module : Module;
+                var fs = nft ? module.FS : FS;
+                var list = new module.StringList();
+                nftPrefixes.forEach(function (prefix) { list.push_back(prefix); });
+                var nftIds = module._addNFTMarkers(nft ? nft.id : arController.id, list);
+                for (i = 0; i < nftIds.size(); i++) {
+                    ids[nftSlots[i]] = nftIds.get(i);
+                }
+                arController.nftMarkerCount += nftIds.size();
+                nftPrefixes.forEach(function (prefix) {
+                    arController._markerSources.push({ type: CAPTURE_MARKER_NFT, path: prefix, files: [prefix + '.fset', prefix + '.iset', prefix + '.fset3'], fs: fs });
+                });
+            }
+            if (capture.settings.nftSearchFeatureNum >= 0 && nftPrefixes.length) {
+                arController.setNFTSearchFeatureNum(capture.settings.nftSearchFeatureNum);
+            }
+
+            arController.resetTracking();
+            onSuccess(arController, ids);
+        };
+
+        new ARCameraParam(capture.files[0].data, function () {
+            var arController = new ARController(capture.width, capture.height, this);
+            var settings = capture.settings;
+            arController.setThresholdMode(settings.thresholdMode);
+            arController.setThreshold(settings.threshold);
+            arController.setPatternDetectionMode(settings.patternDetectionMode);
+            arController.setMatrixCodeType(settings.matrixCodeType);
+            arController.setLabelingMode(settings.labelingMode);
+            arController.setImageProcMode(settings.imageProcMode);
+            arController.setPattRatio(settings.pattRatio);
+
+            var hasNFT = capture.markers.some(function (marker) { return marker.type === CAPTURE_MARKER_NFT; });
+            if (hasNFT && !artoolkit.setupAR2) {
+                loadNFTModule(function (nftModule) {
+                    arController._initNFTModule(nftModule);
+                    loadMarkers(arController);
+                }, onError);
+            } else {
+                loadMarkers(arController);
+            }
+        }, onError);
+    };
+
 	/**
 		ARController.getUserMedia gets a device camera video feed and calls the given onSuccess callback with it.
 
@@ -1798,19 +2732,34 @@
 
         addMarker: addMarker,
         addMultiMarker: addMultiMarker,
-        addNFTMarkers: addNFTMarkers
+        addNFTMarkers: addNFTMarkers,
+
+        readCapture: readCapture
 
     };
 
     var FUNCTIONS = [
         'setup',
+        'setupWithMemoryPlan',
         'teardown',
+        'resizeController',
 
         'setupAR2',
 
+        'clearParamLTCache',
+        'clearControllerPool',
+
         'setLogLevel',
         'getLogLevel',
 
+        'setTraceEnabled',
+        'getTraceEnabled',
+        'clearTrace',
+        'getTrace',
+
+        'getFrameStats',
+        'resetTracking',
+
         'setDebugMode',
         'getDebugMode',
 
@@ -1821,9 +2770,14 @@
 
         'getTransMatSquare',
         'getTransMatSquareCont',
+        'setSquareMarkerWidth',
+        'getTransMatSquareBatch',
+        'setPoseFilter',
+        'getPoseFilterCutoff',
 
         'getTransMatMultiSquare',
         'getTransMatMultiSquareRobust',
+        'getTransMatMultiSquareBatch',
 
         'getMultiMarkerNum',
         'getMultiMarkerCount',
@@ -1834,6 +2788,9 @@
         'detectNFTMarker',
 
         'getNFTMarker',
+        'getNFTTrackingInfo',
+        'setNFTSearchFeatureNum',
+        'getNFTSearchFeatureNum',
         'getMarker',
         'getMultiEachMarker',
 
@@ -1863,6 +2820,20 @@
 
         'setImageProcMode',
         'getImageProcMode',
+
+        'setROIFullScanInterval',
+        'getROIFullScanInterval',
+        'setCoarseDetectionFactor',
+        'getCoarseDetectionFactor',
+        'setLabelingThreadNum',
+        'getLabelingThreadNum',
+        'setFastAdaptiveThresholdEnabled',
+        'getFastAdaptiveThresholdEnabled',
+        'setThresholdEstimation',
+        'setPatternIndexEnabled',
+        'getPatternIndexEnabled',
+        'setCornerTrackingInterval',
+        'getCornerTrackingInterval',
     ];
 
     function runWhenLoaded() {
@@ -1881,28 +2852,29 @@
         var filename = '/marker_' + marker_count++;
         ajax(url, filename, function () {
             var id = Module._addMarker(arId, filename);
-            if (callback) callback(id);
+            if (callback) callback(id, filename);
         }, function (errorNumber) { if (onError) onError(errorNumber) });
     }
 
-    function addNFTMarkers(arId, urls, callback, onError) {
+    function addNFTMarkers(arId, urls, callback, onError, module) {
+        module = module || Module;
         var prefixes = [];
         var pending = urls.length * 3;
         var onSuccess = (filename) => {
             pending -= 1;
             if (pending === 0) {
-                const vec = new Module.StringList();
+                const vec = new module.StringList();
                 const markerIds = [];
                 for (let i = 0; i < prefixes.length; i++) {
                     vec.push_back(prefixes[i]);
                 }
-                var ret = Module._addNFTMarkers(arId, vec);
+                var ret = module._addNFTMarkers(arId, vec);
                 for (let i = 0; i < ret.size(); i++) {
                     markerIds.push(ret.get(i));
                 }
 
                 console.log("add nft marker ids: ", markerIds);
-                if (callback) callback(markerIds);
+                if (callback) callback(markerIds, prefixes);
             }
         }
         var onError = (filename, errorNumber) => {
@@ -1918,9 +2890,9 @@
             var filename2 = prefix + '.iset';
             var filename3 = prefix + '.fset3';
 
-            ajax(url + '.fset', filename1, onSuccess.bind(filename1), onError.bind(filename1));
-            ajax(url + '.iset', filename2, onSuccess.bind(filename2), onError.bind(filename2));
-            ajax(url + '.fset3', filename3, onSuccess.bind(filename3), onError.bind(filename3));
+            ajax(url + '.fset', filename1, onSuccess.bind(filename1), onError.bind(filename1), module.FS);
+            ajax(url + '.iset', filename2, onSuccess.bind(filename2), onError.bind(filename2), module.FS);
+            ajax(url + '.fset3', filename3, onSuccess.bind(filename3), onError.bind(filename3), module.FS);
             marker_count += 1;
         }
     }
@@ -1972,11 +2944,12 @@
         var filename = '/multi_marker_' + multi_marker_count++;
         ajax(url, filename, function (bytes) {
             var files = parseMultiFile(bytes);
+            var targets = [filename].concat(files);
 
             function ok() {
                 var markerID = Module._addMultiMarker(arId, filename);
                 var markerNum = Module.getMultiMarkerNum(arId, markerID);
-                if (callback) callback(markerID, markerNum);
+                if (callback) callback(markerID, markerNum, targets);
             }
 
             if (!files.length) return ok();
@@ -1991,6 +2964,7 @@
     }
 
     var camera_count = 0;
+    var camera_files = {}; // camera id -> file, for the NFT module
     function loadCamera(url, callback, errorCallback) {
         var filename = '/camera_param_' + camera_count++;
         var writeCallback = function (errorCode) {
@@ -1998,6 +2972,7 @@
                 if (callback) callback(id); setTimeout(writeCallback, 10);
             } else {
                 var id = Module._loadCamera(filename);
+                camera_files[id] = filename;
                 if (callback) callback(id);
             }
         };
@@ -2021,8 +2996,8 @@
         writeByteArrayToFS(target, byteArray, callback);
     }
 
-    function writeByteArrayToFS(target, byteArray, callback) {
-        FS.writeFile(target, byteArray, { encoding: 'binary' });
+    function writeByteArrayToFS(target, byteArray, callback, fs) {
+        (fs || FS).writeFile(target, byteArray, { encoding: 'binary' });
         // console.log('FS written', target);
 
         callback(byteArray);
@@ -2032,7 +3007,7 @@
     //	ajax('../bin/Data2/markers.dat', '/Data2/markers.dat', callback);
     //	ajax('../bin/Data/patt.hiro', '/patt.hiro', callback);
 
-    function ajax(url, target, callback, errorCallback) {
+    function ajax(url, target, callback, errorCallback, fs) {
         var oReq = new XMLHttpRequest();
         oReq.open('GET', url, true);
         oReq.responseType = 'arraybuffer'; // blob arraybuffer
@@ -2042,7 +3017,7 @@
                 // console.log('ajax done for ', url);
                 var arrayBuffer = oReq.response;
                 var byteArray = new Uint8Array(arrayBuffer);
-                writeByteArrayToFS(target, byteArray, callback);
+                writeByteArrayToFS(target, byteArray, callback, fs);
             }
             else {
                 errorCallback(this.status);
@@ -2063,6 +3038,271 @@
         }
     }
 
+    // Capture log, see ARController.prototype.startCapture. Little-endian:
+    //
+    //   header  'ARCL', u32 version, u32 width, u32 height, u32 flags (1: the frames include RGBA)
+    //           u32 file count, then per file: u32 length + path, u32 length + data. The first file is the camera parameters.
+    //           Paths are relative, without . or .. components, see capturePathMapper().
+    //           i32 thresholdMode, threshold, patternDetectionMode, matrixCodeType, labelingMode, imageProcMode,
+    //           f32 pattRatio, i32 nftSearchFeatureNum (-1 without NFT)
+    //           u32 marker count, then per marker: u8 type (0 pattern, 1 multimarker, 2 NFT), u32 length + path (NFT: prefix)
+    //   frames  until the end: f64 time (ms since the capture started), u32 flags (1: detectNFTMarker() was called),
+    //           luma (width * height), RGBA (width * height * 4) if the header flags say so,
+    //           u32 marker count, then per marker: i32 idPatt, i32 idMatrix, i32 dir, f32 cf, f32 pos[2]
+    //           u32 NFT result count, then per getNFTMarker() call: i32 markerIndex, i32 found, f32 pose[12]
+    //
+    // native/ARCaptureLog.cpp reads the same format for artoolkit_cli -r.
+
+    var CAPTURE_MAGIC = 0x4c435241; // 'ARCL'
+    var CAPTURE_VERSION = 2;
+    var CAPTURE_FLAG_RGBA = 1;
+    var CAPTURE_FRAME_NFT_DETECT = 1;
+    var CAPTURE_MARKER_PATTERN = 0;
+    var CAPTURE_MARKER_MULTI = 1;
+    var CAPTURE_MARKER_NFT = 2;
+    // Largest difference between replayed and recorded (float) values, also across builds.
+    var CAPTURE_TOLERANCE = 1e-3;
+
+    var capture_count = 0;
+
+    function CaptureWriter() {
+        this.buffer = new ArrayBuffer(1 << 20);
+        this.view = new DataView(this.buffer);
+        this.length = 0;
+    }
+
+    CaptureWriter.prototype.reserve = function (size) {
+        if (this.length + size <= this.buffer.byteLength) return;
+        var capacity = this.buffer.byteLength * 2;
+        while (capacity < this.length + size) capacity *= 2;
+        var buffer = new ArrayBuffer(capacity);
+        new Uint8Array(buffer).set(new Uint8Array(this.buffer, 0, this.length));
+        this.buffer = buffer;
+        this.view = new DataView(buffer);
+    };
+
+    CaptureWriter.prototype.u8 = function (value) { this.reserve(1); this.view.setUint8(this.length, value); this.length += 1; };
+    CaptureWriter.prototype.u32 = function (value) { this.reserve(4); this.view.setUint32(this.length, value, true); this.length += 4; };
+    CaptureWriter.prototype.i32 = function (value) { this.reserve(4); this.view.setInt32(this.length, value, true); this.length += 4; };
+    CaptureWriter.prototype.f32 = function (value) { this.reserve(4); this.view.setFloat32(this.length, value, true); this.length += 4; };
+    CaptureWriter.prototype.f64 = function (value) { this.reserve(8); this.view.setFloat64(this.length, value, true); this.length += 8; };
+
+    CaptureWriter.prototype.bytes = function (array) {
+        this.reserve(array.length);
+        new Uint8Array(this.buffer, this.length, array.length).set(array);
+        this.length += array.length;
+    };
+
+    CaptureWriter.prototype.string = function (string) {
+        this.u32(string.length);
+        for (var i = 0; i < string.length; i++) this.u8(string.charCodeAt(i) & 0xff);
+    };
+
+    CaptureWriter.prototype.result = function () {
+        return new Uint8Array(this.buffer.slice(0, this.length));
+    };
+
+    /**
+        Reads a capture log recorded with ARController.prototype.startCapture. The images of the frames are
+        views on the given buffer.
+
+        @param {ArrayBuffer|Uint8Array} buffer The capture log.
+        @return {Object} { width, height, rgba, files: [{ path, data }], settings, markers: [{ type, path }],
+            frames: [{ time, nftDetect, luma, rgba, markers: [{ idPatt, idMatrix, dir, cf, pos }], nft: [{ index, found, pose }] }] }
+    */
+    function readCapture(buffer) {
+        var bytes = buffer instanceof Uint8Array ? buffer : new Uint8Array(buffer);
+        var view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+        var offset = 0;
+        var u32 = function () { offset += 4; return view.getUint32(offset - 4, true); };
+        var i32 = function () { offset += 4; return view.getInt32(offset - 4, true); };
+        var f32 = function () { offset += 4; return view.getFloat32(offset - 4, true); };
+        var data = function (length) {
+            if (offset + length > bytes.length) throw new Error('readCapture: truncated capture log');
+            offset += length;
+            return bytes.subarray(offset - length, offset);
+        };
+        var string = function () { return bytesToString(data(u32())); };
+        var i, j, count;
+
+        if (bytes.length < 20 || u32() !== CAPTURE_MAGIC) throw new Error('readCapture: not a capture log');
+        var version = u32();
+        if (version !== CAPTURE_VERSION) throw new Error('readCapture: unsupported version ' + version);
+
+        var capture = { width: u32(), height: u32() };
+        capture.rgba = (u32() & CAPTURE_FLAG_RGBA) !== 0;
+
+        capture.files = [];
+        for (i = 0, count = u32(); i < count; i++) {
+            capture.files.push({ path: checkCapturePath(string()), data: data(u32()) });
+        }
+        capture.settings = {
+            thresholdMode: i32(),
+            threshold: i32(),
+            patternDetectionMode: i32(),
+            matrixCodeType: i32(),
+            labelingMode: i32(),
+            imageProcMode: i32(),
+            pattRatio: f32(),
+            nftSearchFeatureNum: i32()
+        };
+        capture.markers = [];
+        for (i = 0, count = u32(); i < count; i++) {
+            capture.markers.push({ type: data(1)[0], path: checkCapturePath(string()) });
+        }
+
+        var pixels = capture.width * capture.height;
+        capture.frames = [];
+        while (offset < bytes.length) {
+            var frame = { time: view.getFloat64(offset, true) };
+            offset += 8;
+            frame.nftDetect = (u32() & CAPTURE_FRAME_NFT_DETECT) !== 0;
+            frame.luma = data(pixels);
+            frame.rgba = capture.rgba ? data(pixels * 4) : null;
+            frame.markers = [];
+            for (i = 0, count = u32(); i < count; i++) {
+                frame.markers.push({ idPatt: i32(), idMatrix: i32(), dir: i32(), cf: f32(), pos: [f32(), f32()] });
+            }
+            frame.nft = [];
+            for (i = 0, count = u32(); i < count; i++) {
+                var nft = { index: i32(), found: i32(), pose: new Float32Array(12) };
+                for (j = 0; j < 12; j++) nft.pose[j] = f32();
+                frame.nft.push(nft);
+            }
+            capture.frames.push(frame);
+        }
+        return capture;
+    }
+
+    function captureNFTResult(markerIndex, info) {
+        var pose = new Float32Array(12);
+        if (info.found) pose.set(info.pose);
+        return { index: markerIndex, found: info.found, pose: pose };
+    }
+
+    // Paths in capture logs are relative to the directory they are replayed in, without . and .. components.
+    // The recorded paths are resolved against a working directory deep enough for the .. components of all of
+    // them, so that the paths a multimarker file names its patterns with still lead to them when replayed.
+    function capturePathMapper(paths) {
+        var depth = 0;
+        paths.forEach(function (path) {
+            var level = 0;
+            if (path.charAt(0) === '/') return;
+            path.split('/').forEach(function (part) {
+                if (part === '..') depth = Math.max(depth, -(--level));
+                else if (part !== '' && part !== '.') level++;
+            });
+        });
+        return function (path) {
+            var parts = [];
+            var i;
+            if (path.charAt(0) !== '/') {
+                for (i = 0; i < depth; i++) parts.push('_');
+            }
+            path.split('/').forEach(function (part) {
+                if (part === '..') parts.pop();
+                else if (part !== '' && part !== '.') parts.push(part);
+            });
+            return parts.join('/');
+        };
+    }
+
+    // Throws on the paths capturePathMapper() doesn't write, which would lead out of the replay directory.
+    function checkCapturePath(path) {
+        if (path === '' || path.charAt(0) === '/' || path.split('/').indexOf('..') !== -1) {
+            throw new Error('readCapture: invalid path ' + path);
+        }
+        return path;
+    }
+
+    function writeCaptureFiles(fs, dir, files) {
+        files.forEach(function (file) {
+            var path = dir + '/' + file.path;
+            fs.mkdirTree(path.replace(/\/[^\/]*$/, ''));
+            fs.writeFile(path, file.data, { encoding: 'binary' });
+        });
+    }
+
+    // NFT module of the square marker build, see ARController.prototype.loadNFTMarkers.
+
+    var nftModule = null;
+    var nftModuleCallbacks = null;
+
+    function nftModuleURL() {
+        if (scope.artoolkit_nft_url) return scope.artoolkit_nft_url;
+        if (scope.artoolkit_wasm_url) return scope.artoolkit_wasm_url.replace(/[^\/]*$/, '') + 'artoolkit_nft.js';
+        if (typeof document === 'undefined' && typeof importScripts !== 'function') return __dirname + '/artoolkit_nft.js'; // node.js
+        return 'artoolkit_nft.js';
+    }
+
+    function loadNFTModule(callback, onError) {
+        if (nftModule) {
+            callback(nftModule);
+            return;
+        }
+        if (nftModuleCallbacks) {
+            nftModuleCallbacks.push([callback, onError]);
+            return;
+        }
+        nftModuleCallbacks = [[callback, onError]];
+
+        var url = nftModuleURL();
+        var done = function (error) {
+            var callbacks = nftModuleCallbacks;
+            nftModuleCallbacks = null;
+            for (var i = 0; i < callbacks.length; i++) {
+                if (error) {
+                    if (callbacks[i][1]) callbacks[i][1](error);
+                } else {
+                    callbacks[i][0](nftModule);
+                }
+            }
+        };
+        var instantiate = function (factory) {
+            var instance = {
+                onRuntimeInitialized: function () {
+                    nftModule = instance;
+                    done();
+                }
+            };
+            // The .wasm is next to artoolkit_nft.js.
+            var dir = url.replace(/[^\/]*$/, '');
+            if (dir) {
+                instance.locateFile = function (path) { return dir + path; };
+            }
+            factory(instance);
+        };
+
+        if (typeof document !== 'undefined') {
+            var script = document.createElement('script');
+            script.src = url;
+            script.onload = function () { instantiate(scope.ARToolKitNFT); };
+            script.onerror = function () { done('Failed to load ' + url); };
+            document.head.appendChild(script);
+        } else if (typeof importScripts === 'function') {
+            try {
+                importScripts(url);
+            } catch (e) {
+                done(e);
+                return;
+            }
+            instantiate(scope.ARToolKitNFT);
+        } else {
+            var factory;
+            try {
+                factory = require(url);
+            } catch (e) {
+                done(e);
+                return;
+            }
+            instantiate(factory);
+        }
+    }
+
+    function now() {
+        return (typeof performance !== 'undefined') ? performance.now() : Date.now();
+    }
+
     /* Exports */
     scope.artoolkit = artoolkit;
     scope.ARController = ARController;
@@ -2071,11 +3311,15 @@
       scope.Module = Module;
     };
 
-    if (scope.Module) {
-        scope.Module.onRuntimeInitialized = function () {
+    // Module is the Emscripten module this file is bundled into (--pre-js). In node.js it is local to the
+    // build's module scope rather than a property of scope.
+    if (typeof Module !== 'undefined') {
+        Module.onRuntimeInitialized = function () {
             runWhenLoaded();
-            var event = new Event('artoolkit-loaded');
-            scope.dispatchEvent(event);
+            if (scope.dispatchEvent) {
+                var event = new Event('artoolkit-loaded');
+                scope.dispatchEvent(event);
+            }
         }
     } else {
         scope.Module = {
@@ -0,0 +1,113 @@
+/*
+ * Loads the fastest jsartoolkit5 WebAssembly build the browser can run.
+ *
+ * build/artoolkit_wasm_simd.js is built with -O3 and WebAssembly SIMD, build/artoolkit_wasm.js with -Oz
+ * and no SIMD. The SIMD build is picked when the browser validates a SIMD module, otherwise the
+ * size-optimized build is loaded, which is also used if the SIMD build fails to download.
+ *
+ *   <script src="js/artoolkit.loader.js"></script>
+ *   artoolkitLoader.load('build/').then(function (build) {
+ *       // ARController and artoolkit are ready, build is 'artoolkit_wasm_simd' or 'artoolkit_wasm'.
+ *   });
+ *
+ * In a web worker the build is loaded with importScripts. Pass { simd: false } as the second argument
+ * of load() to always use the size-optimized build, e.g. on low-end devices.
+ */
+;(function () {
+    'use strict'
+
+    var scope = (typeof window !== 'undefined') ? window : self;
+
+    var BASELINE_BUILD = 'artoolkit_wasm';
+    var SIMD_BUILD = 'artoolkit_wasm_simd';
+
+    // (module (func (result v128) i32.const 0 i8x16.splat i8x16.popcnt))
+    var SIMD_TEST_MODULE = new Uint8Array([
+        0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0,
+        10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11
+    ]);
+
+    function simdSupported() {
+        try {
+            return typeof WebAssembly === 'object' && WebAssembly.validate(SIMD_TEST_MODULE);
+        } catch (e) {
+            return false;
+        }
+    }
+
+    function selectBuild(options) {
+        if (options && options.simd === false) return BASELINE_BUILD;
+        return simdSupported() ? SIMD_BUILD : BASELINE_BUILD;
+    }
+
+    function loadScript(url) {
+        return new Promise(function (resolve, reject) {
+            if (typeof importScripts === 'function') {
+                try {
+                    importScripts(url);
+                    resolve();
+                } catch (e) {
+                    reject(e);
+                }
+                return;
+            }
+            var script = document.createElement('script');
+            script.src = url;
+            script.onload = function () { resolve(); };
+            script.onerror = function () { reject(new Error('Failed to load ' + url)); };
+            document.head.appendChild(script);
+        });
+    }
+
+    function loadBuild(path, build) {
+        return new Promise(function (resolve, reject) {
+            var onLoaded = function () {
+                scope.removeEventListener('artoolkit-loaded', onLoaded);
+                resolve(build);
+            };
+            scope.addEventListener('artoolkit-loaded', onLoaded);
+            // Read by artoolkit.api.js to download the matching .wasm.
+            scope.artoolkit_wasm_url = path + build + '.wasm';
+            loadScript(path + build + '.js').catch(function (e) {
+                scope.removeEventListener('artoolkit-loaded', onLoaded);
+                reject(e);
+            });
+        });
+    }
+
+    var loading = null;
+
+    /**
+        Loads artoolkit_wasm_simd.js or artoolkit_wasm.js from the given directory.
+        Calling it again returns the same promise.
+
+        @param {string} [path] Directory of the builds, with a trailing slash. Defaults to '../build/'.
+        @param {Object} [options] { simd: false } to skip the SIMD build.
+        @return {Promise} Resolves with the name of the loaded build once artoolkit is ready.
+    */
+    function load(path, options) {
+        if (loading) return loading;
+        if (path === undefined) path = '../build/';
+
+        var build = selectBuild(options);
+        loading = loadBuild(path, build).catch(function (e) {
+            if (build === BASELINE_BUILD) throw e;
+            console.warn('artoolkitLoader: ' + e.message + ', falling back to ' + BASELINE_BUILD);
+            return loadBuild(path, BASELINE_BUILD);
+        }).then(function (loaded) {
+            artoolkitLoader.build = loaded;
+            return loaded;
+        });
+        return loading;
+    }
+
+    var artoolkitLoader = {
+        simdSupported: simdSupported,
+        selectBuild: selectBuild,
+        load: load,
+        build: null
+    };
+
+    scope.artoolkitLoader = artoolkitLoader;
+
+})();
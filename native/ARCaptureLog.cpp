@@ -0,0 +1,224 @@
+#include "ARCaptureLog.h"
+
+#include <errno.h>
+#include <ftw.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static const uint32_t CAPTURE_MAGIC = 0x4c435241; // 'ARCL'
+static const uint32_t CAPTURE_VERSION = 2;
+static const uint32_t CAPTURE_FLAG_RGBA = 1;
+static const uint32_t CAPTURE_FRAME_NFT_DETECT = 1;
+
+// Little-endian reads that stop at the end of the log.
+struct Cursor {
+	const unsigned char *p;
+	size_t size;
+	size_t offset;
+	bool ok;
+
+	const unsigned char *data(size_t length) {
+		if (!ok || length > size - offset) {
+			ok = false;
+			return NULL;
+		}
+		offset += length;
+		return p + offset - length;
+	}
+
+	uint32_t u32() {
+		const unsigned char *b = data(4);
+		return b ? (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24) : 0;
+	}
+
+	int i32() {
+		return (int32_t)u32();
+	}
+
+	float f32() {
+		uint32_t bits = u32();
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	double f64() {
+		uint64_t bits = u32();
+		bits |= (uint64_t)u32() << 32;
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	std::string string() {
+		uint32_t length = u32();
+		const unsigned char *b = data(length);
+		return b ? std::string((const char *)b, length) : std::string();
+	}
+};
+
+// The paths of the log are written below the replay directory, so must not lead out of it.
+static bool capturePathValid(const std::string &path) {
+	if (path.empty() || path[0] == '/') return false;
+	for (size_t start = 0; start <= path.size(); ) {
+		size_t end = path.find('/', start);
+		if (end == std::string::npos) end = path.size();
+		if (path.compare(start, end - start, "..") == 0) return false;
+		start = end + 1;
+	}
+	return true;
+}
+
+bool readCaptureLog(const char *path, CaptureLog *log) {
+	FILE *fp = fopen(path, "rb");
+	if (fp == NULL) {
+		fprintf(stderr, "Error: can't open %s.\n", path);
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	log->bytes.resize(size > 0 ? size : 0);
+	bool read = size > 0 && fread(log->bytes.data(), 1, size, fp) == (size_t)size;
+	fclose(fp);
+	if (!read) {
+		fprintf(stderr, "Error: can't read %s.\n", path);
+		return false;
+	}
+
+	Cursor c = { log->bytes.data(), log->bytes.size(), 0, true };
+	if (c.u32() != CAPTURE_MAGIC) {
+		fprintf(stderr, "Error: %s is not a capture log.\n", path);
+		return false;
+	}
+	uint32_t version = c.u32();
+	if (version != CAPTURE_VERSION) {
+		fprintf(stderr, "Error: %s has the unsupported capture log version %u.\n", path, version);
+		return false;
+	}
+	log->width = c.u32();
+	log->height = c.u32();
+	bool rgba = (c.u32() & CAPTURE_FLAG_RGBA) != 0;
+
+	uint32_t count = c.u32();
+	for (uint32_t i = 0; i < count && c.ok; i++) {
+		CaptureFile file;
+		file.path = c.string();
+		if (c.ok && !capturePathValid(file.path)) {
+			fprintf(stderr, "Error: %s names the file %s outside of its directory.\n", path, file.path.c_str());
+			return false;
+		}
+		uint32_t length = c.u32();
+		const unsigned char *data = c.data(length);
+		if (data) file.data.assign(data, data + length);
+		log->files.push_back(file);
+	}
+
+	CaptureSettings *settings = &(log->settings);
+	settings->thresholdMode = c.i32();
+	settings->threshold = c.i32();
+	settings->patternDetectionMode = c.i32();
+	settings->matrixCodeType = c.i32();
+	settings->labelingMode = c.i32();
+	settings->imageProcMode = c.i32();
+	settings->pattRatio = c.f32();
+	settings->nftSearchFeatureNum = c.i32();
+
+	count = c.u32();
+	for (uint32_t i = 0; i < count && c.ok; i++) {
+		CaptureMarker marker;
+		const unsigned char *type = c.data(1);
+		marker.type = type ? type[0] : -1;
+		marker.path = c.string();
+		if (c.ok && !capturePathValid(marker.path)) {
+			fprintf(stderr, "Error: %s names the marker %s outside of its directory.\n", path, marker.path.c_str());
+			return false;
+		}
+		log->markers.push_back(marker);
+	}
+
+	size_t pixels = (size_t)log->width * log->height;
+	while (c.ok && c.offset < c.size) {
+		CaptureFrame frame;
+		frame.time = c.f64();
+		frame.nftDetect = (c.u32() & CAPTURE_FRAME_NFT_DETECT) != 0;
+		frame.luma = c.data(pixels);
+		frame.rgba = rgba ? c.data(pixels * 4) : NULL;
+		count = c.u32();
+		for (uint32_t i = 0; i < count && c.ok; i++) {
+			CaptureSquareResult marker;
+			marker.idPatt = c.i32();
+			marker.idMatrix = c.i32();
+			marker.dir = c.i32();
+			marker.cf = c.f32();
+			marker.pos[0] = c.f32();
+			marker.pos[1] = c.f32();
+			frame.markers.push_back(marker);
+		}
+		count = c.u32();
+		for (uint32_t i = 0; i < count && c.ok; i++) {
+			CaptureNFTResult nft;
+			nft.markerIndex = c.i32();
+			nft.found = c.i32();
+			for (int k = 0; k < 12; k++) nft.pose[k] = c.f32();
+			frame.nft.push_back(nft);
+		}
+		if (c.ok) log->frames.push_back(frame);
+	}
+
+	if (!c.ok || log->files.empty()) {
+		fprintf(stderr, "Error: %s is truncated.\n", path);
+		return false;
+	}
+	return true;
+}
+
+static bool makeParentDirectories(const std::string &path) {
+	for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+		if (mkdir(path.substr(0, slash).c_str(), 0755) != 0 && errno != EEXIST) return false;
+	}
+	return true;
+}
+
+bool writeCaptureFiles(const CaptureLog &log, const std::string &dir) {
+	for (size_t i = 0; i < log.files.size(); i++) {
+		std::string path = dir + "/" + log.files[i].path;
+		FILE *fp = makeParentDirectories(path) ? fopen(path.c_str(), "wb") : NULL;
+		if (fp == NULL) {
+			fprintf(stderr, "Error: can't write %s.\n", path.c_str());
+			return false;
+		}
+		bool ok = fwrite(log.files[i].data.data(), 1, log.files[i].data.size(), fp) == log.files[i].data.size();
+		fclose(fp);
+		if (!ok) {
+			fprintf(stderr, "Error: can't write %s.\n", path.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+bool extractCaptureFiles(const CaptureLog &log, std::string *dir) {
+	char dirTemplate[] = "/tmp/artoolkit_capture_XXXXXX";
+	if (mkdtemp(dirTemplate) == NULL) {
+		fprintf(stderr, "Error: can't create a temporary directory for the files of the capture.\n");
+		return false;
+	}
+	*dir = dirTemplate;
+	if (!writeCaptureFiles(log, *dir)) {
+		removeCaptureFiles(*dir);
+		return false;
+	}
+	return true;
+}
+
+static int removeEntry(const char *path, const struct stat *, int, struct FTW *) {
+	return remove(path);
+}
+
+void removeCaptureFiles(const std::string &dir) {
+	nftw(dir.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
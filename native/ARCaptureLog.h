@@ -0,0 +1,84 @@
+/*
+ * Reader of the capture logs recorded by ARController.prototype.startCapture() in js/artoolkit.api.js,
+ * which describes the format. Used by artoolkit_cli -r to replay field captures natively and by
+ * nft_microbench for the inputs of the NFT kernels.
+ */
+
+#ifndef AR_CAPTURE_LOG_H
+#define AR_CAPTURE_LOG_H
+
+#include <string>
+#include <vector>
+
+enum {
+	CAPTURE_MARKER_PATTERN = 0,
+	CAPTURE_MARKER_MULTI = 1,
+	CAPTURE_MARKER_NFT = 2
+};
+
+struct CaptureFile {
+	std::string path;
+	std::vector<unsigned char> data;
+};
+
+struct CaptureSettings {
+	int thresholdMode;
+	int threshold;
+	int patternDetectionMode;
+	int matrixCodeType;
+	int labelingMode;
+	int imageProcMode;
+	float pattRatio;
+	int nftSearchFeatureNum; // -1 if the controller had no NFT
+};
+
+struct CaptureMarker {
+	int type; // CAPTURE_MARKER_*
+	std::string path; // NFT markers: the prefix of the .fset, .iset and .fset3 files
+};
+
+struct CaptureSquareResult {
+	int idPatt;
+	int idMatrix;
+	int dir;
+	float cf;
+	float pos[2];
+};
+
+struct CaptureNFTResult {
+	int markerIndex;
+	int found;
+	float pose[12];
+};
+
+struct CaptureFrame {
+	double time; // ms since the capture started
+	bool nftDetect; // detectNFTMarker() was called
+	const unsigned char *luma;
+	const unsigned char *rgba; // NULL unless captured with { rgba: true }
+	std::vector<CaptureSquareResult> markers;
+	std::vector<CaptureNFTResult> nft; // one per getNFTMarker() call, in order
+};
+
+struct CaptureLog {
+	int width;
+	int height;
+	std::vector<CaptureFile> files; // the first one is the camera parameters
+	CaptureSettings settings;
+	std::vector<CaptureMarker> markers;
+	std::vector<CaptureFrame> frames;
+	std::vector<unsigned char> bytes; // the frame images point into it
+};
+
+// Prints the error and returns false if path is not a readable capture log, or names files outside of the
+// directory it is replayed in (absolute paths or .. components).
+bool readCaptureLog(const char *path, CaptureLog *log);
+
+// Writes the files of the log below dir, e.g. dir/marker_0, creating the directories.
+bool writeCaptureFiles(const CaptureLog &log, const std::string &dir);
+
+// Writes the files of the log to a new temporary directory, stored in dir. removeCaptureFiles() deletes it.
+bool extractCaptureFiles(const CaptureLog &log, std::string *dir);
+void removeCaptureFiles(const std::string &dir);
+
+#endif // AR_CAPTURE_LOG_H
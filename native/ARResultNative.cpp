@@ -0,0 +1,70 @@
+/*
+ * Native implementation of ARResult.h: keeps the last result of each kind for the getters in
+ * ARToolKitNative.h.
+ */
+
+#include "ARToolKitNative.h"
+
+static FrameMallocResult gFrameMallocResult;
+static ARMarkerInfo gMarkerInfoResult;
+static NFTMarkerResult gNFTMarkerResult;
+static MultiEachMarkerResult gMultiEachMarkerResult;
+static MultiMarkerBatchResult gMultiMarkerBatchResult;
+static FrameStatsResult gFrameStatsResult;
+static NFTTrackingResult gNFTTrackingResult;
+
+void emitFrameMallocResult(const FrameMallocResult *result) {
+	gFrameMallocResult = *result;
+}
+
+void emitMarkerInfoResult(const ARMarkerInfo *markerInfo) {
+	gMarkerInfoResult = *markerInfo;
+}
+
+void emitNFTMarkerResult(const NFTMarkerResult *result) {
+	gNFTMarkerResult = *result;
+}
+
+void emitMultiEachMarkerResult(const MultiEachMarkerResult *result) {
+	gMultiEachMarkerResult = *result;
+}
+
+void emitMultiMarkerBatchResult(const MultiMarkerBatchResult *result) {
+	gMultiMarkerBatchResult = *result;
+}
+
+void emitFrameStatsResult(const FrameStatsResult *result) {
+	gFrameStatsResult = *result;
+}
+
+void emitNFTTrackingResult(const NFTTrackingResult *result) {
+	gNFTTrackingResult = *result;
+}
+
+const FrameMallocResult *getFrameMallocResult() {
+	return &gFrameMallocResult;
+}
+
+const ARMarkerInfo *getMarkerInfoResult() {
+	return &gMarkerInfoResult;
+}
+
+const NFTMarkerResult *getNFTMarkerResult() {
+	return &gNFTMarkerResult;
+}
+
+const MultiEachMarkerResult *getMultiEachMarkerResult() {
+	return &gMultiEachMarkerResult;
+}
+
+const MultiMarkerBatchResult *getMultiMarkerBatchResult() {
+	return &gMultiMarkerBatchResult;
+}
+
+const FrameStatsResult *getFrameStatsResult() {
+	return &gFrameStatsResult;
+}
+
+const NFTTrackingResult *getNFTTrackingResult() {
+	return &gNFTTrackingResult;
+}
@@ -0,0 +1,135 @@
+/*
+ * Native (non-emscripten) interface to the controller API in emscripten/ARToolKitJS.cpp.
+ *
+ * The functions are the ones the JS API calls through embind, with the same arguments and return
+ * values. Where the JS API reads a result from the artoolkit object (artoolkit.frameMalloc,
+ * artoolkit.markerInfo, ...), native callers use the get*Result() functions below, which return
+ * the result of the last call that produced one.
+ *
+ *   int cameraID = loadCamera("camera_para.dat");
+ *   int id = setup(640, 480, cameraID);
+ *   const FrameMallocResult *frame = getFrameMallocResult();
+ *   // fill frame->framepointer (RGBA) and frame->videoLumaPointer, then
+ *   detectMarker(id);
+ *   for (int i = 0; i < getMarkerNum(id); i++) {
+ *       getMarkerInfo(id, i);
+ *       const ARMarkerInfo *info = getMarkerInfoResult();
+ *       getTransMatSquare(id, i, 80); // pose in frame->transform
+ *   }
+ */
+
+#ifndef AR_TOOLKIT_NATIVE_H
+#define AR_TOOLKIT_NATIVE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <AR/ar.h>
+#include "ARResult.h"
+
+extern "C" {
+
+	int setup(int width, int height, int cameraID);
+	int setupWithMemoryPlan(int width, int height, int cameraID, int maxWidth, int maxHeight, int maxPatterns, int maxSearchFeatureNum);
+	int teardown(int id);
+	int resizeController(int id, int width, int height);
+
+	int setupAR2(int id);
+
+	int loadCamera(std::string cparam_name);
+	int setCamera(int id, int cameraID);
+	void clearParamLTCache();
+	void clearControllerPool();
+
+	int addMarker(int id, std::string patt_name);
+	int addMultiMarker(int id, std::string patt_name);
+	std::vector<int> addNFTMarkers(int id, std::vector<std::string> &datasetPathnames);
+
+	int getMultiMarkerNum(int id, int multiMarker_id);
+	int getMultiMarkerCount(int id);
+
+	int setMarkerInfoDir(int id, int markerIndex, int dir);
+	int setMarkerInfoVertex(int id, int markerIndex);
+
+	int getTransMatSquare(int id, int markerIndex, int markerWidth);
+	int getTransMatSquareCont(int id, int markerIndex, int markerWidth);
+	int setSquareMarkerWidth(int id, int type, int markerId, ARdouble width);
+	int getTransMatSquareBatch(int id);
+	int setPoseFilter(int id, ARdouble cutoffFreq, ARdouble sampleRate);
+	ARdouble getPoseFilterCutoff(int id);
+	int getTransMatMultiSquare(int id, int multiMarkerId);
+	int getTransMatMultiSquareRobust(int id, int multiMarkerId);
+	int getTransMatMultiSquareBatch(int id, int robust);
+
+	int detectMarker(int id);
+	int getMarkerNum(int id);
+	int detectNFTMarker(int id);
+
+	int getMarkerInfo(int id, int markerIndex);
+	int getMultiEachMarkerInfo(int id, int multiMarkerId, int markerIndex);
+	int getNFTMarkerInfo(int id, int markerIndex);
+	int getFrameStats(int id);
+	int resetTracking(int id);
+	int getNFTTrackingInfo(int id);
+	int setNFTSearchFeatureNum(int id, int num);
+	int getNFTSearchFeatureNum(int id);
+
+	int setDebugMode(int id, int enable);
+	int getDebugMode(int id);
+	intptr_t getProcessingImage(int id);
+
+	void setLogLevel(int level);
+	int getLogLevel();
+
+	void setTraceEnabled(int enable);
+	int getTraceEnabled();
+	void clearTrace();
+	std::string getTrace(int pid);
+
+	void setProjectionNearPlane(int id, const ARdouble projectionNearPlane);
+	ARdouble getProjectionNearPlane(int id);
+	void setProjectionFarPlane(int id, const ARdouble projectionFarPlane);
+	ARdouble getProjectionFarPlane(int id);
+
+	void setThresholdMode(int id, int mode);
+	int getThresholdMode(int id);
+	void setThreshold(int id, int threshold);
+	int getThreshold(int id);
+
+	void setPatternDetectionMode(int id, int mode);
+	int getPatternDetectionMode(int id);
+	void setPattRatio(int id, float ratio);
+	ARdouble getPattRatio(int id);
+	void setMatrixCodeType(int id, int type);
+	int getMatrixCodeType(int id);
+	void setLabelingMode(int id, int mode);
+	int getLabelingMode(int id);
+	void setImageProcMode(int id, int mode);
+	int getImageProcMode(int id);
+	int setROIFullScanInterval(int id, int frames);
+	int getROIFullScanInterval(int id);
+	int setCoarseDetectionFactor(int id, int factor);
+	int getCoarseDetectionFactor(int id);
+	int setLabelingThreadNum(int id, int threadNum);
+	int getLabelingThreadNum(int id);
+	int setFastAdaptiveThresholdEnabled(int id, int enable);
+	int getFastAdaptiveThresholdEnabled(int id);
+	int setPatternIndexEnabled(int id, int enable);
+	int getPatternIndexEnabled(int id);
+	int setCornerTrackingInterval(int id, int frames);
+	int getCornerTrackingInterval(int id);
+	int setThresholdEstimation(int id, int sampleStep, int interval, int maxBrightnessShift, double smoothing);
+
+}
+
+// Results of the last setup()/resizeController(), getMarkerInfo(), getNFTMarkerInfo(), getMultiEachMarkerInfo(),
+// getTransMatMultiSquareBatch(), getFrameStats() and getNFTTrackingInfo().
+const FrameMallocResult *getFrameMallocResult();
+const ARMarkerInfo *getMarkerInfoResult();
+const NFTMarkerResult *getNFTMarkerResult();
+const MultiEachMarkerResult *getMultiEachMarkerResult();
+const MultiMarkerBatchResult *getMultiMarkerBatchResult();
+const FrameStatsResult *getFrameStatsResult();
+const NFTTrackingResult *getNFTTrackingResult();
+
+#endif // AR_TOOLKIT_NATIVE_H
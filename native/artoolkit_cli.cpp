@@ -0,0 +1,528 @@
+/*
+ * Command line front end of the native build: runs marker detection over image files and prints
+ * one JSON line per frame with the markers found, their poses and the processing time.
+ *
+ *   artoolkit_cli -c camera_para.dat [-p patt.hiro[:width]]... [-m multi.dat]... [-n DataNFT/pinball]...
+ *                 [-s WIDTHxHEIGHT] [-b iterations] [-R frames] [-C factor] [-j threads] [-i] [-k frames] [-T trace.json] frame.ppm [frame.pgm frame.rgba ...]
+ *   artoolkit_cli -r capture.arcl [-b iterations] [-T trace.json]
+ *
+ * Frames are binary PPM (P6) or PGM (P5) files, or raw RGBA (.rgba) files of the size given by -s.
+ * All frames must have the same size. The default pattern marker width is 80. -R scans the whole frame for
+ * square markers only every given number of frames, see setROIFullScanInterval(). -C labels the frames
+ * downscaled by 2 or 4, see setCoarseDetectionFactor(). -j splits the labeling across threads, see
+ * setLabelingThreadNum(). -i matches the patterns through an index, see setPatternIndexEnabled(). -k tracks the
+ * corners of the markers and detects them only every given number of frames, see setCornerTrackingInterval().
+ *
+ * With -b the frames are replayed the given number of times after a warm-up pass, and a single JSON
+ * report with the frame rate and the latency of each stage is printed instead, in the format of
+ * tests/node/replay.js.
+ *
+ * With -r the frames, camera parameters, markers and detection settings are those of a capture log recorded
+ * with ARController.prototype.startCapture() in the browser. Each frame is processed like the application
+ * did and one JSON line per frame lists the differences with the recorded results. Exits with 1 if any.
+ *
+ * With -T the spans of the pipeline stages (see emscripten/ARTrace.h) are written to trace.json in the
+ * Chrome trace event format, for chrome://tracing or https://ui.perfetto.dev.
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "ARToolKitNative.h"
+#include "ARCaptureLog.h"
+
+struct Frame {
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> rgba;
+};
+
+static int readToken(FILE *fp, char *buf, int size) {
+	int c, n = 0;
+	while ((c = fgetc(fp)) != EOF) {
+		if (c == '#') {
+			while ((c = fgetc(fp)) != EOF && c != '\n');
+		} else if (!isspace(c)) {
+			break;
+		}
+	}
+	while (c != EOF && !isspace(c) && n < size - 1) {
+		buf[n++] = (char)c;
+		c = fgetc(fp);
+	}
+	buf[n] = '\0';
+	return n;
+}
+
+static bool readFrame(const char *path, int rawWidth, int rawHeight, Frame *frame) {
+	FILE *fp = fopen(path, "rb");
+	if (fp == NULL) {
+		fprintf(stderr, "Error: can't open %s.\n", path);
+		return false;
+	}
+
+	bool ok = false;
+	const char *ext = strrchr(path, '.');
+	if (ext && strcmp(ext, ".rgba") == 0) {
+		frame->width = rawWidth;
+		frame->height = rawHeight;
+		frame->rgba.resize(rawWidth * rawHeight * 4);
+		ok = rawWidth > 0 && fread(frame->rgba.data(), 1, frame->rgba.size(), fp) == frame->rgba.size();
+	} else {
+		char magic[4], w[16], h[16], maxval[16];
+		readToken(fp, magic, sizeof(magic));
+		readToken(fp, w, sizeof(w));
+		readToken(fp, h, sizeof(h));
+		readToken(fp, maxval, sizeof(maxval));
+		int channels = strcmp(magic, "P6") == 0 ? 3 : (strcmp(magic, "P5") == 0 ? 1 : 0);
+		if (channels && strcmp(maxval, "255") == 0) {
+			frame->width = atoi(w);
+			frame->height = atoi(h);
+			int pixels = frame->width * frame->height;
+			std::vector<unsigned char> data(pixels * channels);
+			if (fread(data.data(), 1, data.size(), fp) == data.size()) {
+				frame->rgba.resize(pixels * 4);
+				for (int i = 0; i < pixels; i++) {
+					const unsigned char *p = &data[i * channels];
+					frame->rgba[i * 4 + 0] = p[0];
+					frame->rgba[i * 4 + 1] = p[channels == 3 ? 1 : 0];
+					frame->rgba[i * 4 + 2] = p[channels == 3 ? 2 : 0];
+					frame->rgba[i * 4 + 3] = 255;
+				}
+				ok = true;
+			}
+		}
+	}
+	fclose(fp);
+	if (!ok) fprintf(stderr, "Error: can't read %s, only 8-bit binary PPM/PGM and raw RGBA (with -s) are supported.\n", path);
+	return ok;
+}
+
+// Same conversion as ARController.prototype._copyImageToHeap in artoolkit.api.js.
+static void copyFrame(const Frame *frame, const FrameMallocResult *frameMalloc) {
+	int pixels = frame->width * frame->height;
+	memcpy(frameMalloc->framepointer, frame->rgba.data(), pixels * 4);
+	for (int p = 0, q = 0; p < pixels; p++, q += 4) {
+		int r = frame->rgba[q + 0], g = frame->rgba[q + 1], b = frame->rgba[q + 2];
+		frameMalloc->videoLumaPointer[p] = (r + r + r + b + g + g + g + g) >> 3;
+	}
+}
+
+// Same as ARController.prototype.loadCaptureFrame: frames captured without RGBA become gray RGBA images.
+static void copyCaptureFrame(const CaptureFrame *frame, const FrameMallocResult *frameMalloc) {
+	int pixels = frameMalloc->framesize / 4;
+	memcpy(frameMalloc->videoLumaPointer, frame->luma, pixels);
+	if (frame->rgba) {
+		memcpy(frameMalloc->framepointer, frame->rgba, pixels * 4);
+		return;
+	}
+	for (int p = 0, q = 0; p < pixels; p++, q += 4) {
+		frameMalloc->framepointer[q] = frameMalloc->framepointer[q + 1] = frameMalloc->framepointer[q + 2] = frame->luma[p];
+		frameMalloc->framepointer[q + 3] = 255;
+	}
+}
+
+static void printPose(const ARdouble *m) {
+	printf("\"pose\":[");
+	for (int i = 0; i < 12; i++) printf(i ? ",%g" : "%g", (double)m[i]);
+	printf("]");
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s -c camera_para.dat [-p pattern[:width]]... [-m multi.dat]... [-n nft_basename]... [-s WIDTHxHEIGHT] [-b iterations] [-R frames] [-C factor] [-j threads] [-i] [-k frames] [-T trace.json] frame...\n", name);
+	fprintf(stderr, "       %s -r capture.arcl [-b iterations]\n", name);
+}
+
+// Stages of a frame, as in tests/node/replay.js.
+enum { STAGE_DETECT, STAGE_POSE, STAGE_NFT_DETECT, STAGE_NFT_INFO, STAGE_TOTAL, STAGE_COUNT };
+static const char *stageNames[STAGE_COUNT] = { "detect", "pose", "nft_detect", "nft_info", "total" };
+
+static double elapsedMs(std::chrono::steady_clock::time_point t0, std::chrono::steady_clock::time_point t1) {
+	return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+static void printStageStats(const char *name, std::vector<double> samples, bool last) {
+	std::sort(samples.begin(), samples.end());
+	double sum = 0;
+	for (int i = 0; i < (int)samples.size(); i++) sum += samples[i];
+	int n = samples.size();
+	printf("\"%s\":{\"mean\":%g,\"p50\":%g,\"p99\":%g,\"max\":%g}%s", name, sum / n,
+		samples[std::min(n - 1, n * 50 / 100)], samples[std::min(n - 1, n * 99 / 100)], samples[n - 1], last ? "" : ",");
+}
+
+struct Session {
+	int id;
+	const FrameMallocResult *frameMalloc;
+	std::map<int, int> pattWidths;
+	int multiMarkerNum;
+	int nftMarkerNum;
+};
+
+// Runs detection and pose estimation on the frame copied to the controller and stores the time of each stage
+// in stageMs. Prints the frame's JSON line when name is set. For a captured frame, the NFT markers are queried
+// as the application did.
+static void processFrame(const Session &session, const char *name, double *stageMs, const CaptureFrame *captured) {
+	int id = session.id;
+	const FrameMallocResult *frameMalloc = session.frameMalloc;
+	std::chrono::steady_clock::time_point t[STAGE_COUNT];
+
+	t[0] = std::chrono::steady_clock::now();
+
+	if (name) printf("{\"frame\":\"%s\",\"markers\":[", name);
+	int printed = 0;
+	detectMarker(id);
+	t[1] = std::chrono::steady_clock::now();
+
+	int markerNum = getMarkerNum(id);
+	for (int i = 0; i < markerNum; i++) {
+		getMarkerInfo(id, i);
+		const ARMarkerInfo *info = getMarkerInfoResult();
+		// Same rule as ARController.prototype.process in artoolkit.api.js.
+		if (info->idPatt < 0 || (info->id != info->idPatt && info->idMatrix != -1) || session.pattWidths.count(info->idPatt) == 0) continue;
+		if (info->dir != info->dirPatt) setMarkerInfoDir(id, i, info->dirPatt);
+		getTransMatSquare(id, i, session.pattWidths.at(info->idPatt));
+		if (!name) continue;
+		printf("%s{\"type\":\"pattern\",\"id\":%d,\"cf\":%g,", printed++ ? "," : "", info->idPatt, (double)info->cfPatt);
+		printPose(frameMalloc->transform);
+		printf("}");
+	}
+	if (session.multiMarkerNum > 0) getTransMatMultiSquareBatch(id, 1);
+	for (int m = 0; m < session.multiMarkerNum; m++) {
+		const MultiMarkerBatchResult *multi = getMultiMarkerBatchResult();
+		if (multi->visibleNum[m] == 0 || !name) continue;
+		printf("%s{\"type\":\"multi\",\"id\":%d,", printed++ ? "," : "", m);
+		printPose(multi->trans + m * 12);
+		printf("}");
+	}
+	t[2] = std::chrono::steady_clock::now();
+
+	if (captured ? captured->nftDetect : session.nftMarkerNum > 0) detectNFTMarker(id);
+	t[3] = std::chrono::steady_clock::now();
+	int nftQueryNum = captured ? captured->nft.size() : session.nftMarkerNum;
+	for (int q = 0; q < nftQueryNum; q++) {
+		int i = captured ? captured->nft[q].markerIndex : q;
+		getNFTMarkerInfo(id, i);
+		const NFTMarkerResult *nft = getNFTMarkerResult();
+		if (!nft->found || !name) continue;
+		printf("%s{\"type\":\"nft\",\"id\":%d,\"error\":%g,\"pose\":[", printed++ ? "," : "", i, nft->error);
+		for (int k = 0; k < 12; k++) printf(k ? ",%g" : "%g", nft->pose[k]);
+		printf("]}");
+	}
+	t[4] = std::chrono::steady_clock::now();
+
+	for (int s = 0; s < STAGE_TOTAL; s++) stageMs[s] = elapsedMs(t[s], t[s + 1]);
+	stageMs[STAGE_TOTAL] = elapsedMs(t[0], t[4]);
+	if (name) printf("],\"ms\":%.3f}\n", stageMs[STAGE_TOTAL]);
+}
+
+// Same comparison as ARController.prototype.replayFrame in artoolkit.api.js, whose tolerance this is.
+static const double CAPTURE_TOLERANCE = 1e-3;
+
+static void differ(std::vector<std::string> *differences, const std::string &what, double value, double recorded) {
+	char buf[64];
+	snprintf(buf, sizeof(buf), " %g, recorded %g", value, recorded);
+	differences->push_back(what + buf);
+}
+
+// Processes a captured frame like ARController.prototype.replayFrame and lists the differences with the recorded results.
+static void replayFrame(const Session &session, const CaptureFrame &frame, std::vector<std::string> *differences) {
+	int id = session.id;
+	copyCaptureFrame(&frame, session.frameMalloc);
+	detectMarker(id);
+
+	int markerNum = getMarkerNum(id);
+	if (markerNum != (int)frame.markers.size()) differ(differences, "marker count", markerNum, frame.markers.size());
+	for (int i = 0; i < std::min(markerNum, (int)frame.markers.size()); i++) {
+		getMarkerInfo(id, i);
+		const ARMarkerInfo *info = getMarkerInfoResult();
+		const CaptureSquareResult &recorded = frame.markers[i];
+		std::string marker = "marker " + std::to_string(i);
+		if (info->idPatt != recorded.idPatt) differ(differences, marker + " idPatt", info->idPatt, recorded.idPatt);
+		if (info->idMatrix != recorded.idMatrix) differ(differences, marker + " idMatrix", info->idMatrix, recorded.idMatrix);
+		if (info->dir != recorded.dir) differ(differences, marker + " dir", info->dir, recorded.dir);
+		if (fabs(info->cf - recorded.cf) > CAPTURE_TOLERANCE) differ(differences, marker + " cf", info->cf, recorded.cf);
+		for (int k = 0; k < 2; k++) {
+			if (fabs(info->pos[k] - recorded.pos[k]) > CAPTURE_TOLERANCE) differ(differences, marker + " pos[" + std::to_string(k) + "]", info->pos[k], recorded.pos[k]);
+		}
+	}
+
+	if (frame.nftDetect) detectNFTMarker(id);
+	for (int q = 0; q < (int)frame.nft.size(); q++) {
+		const CaptureNFTResult &recorded = frame.nft[q];
+		std::string marker = "NFT marker " + std::to_string(recorded.markerIndex);
+		const NFTMarkerResult *nft = getNFTMarkerInfo(id, recorded.markerIndex) == 0 ? getNFTMarkerResult() : NULL;
+		int found = nft ? nft->found : 0;
+		if (found != recorded.found) {
+			differ(differences, marker + " found", found, recorded.found);
+			continue;
+		}
+		for (int k = 0; found && k < 12; k++) {
+			if (fabs(nft->pose[k] - recorded.pose[k]) > CAPTURE_TOLERANCE) differ(differences, marker + " pose[" + std::to_string(k) + "]", nft->pose[k], recorded.pose[k]);
+		}
+	}
+}
+
+// Replays the frames, the first pass is a warm-up, and prints the report of tests/node/replay.js.
+// loadFrame copies frame f to the controller and returns it if it is a captured frame.
+static void benchmark(const Session &session, int frameNum, int iterations, const std::function<const CaptureFrame *(int)> &loadFrame) {
+	std::vector<double> samples[STAGE_COUNT];
+	double stageMs[STAGE_COUNT];
+	double elapsed = 0;
+	for (int it = 0; it <= iterations; it++) {
+		resetTracking(session.id);
+		std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		for (int f = 0; f < frameNum; f++) {
+			const CaptureFrame *captured = loadFrame(f);
+			processFrame(session, NULL, stageMs, captured);
+			if (it > 0) {
+				for (int s = 0; s < STAGE_COUNT; s++) samples[s].push_back(stageMs[s]);
+			}
+		}
+		if (it > 0) elapsed += elapsedMs(t0, std::chrono::steady_clock::now());
+	}
+
+	printf("{\"runner\":\"native\",\"build\":\"artoolkit_cli\",\"frames\":%d,\"iterations\":%d,\"fps\":%g,\"stages\":{",
+		frameNum, iterations, samples[STAGE_TOTAL].size() / (elapsed / 1000));
+	for (int s = 0; s < STAGE_COUNT; s++) printStageStats(stageNames[s], samples[s], s == STAGE_COUNT - 1);
+	printf("}}\n");
+}
+
+// Sets the controller up like ARController.fromCapture and replays the frames of the log, whose files are in dir.
+static int runCapture(const CaptureLog &log, const std::string &dir, int iterations) {
+	int cameraID = loadCamera(dir + "/" + log.files[0].path);
+	if (cameraID < 0) return 1;
+	int id = setup(log.width, log.height, cameraID);
+	setupAR2(id);
+
+	const CaptureSettings &settings = log.settings;
+	setThresholdMode(id, settings.thresholdMode);
+	setThreshold(id, settings.threshold);
+	setPatternDetectionMode(id, settings.patternDetectionMode);
+	setMatrixCodeType(id, settings.matrixCodeType);
+	setLabelingMode(id, settings.labelingMode);
+	setImageProcMode(id, settings.imageProcMode);
+	setPattRatio(id, settings.pattRatio);
+
+	Session session;
+	session.id = id;
+	session.frameMalloc = getFrameMallocResult();
+	session.multiMarkerNum = 0; // not posed, as by replayFrame
+	session.nftMarkerNum = 0;
+
+	std::vector<std::string> nftPrefixes;
+	for (int i = 0; i < (int)log.markers.size(); i++) {
+		std::string path = dir + "/" + log.markers[i].path;
+		if (log.markers[i].type == CAPTURE_MARKER_NFT) {
+			nftPrefixes.push_back(path);
+			continue;
+		}
+		int markerID = log.markers[i].type == CAPTURE_MARKER_PATTERN ? addMarker(id, path) : addMultiMarker(id, path);
+		if (markerID < 0) {
+			fprintf(stderr, "Error: can't load marker %s of the capture.\n", log.markers[i].path.c_str());
+			return 1;
+		}
+		if (log.markers[i].type == CAPTURE_MARKER_PATTERN) session.pattWidths[markerID] = 80;
+	}
+	if (!nftPrefixes.empty()) {
+		session.nftMarkerNum = addNFTMarkers(id, nftPrefixes).size();
+		if (settings.nftSearchFeatureNum >= 0) setNFTSearchFeatureNum(id, settings.nftSearchFeatureNum);
+	}
+	resetTracking(id);
+
+	int differing = 0;
+	for (int f = 0; f < (int)log.frames.size(); f++) {
+		std::vector<std::string> differences;
+		replayFrame(session, log.frames[f], &differences);
+		if (!differences.empty()) differing++;
+		if (iterations > 0) {
+			for (int i = 0; i < (int)differences.size(); i++) fprintf(stderr, "frame %d: %s\n", f, differences[i].c_str());
+			continue;
+		}
+		printf("{\"frame\":%d,\"time\":%.3f,\"differences\":[", f, log.frames[f].time);
+		for (int i = 0; i < (int)differences.size(); i++) printf(i ? ",\"%s\"" : "\"%s\"", differences[i].c_str());
+		printf("]}\n");
+	}
+	if (iterations > 0) {
+		benchmark(session, log.frames.size(), iterations, [&](int f) {
+			copyCaptureFrame(&log.frames[f], session.frameMalloc);
+			return &log.frames[f];
+		});
+	}
+	fprintf(stderr, "%d of %d frames replayed with the recorded results.\n", (int)log.frames.size() - differing, (int)log.frames.size());
+
+	teardown(id);
+	return differing ? 1 : 0;
+}
+
+static bool writeTrace(const char *path) {
+	FILE *fp = fopen(path, "w");
+	if (fp == NULL) {
+		fprintf(stderr, "Error: can't write %s.\n", path);
+		return false;
+	}
+	std::string trace = getTrace(1);
+	fwrite(trace.data(), 1, trace.size(), fp);
+	fclose(fp);
+	return true;
+}
+
+static int replayCapture(const char *capturePath, int iterations) {
+	CaptureLog log;
+	if (!readCaptureLog(capturePath, &log)) return 1;
+
+	std::string dir;
+	if (!extractCaptureFiles(log, &dir)) return 1;
+	int ret = runCapture(log, dir, iterations);
+	removeCaptureFiles(dir);
+	return ret;
+}
+
+int main(int argc, char **argv) {
+	const char *cameraPath = NULL;
+	std::vector<std::pair<std::string, int> > patterns;
+	std::vector<std::string> multiMarkers;
+	std::vector<std::string> nftMarkers;
+	std::vector<const char *> frames;
+	const char *capturePath = NULL;
+	const char *tracePath = NULL;
+	int rawWidth = 0, rawHeight = 0;
+	int iterations = 0;
+	int roiInterval = 0;
+	int coarseFactor = 1;
+	int labelingThreads = 1;
+	bool pattIndex = false;
+	int trackInterval = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+			cameraPath = argv[++i];
+		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			std::string arg = argv[++i];
+			size_t colon = arg.rfind(':');
+			int width = 80;
+			if (colon != std::string::npos) {
+				width = atoi(arg.substr(colon + 1).c_str());
+				arg = arg.substr(0, colon);
+			}
+			patterns.push_back(std::make_pair(arg, width));
+		} else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+			multiMarkers.push_back(argv[++i]);
+		} else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			nftMarkers.push_back(argv[++i]);
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			sscanf(argv[++i], "%dx%d", &rawWidth, &rawHeight);
+		} else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+			iterations = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			capturePath = argv[++i];
+		} else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+			roiInterval = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+			coarseFactor = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			labelingThreads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-i") == 0) {
+			pattIndex = true;
+		} else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+			trackInterval = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+			tracePath = argv[++i];
+		} else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return 1;
+		} else {
+			frames.push_back(argv[i]);
+		}
+	}
+	if (tracePath) setTraceEnabled(1);
+	if (capturePath) {
+		int ret = replayCapture(capturePath, iterations);
+		if (tracePath && !writeTrace(tracePath)) return 1;
+		return ret;
+	}
+	if (cameraPath == NULL || frames.empty()) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	Frame frame;
+	if (!readFrame(frames[0], rawWidth, rawHeight, &frame)) return 1;
+
+	int cameraID = loadCamera(cameraPath);
+	if (cameraID < 0) return 1;
+	int id = setup(frame.width, frame.height, cameraID);
+	setupAR2(id);
+	setROIFullScanInterval(id, roiInterval);
+	if (setCoarseDetectionFactor(id, coarseFactor) < 0) {
+		fprintf(stderr, "Error: unsupported coarse detection factor %d, use 1, 2 or 4.\n", coarseFactor);
+		return 1;
+	}
+	if (setLabelingThreadNum(id, labelingThreads) < 0) {
+		fprintf(stderr, "Error: unsupported number of labeling threads %d, use 1 to 16.\n", labelingThreads);
+		return 1;
+	}
+	setPatternIndexEnabled(id, pattIndex);
+	if (setCornerTrackingInterval(id, trackInterval) < 0) {
+		fprintf(stderr, "Error: unsupported corner tracking interval %d.\n", trackInterval);
+		return 1;
+	}
+
+	Session session;
+	session.id = id;
+	session.frameMalloc = getFrameMallocResult();
+	session.multiMarkerNum = multiMarkers.size();
+	session.nftMarkerNum = 0;
+
+	for (int i = 0; i < (int)patterns.size(); i++) {
+		int pattID = addMarker(id, patterns[i].first);
+		if (pattID < 0) {
+			fprintf(stderr, "Error: can't load pattern %s.\n", patterns[i].first.c_str());
+			return 1;
+		}
+		session.pattWidths[pattID] = patterns[i].second;
+	}
+	for (int i = 0; i < (int)multiMarkers.size(); i++) {
+		if (addMultiMarker(id, multiMarkers[i]) < 0) {
+			fprintf(stderr, "Error: can't load multimarker %s.\n", multiMarkers[i].c_str());
+			return 1;
+		}
+	}
+	if (!nftMarkers.empty()) {
+		session.nftMarkerNum = addNFTMarkers(id, nftMarkers).size();
+	}
+
+	// Only the benchmark keeps all frames in memory, to not time the file reads.
+	std::vector<Frame> sequence;
+	double stageMs[STAGE_COUNT];
+	for (int f = 0; f < (int)frames.size(); f++) {
+		if (f > 0 && !readFrame(frames[f], rawWidth, rawHeight, &frame)) return 1;
+		if (frame.width * frame.height * 4 != session.frameMalloc->framesize) {
+			fprintf(stderr, "Error: %s is %dx%d, not the size of the first frame.\n", frames[f], frame.width, frame.height);
+			return 1;
+		}
+		if (iterations > 0) {
+			sequence.push_back(frame);
+		} else {
+			copyFrame(&frame, session.frameMalloc);
+			processFrame(session, frames[f], stageMs, NULL);
+		}
+	}
+	if (iterations > 0) {
+		benchmark(session, sequence.size(), iterations, [&](int f) {
+			copyFrame(&sequence[f], session.frameMalloc);
+			return (const CaptureFrame *)NULL;
+		});
+	}
+
+	teardown(id);
+	if (tracePath && !writeTrace(tracePath)) return 1;
+	return 0;
+}
@@ -0,0 +1,658 @@
+/*
+ * Microbenchmarks of the NFT tracking kernels in emscripten/trackingMod.c and trackingMod2d.c, on the
+ * inputs of real frames:
+ *
+ *   nft_microbench capture.arcl [-b iterations] [-k kernel] [-w golden.bin] [-g golden.bin] [-t tolerance]
+ *
+ * The capture log (see ARCaptureLog.h) gives the camera, the NFT markers, the frames and the pose found
+ * in each. Every frame whose marker was also found in the previous frame is tracked once from the previous
+ * poses with ar2TrackingMod(), and the arguments the kernels get (visible features, matched features,
+ * templates and search points, 2D-3D correspondences) are kept. Each kernel is then run on all of them,
+ * a first pass giving the reference results and -b passes (default 10) being timed. One JSON line per
+ * kernel gives the number of calls, ns/op, allocations/op (glibc only, -1 elsewhere) and the number of
+ * results that differed from the reference pass, which must be 0.
+ *
+ * -w writes the reference results to a file and -g compares them with such a file, written before a change
+ * of the kernels, with a relative tolerance (-t, default 1e-4). The inputs are those of the current build,
+ * so once a kernel's results change the kernels after it see other inputs too: the report counts those
+ * calls as inputs_differ, and the first kernel with results that differ is the one to look at.
+ * Exits with 1 if any result differs.
+ *
+ * The homography kernels are not called in 6DOF tracking and get the same correspondences, with the pose
+ * projected by the camera matrix as initial homography; getDeltaS gets the first Gauss-Newton step of
+ * ar2GetTransMatHomography2 on them.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <AR/ar.h>
+#include <AR2/coord.h>
+#include <AR2/searchPoint.h>
+#include <AR2/template.h>
+#include <AR2/tracking.h>
+#include "trackingMod.h"
+#include "ARCaptureLog.h"
+
+#ifdef __GLIBC__
+// Counts the allocations of the timed kernel calls.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t num, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static bool countAllocations = false;
+static size_t allocationCount = 0;
+
+extern "C" void *malloc(size_t size) {
+	if (countAllocations) allocationCount++;
+	return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t num, size_t size) {
+	if (countAllocations) allocationCount++;
+	return __libc_calloc(num, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+	if (countAllocations) allocationCount++;
+	return __libc_realloc(ptr, size);
+}
+#define ALLOCATIONS_COUNTED 1
+#else
+static bool countAllocations = false;
+static size_t allocationCount = 0;
+#define ALLOCATIONS_COUNTED 0
+#endif
+
+static const uint32_t GOLDEN_MAGIC = 0x4b54464e; // 'NFTK'
+static const uint32_t GOLDEN_VERSION = 1;
+
+// A captured frame tracked from the poses of the previous frames, as ar2TrackingMod() got it.
+struct TrackingState {
+	int frame;
+	int marker;
+	int contNum;
+	float trans[3][3][4]; // surfaceSet->trans1, trans2 and trans3
+};
+
+struct MatchingInput {
+	int state;
+	AR2TemplateT *templ;
+	int search[3][2];
+};
+
+struct CorrespondenceInput {
+	int state;
+	float initConv[3][4];
+	float initH[3][4]; // initConv projected by the camera matrix, for the homography kernels
+	std::vector<float> pos2d; // num x 2, ideal screen coordinates
+	std::vector<float> pos3d; // num x 3
+	std::vector<float> J_U_H; // 2 num x 8
+	std::vector<float> dU;    // 2 num
+	int num;
+};
+
+struct Bench {
+	const CaptureLog *log;
+	ARParamLT *paramLT;
+	AR2HandleT *handle;
+	std::vector<AR2SurfaceSetT *> surfaceSets;
+	std::vector<unsigned char> rgba; // the frame of the current state
+	int rgbaFrame;
+	int currentState;
+
+	std::vector<TrackingState> states;
+	std::vector<int> visible; // states
+	std::vector<std::pair<int, AR2TemplateCandidateT> > matched;
+	std::vector<MatchingInput> matching;
+	std::vector<CorrespondenceInput> correspondences;
+};
+
+// Sets the surface set and the handle as ar2TrackingMod() finds them for the state, and the frame.
+static void applyState(Bench *bench, int s) {
+	if (bench->currentState == s) return;
+	bench->currentState = s;
+	const TrackingState &state = bench->states[s];
+	AR2SurfaceSetT *surfaceSet = bench->surfaceSets[state.marker];
+	surfaceSet->contNum = state.contNum;
+	memcpy(surfaceSet->trans1, state.trans[0], sizeof(surfaceSet->trans1));
+	memcpy(surfaceSet->trans2, state.trans[1], sizeof(surfaceSet->trans2));
+	memcpy(surfaceSet->trans3, state.trans[2], sizeof(surfaceSet->trans3));
+	surfaceSet->prevFeature[0].flag = -1;
+	for (int i = 0; i < surfaceSet->num; i++) {
+		arUtilMatMulf((const float (*)[4])surfaceSet->trans1, (const float (*)[4])surfaceSet->surface[i].trans, bench->handle->wtrans1[i]);
+		arUtilMatMulf((const float (*)[4])surfaceSet->trans2, (const float (*)[4])surfaceSet->surface[i].trans, bench->handle->wtrans2[i]);
+		arUtilMatMulf((const float (*)[4])surfaceSet->trans3, (const float (*)[4])surfaceSet->surface[i].trans, bench->handle->wtrans3[i]);
+	}
+
+	if (bench->rgbaFrame == state.frame) return;
+	bench->rgbaFrame = state.frame;
+	const CaptureFrame &frame = bench->log->frames[state.frame];
+	size_t pixels = (size_t)bench->log->width * bench->log->height;
+	if (frame.rgba) {
+		memcpy(bench->rgba.data(), frame.rgba, pixels * 4);
+	} else {
+		for (size_t i = 0; i < pixels; i++) {
+			bench->rgba[i * 4] = bench->rgba[i * 4 + 1] = bench->rgba[i * 4 + 2] = frame.luma[i];
+			bench->rgba[i * 4 + 3] = 255;
+		}
+	}
+}
+
+static const CaptureNFTResult *findResult(const CaptureFrame &frame, int marker) {
+	for (int i = 0; i < (int)frame.nft.size(); i++) {
+		if (frame.nft[i].markerIndex == marker && frame.nft[i].found) return &frame.nft[i];
+	}
+	return NULL;
+}
+
+static void projectPose(const ARdouble P[3][4], const float pose[3][4], float H[3][4]) {
+	for (int r = 0; r < 3; r++) {
+		for (int c = 0; c < 4; c++) {
+			H[r][c] = (float)(P[r][0] * pose[0][c] + P[r][1] * pose[1][c] + P[r][2] * pose[2][c] + (c == 3 ? P[r][3] : 0));
+		}
+	}
+}
+
+// The Jacobian and residuals of the first iteration of ar2GetTransMatHomography2().
+static void homographyStep(CorrespondenceInput *in) {
+	float conv[3][4];
+	for (int j = 0; j < 3; j++) {
+		for (int i = 0; i < 4; i++) conv[j][i] = in->initH[j][i] / in->initH[2][3];
+	}
+	in->J_U_H.assign(16 * in->num, 0.0F);
+	in->dU.assign(2 * in->num, 0.0F);
+	for (int j = 0; j < in->num; j++) {
+		const float *p3 = &in->pos3d[j * 3], *p2 = &in->pos2d[j * 2];
+		float hx = conv[0][0] * p3[0] + conv[0][1] * p3[1] + conv[0][3];
+		float hy = conv[1][0] * p3[0] + conv[1][1] * p3[1] + conv[1][3];
+		float h = conv[2][0] * p3[0] + conv[2][1] * p3[1] + 1.0F;
+		float hh = h * h;
+		float *J = &in->J_U_H[16 * j];
+		in->dU[j * 2] = p2[0] - hx / h;
+		in->dU[j * 2 + 1] = p2[1] - hy / h;
+		J[0] = p3[0] / h;
+		J[1] = p3[1] / h;
+		J[2] = 1.0F / h;
+		J[6] = -p3[0] * hx / hh;
+		J[7] = -p3[1] * hx / hh;
+		J[11] = p3[0] / h;
+		J[12] = p3[1] / h;
+		J[13] = 1.0F / h;
+		J[14] = -p3[0] * hy / hh;
+		J[15] = -p3[1] * hy / hh;
+	}
+}
+
+// Tracks the frames of the log and keeps the inputs of the kernels.
+static bool collectInputs(Bench *bench) {
+	const CaptureLog &log = *bench->log;
+	for (int f = 1; f < (int)log.frames.size(); f++) {
+		for (int m = 0; m < (int)bench->surfaceSets.size(); m++) {
+			if (!findResult(log.frames[f], m)) continue;
+			TrackingState state;
+			state.frame = f;
+			state.marker = m;
+			state.contNum = 0;
+			for (int k = 0; k < 3 && f - 1 - k >= 0; k++) {
+				const CaptureNFTResult *previous = findResult(log.frames[f - 1 - k], m);
+				if (!previous) break;
+				memcpy(state.trans[k], previous->pose, sizeof(state.trans[k]));
+				state.contNum++;
+			}
+			if (state.contNum == 0) continue;
+			for (int k = state.contNum; k < 3; k++) memcpy(state.trans[k], state.trans[0], sizeof(state.trans[k]));
+
+			int s = bench->states.size();
+			bench->states.push_back(state);
+			bench->currentState = -1;
+			applyState(bench, s);
+
+			AR2SurfaceSetT *surfaceSet = bench->surfaceSets[m];
+			float trans[3][4], err;
+			ar2TrackingMod(bench->handle, surfaceSet, bench->rgba.data(), trans, &err);
+			bench->visible.push_back(s);
+
+			int num = ar2TrackingModGetStats(bench->handle)->trackedNum;
+			for (int i = 0; i < num; i++) {
+				AR2TemplateCandidateT candidate = bench->handle->usedFeature[i];
+				bench->matched.push_back(std::make_pair(s, candidate));
+
+				// The template and search points ar2Tracking2dSub() matches, for ar2GetBestMatching().
+				MatchingInput matching;
+				matching.state = s;
+				matching.templ = ar2GenTemplate(bench->handle->templateSize1, bench->handle->templateSize2);
+				AR2SurfaceT *surface = &surfaceSet->surface[candidate.snum];
+				AR2FeaturePointsT *points = &surface->featureSet->list[candidate.level];
+				if (ar2SetTemplateSub(bench->paramLT, (const float (*)[4])bench->handle->wtrans1[candidate.snum], surface->imageSet, points, candidate.num, matching.templ) < 0) {
+					ar2FreeTemplate(matching.templ);
+					continue;
+				}
+				ar2GetSearchPoint(bench->paramLT, (const float (*)[4])bench->handle->wtrans1[candidate.snum],
+					state.contNum > 1 ? (const float (*)[4])bench->handle->wtrans2[candidate.snum] : NULL,
+					state.contNum > 2 ? (const float (*)[4])bench->handle->wtrans3[candidate.snum] : NULL,
+					&points->coord[candidate.num], matching.search);
+				bench->matching.push_back(matching);
+			}
+
+			if (num >= 4) {
+				CorrespondenceInput in;
+				in.state = s;
+				in.num = num;
+				memcpy(in.initConv, state.trans[0], sizeof(in.initConv));
+				projectPose(bench->paramLT->param.mat, in.initConv, in.initH);
+				in.pos2d.assign(&bench->handle->pos2d[0][0], &bench->handle->pos2d[0][0] + num * 2);
+				in.pos3d.assign(&bench->handle->pos3d[0][0], &bench->handle->pos3d[0][0] + num * 3);
+				homographyStep(&in);
+				bench->correspondences.push_back(in);
+			}
+		}
+	}
+	bench->currentState = -1;
+	return !bench->states.empty();
+}
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+	const unsigned char *p = (const unsigned char *)data;
+	for (size_t i = 0; i < size; i++) hash = (hash ^ p[i]) * 1099511628211ULL;
+	return hash;
+}
+
+static const uint64_t HASH_SEED = 14695981039346656037ULL;
+
+static uint64_t hashState(const TrackingState &state) {
+	uint64_t hash = hashBytes(HASH_SEED, &state.frame, sizeof(state.frame));
+	hash = hashBytes(hash, &state.marker, sizeof(state.marker));
+	hash = hashBytes(hash, &state.contNum, sizeof(state.contNum));
+	return hashBytes(hash, state.trans, sizeof(state.trans));
+}
+
+struct Kernel {
+	std::string name;
+	size_t ops;
+	std::function<int(size_t)> state; // the tracking state op i needs, -1 for none
+	std::function<void()> prepare; // called before the ops of each pass
+	std::function<int(size_t, double *)> run; // runs op i, stores its results and returns their number
+	std::function<uint64_t(size_t)> inputHash;
+};
+
+static const int RESULT_MAX = 2 * (AR2_TRACKING_CANDIDATE_MAX + 1) * 6 + 1;
+
+static std::vector<Kernel> makeKernels(Bench *bench) {
+	std::vector<Kernel> kernels;
+	AR2HandleT *handle = bench->handle;
+
+	Kernel k;
+	k.name = "extractVisibleFeatures";
+	k.ops = bench->visible.size();
+	k.state = [=](size_t i) { return bench->visible[i]; };
+	k.prepare = [] {};
+	k.run = [=](size_t i, double *out) {
+		const TrackingState &state = bench->states[bench->visible[i]];
+		int n = 0;
+		out[n++] = extractVisibleFeatures(bench->paramLT, (const float (*)[3][4])handle->wtrans1, bench->surfaceSets[state.marker], handle->candidate, handle->candidate2);
+		AR2TemplateCandidateT *lists[2] = { handle->candidate, handle->candidate2 };
+		for (int l = 0; l < 2; l++) {
+			for (AR2TemplateCandidateT *c = lists[l]; c->flag != -1; c++) {
+				out[n++] = c->snum; out[n++] = c->level; out[n++] = c->num;
+				out[n++] = c->flag; out[n++] = c->sx; out[n++] = c->sy;
+			}
+			out[n++] = -1;
+		}
+		return n;
+	};
+	k.inputHash = [=](size_t i) { return hashState(bench->states[bench->visible[i]]); };
+	kernels.push_back(k);
+
+	k.name = "ar2Tracking2dSub";
+	k.ops = bench->matched.size();
+	k.state = [=](size_t i) { return bench->matched[i].first; };
+	k.run = [=](size_t i, double *out) {
+		const TrackingState &state = bench->states[bench->matched[i].first];
+		AR2TemplateCandidateT candidate = bench->matched[i].second;
+		AR2Tracking2DResultT result;
+		memset(&result, 0, sizeof(result));
+		out[0] = ar2Tracking2dSub(handle, bench->surfaceSets[state.marker], &candidate, bench->rgba.data(),
+			handle->arg[0].mfImage, &handle->arg[0].templ, &result);
+		out[1] = result.sim;
+		out[2] = result.pos2d[0]; out[3] = result.pos2d[1];
+		out[4] = result.pos3d[0]; out[5] = result.pos3d[1]; out[6] = result.pos3d[2];
+		return 7;
+	};
+	k.inputHash = [=](size_t i) {
+		const AR2TemplateCandidateT &c = bench->matched[i].second;
+		uint64_t hash = hashState(bench->states[bench->matched[i].first]);
+		hash = hashBytes(hash, &c.snum, sizeof(c.snum));
+		hash = hashBytes(hash, &c.level, sizeof(c.level));
+		return hashBytes(hash, &c.num, sizeof(c.num));
+	};
+	kernels.push_back(k);
+
+	k.name = "ar2GetBestMatching";
+	k.ops = bench->matching.size();
+	k.state = [=](size_t i) { return bench->matching[i].state; };
+	k.run = [=](size_t i, double *out) {
+		MatchingInput &in = bench->matching[i];
+		int bx = 0, by = 0;
+		float sim = 0;
+		out[0] = ar2GetBestMatching(bench->rgba.data(), handle->arg[0].mfImage, handle->xsize, handle->ysize, handle->pixFormat,
+			in.templ, handle->searchSize, handle->searchSize, in.search, &bx, &by, &sim);
+		out[1] = bx; out[2] = by; out[3] = sim;
+		return 4;
+	};
+	k.inputHash = [=](size_t i) {
+		const MatchingInput &in = bench->matching[i];
+		uint64_t hash = hashBytes(HASH_SEED, &bench->states[in.state].frame, sizeof(int));
+		hash = hashBytes(hash, in.search, sizeof(in.search));
+		hash = hashBytes(hash, &in.templ->vlen, sizeof(in.templ->vlen));
+		return hashBytes(hash, &in.templ->sum, sizeof(in.templ->sum));
+	};
+	kernels.push_back(k);
+
+	// The correspondence kernels don't depend on the frame.
+	auto correspondenceHash = [=](size_t i) {
+		const CorrespondenceInput &in = bench->correspondences[i];
+		uint64_t hash = hashBytes(HASH_SEED, in.initConv, sizeof(in.initConv));
+		hash = hashBytes(hash, in.pos2d.data(), in.pos2d.size() * sizeof(float));
+		return hashBytes(hash, in.pos3d.data(), in.pos3d.size() * sizeof(float));
+	};
+	auto storeConv = [](float conv[3][4], float err, double *out) {
+		out[0] = err;
+		for (int j = 0; j < 12; j++) out[1 + j] = conv[j / 4][j % 4];
+		return 13;
+	};
+	k.ops = bench->correspondences.size();
+	k.state = [](size_t) { return -1; };
+	k.inputHash = correspondenceHash;
+
+	k.name = "ar2GetTransMat";
+	k.prepare = [] {};
+	k.run = [=](size_t i, double *out) {
+		CorrespondenceInput &in = bench->correspondences[i];
+		float conv[3][4];
+		float err = ar2GetTransMat(handle, in.initConv, (float (*)[2])in.pos2d.data(), (float (*)[3])in.pos3d.data(), in.num, conv, 0);
+		return storeConv(conv, err, out);
+	};
+	kernels.push_back(k);
+
+	// The first robust level of the tracking cascade.
+	k.name = "ar2GetTransMat(robust)";
+	k.prepare = [=] { icpSetInlierProbability(handle->icpHandle, 0.8F); };
+	k.run = [=](size_t i, double *out) {
+		CorrespondenceInput &in = bench->correspondences[i];
+		float conv[3][4];
+		float err = ar2GetTransMat(handle, in.initConv, (float (*)[2])in.pos2d.data(), (float (*)[3])in.pos3d.data(), in.num, conv, 1);
+		return storeConv(conv, err, out);
+	};
+	kernels.push_back(k);
+
+	k.name = "ar2GetTransMatHomography2";
+	k.prepare = [] {};
+	k.run = [=](size_t i, double *out) {
+		CorrespondenceInput &in = bench->correspondences[i];
+		float conv[3][4];
+		float err = ar2GetTransMatHomography2(in.initH, (float (*)[2])in.pos2d.data(), (float (*)[3])in.pos3d.data(), in.num, conv);
+		return storeConv(conv, err, out);
+	};
+	kernels.push_back(k);
+
+	k.name = "ar2GetTransMatHomographyRobust";
+	k.run = [=](size_t i, double *out) {
+		CorrespondenceInput &in = bench->correspondences[i];
+		float conv[3][4];
+		float err = ar2GetTransMatHomographyRobust(in.initH, (float (*)[2])in.pos2d.data(), (float (*)[3])in.pos3d.data(), in.num, conv, 0.8F);
+		return storeConv(conv, err, out);
+	};
+	kernels.push_back(k);
+
+	k.name = "getDeltaS";
+	k.run = [=](size_t i, double *out) {
+		CorrespondenceInput &in = bench->correspondences[i];
+		float dH[8];
+		out[0] = getDeltaS(dH, in.dU.data(), (float (*)[8])in.J_U_H.data(), in.num * 2);
+		for (int j = 0; j < 8; j++) out[1 + j] = dH[j];
+		return 9;
+	};
+	kernels.push_back(k);
+
+	return kernels;
+}
+
+struct KernelResults {
+	std::vector<uint64_t> inputHashes;
+	std::vector<std::vector<double> > results;
+};
+
+static bool writeGolden(const char *path, const std::vector<Kernel> &kernels, const std::vector<KernelResults> &reference) {
+	FILE *fp = fopen(path, "wb");
+	if (fp == NULL) {
+		fprintf(stderr, "Error: can't write %s.\n", path);
+		return false;
+	}
+	uint32_t header[3] = { GOLDEN_MAGIC, GOLDEN_VERSION, (uint32_t)kernels.size() };
+	fwrite(header, sizeof(header), 1, fp);
+	for (int k = 0; k < (int)kernels.size(); k++) {
+		uint32_t length = kernels[k].name.size();
+		fwrite(&length, sizeof(length), 1, fp);
+		fwrite(kernels[k].name.data(), 1, length, fp);
+		uint32_t ops = reference[k].results.size();
+		fwrite(&ops, sizeof(ops), 1, fp);
+		for (uint32_t i = 0; i < ops; i++) {
+			uint32_t n = reference[k].results[i].size();
+			fwrite(&reference[k].inputHashes[i], sizeof(uint64_t), 1, fp);
+			fwrite(&n, sizeof(n), 1, fp);
+			fwrite(reference[k].results[i].data(), sizeof(double), n, fp);
+		}
+	}
+	bool ok = ferror(fp) == 0;
+	fclose(fp);
+	if (!ok) fprintf(stderr, "Error: can't write %s.\n", path);
+	return ok;
+}
+
+// Golden results by kernel name. Host byte order: compare on the machine that wrote them.
+static bool readGolden(const char *path, std::vector<std::pair<std::string, KernelResults> > *golden) {
+	FILE *fp = fopen(path, "rb");
+	if (fp == NULL) {
+		fprintf(stderr, "Error: can't open %s.\n", path);
+		return false;
+	}
+	uint32_t header[3];
+	bool ok = fread(header, sizeof(header), 1, fp) == 1 && header[0] == GOLDEN_MAGIC && header[1] == GOLDEN_VERSION;
+	for (uint32_t k = 0; ok && k < header[2]; k++) {
+		uint32_t length = 0, ops = 0;
+		ok = fread(&length, sizeof(length), 1, fp) == 1 && length < 256;
+		std::string name(length, ' ');
+		ok = ok && fread(&name[0], 1, length, fp) == length && fread(&ops, sizeof(ops), 1, fp) == 1;
+		KernelResults results;
+		for (uint32_t i = 0; ok && i < ops; i++) {
+			uint64_t hash;
+			uint32_t n = 0;
+			ok = fread(&hash, sizeof(hash), 1, fp) == 1 && fread(&n, sizeof(n), 1, fp) == 1 && n <= RESULT_MAX;
+			std::vector<double> values(n);
+			ok = ok && fread(values.data(), sizeof(double), n, fp) == n;
+			results.inputHashes.push_back(hash);
+			results.results.push_back(values);
+		}
+		golden->push_back(std::make_pair(name, results));
+	}
+	fclose(fp);
+	if (!ok) fprintf(stderr, "Error: %s is not a result file of nft_microbench.\n", path);
+	return ok;
+}
+
+static bool sameResults(const std::vector<double> &a, const std::vector<double> &b, double tolerance) {
+	if (a.size() != b.size()) return false;
+	for (int i = 0; i < (int)a.size(); i++) {
+		if (a[i] == b[i]) continue;
+		if (!(fabs(a[i] - b[i]) <= tolerance * fmax(1.0, fabs(b[i])))) return false;
+	}
+	return true;
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s capture.arcl [-b iterations] [-k kernel] [-w golden.bin] [-g golden.bin] [-t tolerance]\n", name);
+}
+
+int main(int argc, char **argv) {
+	const char *capturePath = NULL;
+	const char *kernelName = NULL;
+	const char *writePath = NULL;
+	const char *goldenPath = NULL;
+	int iterations = 10;
+	double tolerance = 1e-4;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+			iterations = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+			kernelName = argv[++i];
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			writePath = argv[++i];
+		} else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+			goldenPath = argv[++i];
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			tolerance = atof(argv[++i]);
+		} else if (argv[i][0] == '-' || capturePath) {
+			usage(argv[0]);
+			return 1;
+		} else {
+			capturePath = argv[i];
+		}
+	}
+	if (capturePath == NULL || iterations < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	CaptureLog log;
+	if (!readCaptureLog(capturePath, &log)) return 1;
+	std::string dir;
+	if (!extractCaptureFiles(log, &dir)) return 1;
+
+	Bench bench;
+	bench.log = &log;
+	bench.rgba.resize((size_t)log.width * log.height * 4);
+	bench.rgbaFrame = -1;
+	bench.currentState = -1;
+
+	// The camera and tracker settings of ARToolKitJS.cpp.
+	ARParam param;
+	std::string cameraPath = dir + "/" + log.files[0].path;
+	if (arParamLoad(cameraPath.c_str(), 1, &param) < 0) {
+		fprintf(stderr, "Error: can't load the camera parameters of the capture.\n");
+		removeCaptureFiles(dir);
+		return 1;
+	}
+	if (param.xsize != log.width || param.ysize != log.height) arParamChangeSize(&param, log.width, log.height, &param);
+	bench.paramLT = arParamLTCreate(&param, AR_PARAM_LT_DEFAULT_OFFSET);
+	bench.handle = ar2CreateHandleMod(bench.paramLT, AR_PIXEL_FORMAT_RGBA);
+	ar2SetTrackingThresh(bench.handle, 5.0);
+	ar2SetSimThresh(bench.handle, 0.50);
+	ar2SetSearchFeatureNum(bench.handle, log.settings.nftSearchFeatureNum > 0 ? log.settings.nftSearchFeatureNum : 16);
+	ar2SetSearchSize(bench.handle, 6);
+	ar2SetTemplateSize1(bench.handle, 6);
+	ar2SetTemplateSize2(bench.handle, 6);
+
+	for (int i = 0; i < (int)log.markers.size(); i++) {
+		if (log.markers[i].type != CAPTURE_MARKER_NFT) continue;
+		std::string prefix = dir + "/" + log.markers[i].path;
+		AR2SurfaceSetT *surfaceSet = ar2ReadSurfaceSet(prefix.c_str(), "fset", NULL);
+		if (surfaceSet == NULL) {
+			fprintf(stderr, "Error: can't load NFT marker %s of the capture.\n", log.markers[i].path.c_str());
+			removeCaptureFiles(dir);
+			return 1;
+		}
+		bench.surfaceSets.push_back(surfaceSet);
+	}
+	removeCaptureFiles(dir);
+	if (bench.surfaceSets.empty() || !collectInputs(&bench)) {
+		fprintf(stderr, "Error: no NFT marker tracked in consecutive frames of %s.\n", capturePath);
+		return 1;
+	}
+
+	std::vector<Kernel> kernels = makeKernels(&bench);
+	std::vector<KernelResults> reference(kernels.size());
+	std::vector<std::pair<std::string, KernelResults> > golden;
+	if (goldenPath && !readGolden(goldenPath, &golden)) return 1;
+
+	std::vector<double> out(RESULT_MAX);
+	bool differ = false;
+	for (int k = 0; k < (int)kernels.size(); k++) {
+		Kernel &kernel = kernels[k];
+		if (kernelName && kernel.name != kernelName) continue;
+
+		// Reference pass, also the warm-up.
+		bench.currentState = -1;
+		kernel.prepare();
+		for (size_t i = 0; i < kernel.ops; i++) {
+			if (kernel.state(i) >= 0) applyState(&bench, kernel.state(i));
+			int n = kernel.run(i, out.data());
+			reference[k].results.push_back(std::vector<double>(out.begin(), out.begin() + n));
+			reference[k].inputHashes.push_back(kernel.inputHash(i));
+		}
+
+		// The ops of a state are timed together, setting the state up is not timed.
+		double ns = 0;
+		size_t allocations = 0;
+		int unstable = 0;
+		std::vector<std::vector<double> > results(kernel.ops);
+		for (int it = 0; it < iterations; it++) {
+			bench.currentState = -1;
+			kernel.prepare();
+			size_t i = 0;
+			while (i < kernel.ops) {
+				int state = kernel.state(i);
+				if (state >= 0) applyState(&bench, state);
+				size_t end = i;
+				while (end < kernel.ops && kernel.state(end) == state) end++;
+				std::vector<int> counts(end - i);
+				std::vector<double> batch(out.size() * (end - i));
+				allocationCount = 0;
+				countAllocations = true;
+				std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+				for (size_t j = i; j < end; j++) counts[j - i] = kernel.run(j, &batch[(j - i) * out.size()]);
+				std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+				countAllocations = false;
+				ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+				allocations += allocationCount;
+				for (size_t j = i; j < end; j++) {
+					const double *r = &batch[(j - i) * out.size()];
+					if (!sameResults(std::vector<double>(r, r + counts[j - i]), reference[k].results[j], 0)) unstable++;
+				}
+				i = end;
+			}
+		}
+
+		int goldenDiffer = -1, inputsDiffer = -1;
+		for (int g = 0; g < (int)golden.size(); g++) {
+			if (golden[g].first != kernel.name) continue;
+			const KernelResults &expected = golden[g].second;
+			goldenDiffer = inputsDiffer = 0;
+			if (expected.results.size() != kernel.ops) {
+				goldenDiffer = kernel.ops;
+				break;
+			}
+			for (size_t i = 0; i < kernel.ops; i++) {
+				if (expected.inputHashes[i] != reference[k].inputHashes[i]) inputsDiffer++;
+				else if (!sameResults(reference[k].results[i], expected.results[i], tolerance)) goldenDiffer++;
+			}
+		}
+		if (unstable || goldenDiffer > 0) differ = true;
+
+		double calls = (double)kernel.ops * iterations;
+		printf("{\"kernel\":\"%s\",\"ops\":%zu,\"ns_per_op\":%.1f,\"allocs_per_op\":%g,\"unstable\":%d",
+			kernel.name.c_str(), kernel.ops, calls ? ns / calls : 0, ALLOCATIONS_COUNTED && calls ? allocations / calls : -1, unstable);
+		if (goldenPath) printf(",\"differ\":%d,\"inputs_differ\":%d", goldenDiffer, inputsDiffer);
+		printf("}\n");
+	}
+
+	if (writePath && !writeGolden(writePath, kernels, reference)) return 1;
+	return differ ? 1 : 0;
+}
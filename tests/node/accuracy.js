@@ -0,0 +1,104 @@
+/*
+ * Pose accuracy of the float32 build (ARDOUBLE_IS_FLOAT) against the default double build.
+ *
+ *   node tests/node/accuracy.js [manifest.json] [--double build.js] [--float build.js]
+ *
+ * Both builds process the frames of the manifest (default: accuracy.json next to this file) and
+ * the poses found by each are compared. Translation differences are in the units of the marker
+ * widths given in the manifest, rotation differences in radians. Exits with 1 if a marker is found
+ * by only one build or a difference exceeds the manifest tolerance.
+ */
+
+const path = require('path');
+const fork = require('child_process').fork;
+
+function parseArgs(argv) {
+    const args = {
+        manifest: path.resolve(__dirname, 'accuracy.json'),
+        double: path.resolve(__dirname, '../../build/artoolkit_wasm.js'),
+        float: path.resolve(__dirname, '../../build/artoolkit_wasm_float.js')
+    };
+    for (let i = 0; i < argv.length; i++) {
+        if (argv[i] === '--double') args.double = path.resolve(argv[++i]);
+        else if (argv[i] === '--float') args.float = path.resolve(argv[++i]);
+        else args.manifest = path.resolve(argv[i]);
+    }
+    return args;
+}
+
+function runBuild(build, manifest) {
+    return new Promise((resolve, reject) => {
+        const child = fork(path.resolve(__dirname, 'poses.js'), [build, manifest], { silent: true });
+        let result;
+        child.on('message', (m) => { result = m; });
+        child.stderr.on('data', (d) => process.stderr.write(d));
+        child.on('exit', (code) => {
+            if (code === 0 && result) resolve(result);
+            else reject(new Error(path.basename(build) + ' exited with ' + code));
+        });
+    });
+}
+
+// Angle of the rotation between two 3x4 row-major poses.
+function rotationDiff(a, b) {
+    let trace = 0;
+    for (let i = 0; i < 3; i++) {
+        for (let k = 0; k < 3; k++) {
+            trace += a[k * 4 + i] * b[k * 4 + i];
+        }
+    }
+    return Math.acos(Math.max(-1, Math.min(1, (trace - 1) / 2)));
+}
+
+function translationDiff(a, b) {
+    const dx = a[3] - b[3], dy = a[7] - b[7], dz = a[11] - b[11];
+    return Math.sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+async function main() {
+    const args = parseArgs(process.argv.slice(2));
+    const manifest = require(args.manifest);
+    const tolerance = manifest.tolerance || { translation: 1, rotation: 0.01 };
+
+    const [poses64, poses32] = await Promise.all([runBuild(args.double, args.manifest), runBuild(args.float, args.manifest)]);
+
+    let compared = 0, mismatches = 0, failures = 0;
+    let maxT = 0, maxR = 0, sumT = 0, sumR = 0;
+    for (let f = 0; f < poses64.length; f++) {
+        const keys = new Set(Object.keys(poses64[f]).concat(Object.keys(poses32[f])));
+        for (const key of keys) {
+            const a = poses64[f][key], b = poses32[f][key];
+            if (!a || !b) {
+                mismatches++;
+                console.log('frame ' + f + ' ' + key + ': found by ' + (a ? 'double' : 'float') + ' build only');
+                continue;
+            }
+            const dt = translationDiff(a.pose, b.pose);
+            const dr = rotationDiff(a.pose, b.pose);
+            compared++;
+            sumT += dt;
+            sumR += dr;
+            maxT = Math.max(maxT, dt);
+            maxR = Math.max(maxR, dr);
+            if (dt > tolerance.translation || dr > tolerance.rotation) {
+                failures++;
+                console.log('frame ' + f + ' ' + key + ': translation diff ' + dt.toExponential(3) + ', rotation diff ' + dr.toExponential(3));
+            }
+        }
+    }
+
+    console.log('frames: ' + poses64.length + ', poses compared: ' + compared + ', detection mismatches: ' + mismatches);
+    if (compared) {
+        console.log('translation diff: mean ' + (sumT / compared).toExponential(3) + ', max ' + maxT.toExponential(3) + ' (tolerance ' + tolerance.translation + ')');
+        console.log('rotation diff:    mean ' + (sumR / compared).toExponential(3) + ', max ' + maxR.toExponential(3) + ' rad (tolerance ' + tolerance.rotation + ')');
+    }
+
+    const ok = compared > 0 && mismatches === 0 && failures === 0;
+    console.log(ok ? 'PASS' : 'FAIL');
+    process.exit(ok ? 0 : 1);
+}
+
+main().catch((e) => {
+    console.error(e);
+    process.exit(1);
+});
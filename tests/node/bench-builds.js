@@ -0,0 +1,97 @@
+/*
+ * Compares the speed of the WebAssembly builds on the labeling, adaptive threshold, KPM and AR2 workloads.
+ *
+ *   node tests/node/bench-builds.js [manifest.json] [--build file.js ...] [--iterations n] [--json report.json]
+ *
+ * By default the builds in build/ are compared (artoolkit_wasm.js, artoolkit_wasm_simd.js and
+ * artoolkit_wasm_float.js, those that exist) over the frames of bench.json next to this file.
+ * The first build is the baseline the speedups are relative to. Builds run one after the other,
+ * each in its own process, so they don't compete for the CPU. See timings.js for the workloads.
+ */
+
+const fs = require('fs');
+const path = require('path');
+const fork = require('child_process').fork;
+
+const WORKLOADS = ['labeling', 'adaptive', 'kpm', 'ar2'];
+
+function parseArgs(argv) {
+    const args = {
+        manifest: path.resolve(__dirname, 'bench.json'),
+        builds: [],
+        iterations: 5,
+        json: null
+    };
+    for (let i = 0; i < argv.length; i++) {
+        if (argv[i] === '--build') args.builds.push(path.resolve(argv[++i]));
+        else if (argv[i] === '--iterations') args.iterations = parseInt(argv[++i]);
+        else if (argv[i] === '--json') args.json = path.resolve(argv[++i]);
+        else args.manifest = path.resolve(argv[i]);
+    }
+    if (!args.builds.length) {
+        args.builds = ['artoolkit_wasm.js', 'artoolkit_wasm_simd.js', 'artoolkit_wasm_float.js']
+            .map((file) => path.resolve(__dirname, '../../build', file))
+            .filter((file) => fs.existsSync(file));
+    }
+    return args;
+}
+
+function runBuild(build, manifest, iterations) {
+    return new Promise((resolve, reject) => {
+        const child = fork(path.resolve(__dirname, 'timings.js'), [build, manifest, iterations], { silent: true });
+        let result;
+        child.on('message', (m) => { result = m; });
+        child.stderr.on('data', (d) => process.stderr.write(d));
+        child.on('exit', (code) => {
+            if (code === 0 && result) resolve(result);
+            else reject(new Error(path.basename(build) + ' exited with ' + code));
+        });
+    });
+}
+
+function pad(s, n) {
+    s = String(s);
+    return s + ' '.repeat(Math.max(0, n - s.length));
+}
+
+async function main() {
+    const args = parseArgs(process.argv.slice(2));
+    if (!args.builds.length) throw new Error('No builds found, run npm run build-local first or pass --build');
+
+    const results = [];
+    for (const build of args.builds) {
+        results.push(await runBuild(build, args.manifest, args.iterations));
+    }
+
+    const baseline = results[0];
+    console.log(pad('build', 26) + WORKLOADS.map((w) => pad(w + ' median ms', 20)).join(''));
+    for (const result of results) {
+        let line = pad(result.build, 26);
+        for (const w of WORKLOADS) {
+            const s = result[w];
+            if (!s) {
+                line += pad('n/a', 20);
+                continue;
+            }
+            const base = baseline[w];
+            s.speedup = base ? base.median / s.median : null;
+            line += pad(s.median.toFixed(2) + (result !== baseline && s.speedup ? ' (x' + s.speedup.toFixed(2) + ')' : ''), 20);
+        }
+        console.log(line);
+    }
+
+    if (args.json) {
+        fs.writeFileSync(args.json, JSON.stringify({
+            manifest: args.manifest,
+            iterations: args.iterations,
+            baseline: baseline.build,
+            results: results
+        }, null, 2));
+        console.log('Report written to ' + args.json);
+    }
+}
+
+main().catch((e) => {
+    console.error(e);
+    process.exit(1);
+});
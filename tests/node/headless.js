@@ -0,0 +1,177 @@
+/*
+ * Loads a jsartoolkit5 build (artoolkit_wasm.js, artoolkit_wasm_float.js, ...) in node.js,
+ * without a browser, for the accuracy and benchmark scripts.
+ *
+ *   const headless = require('./headless');
+ *   headless.load('../../build/artoolkit_wasm.js').then(({ artoolkit, ARController, ARCameraParam }) => { ... });
+ *
+ * Files requested by the JS API (camera parameters, patterns, NFT data) are read from the local
+ * file system, relative to the current working directory unless absolute.
+ */
+
+const fs = require('fs');
+const path = require('path');
+const synthetic = require('./synthetic');
+
+// Minimal XMLHttpRequest backed by the file system, enough for the ajax() helper in artoolkit.api.js.
+class FileXMLHttpRequest {
+    open(method, url) {
+        this.url = url;
+        this.status = 0;
+        this.response = null;
+    }
+
+    send() {
+        setTimeout(() => {
+            let data;
+            try {
+                data = fs.readFileSync(path.resolve(this.url));
+            } catch (e) {
+                this.status = 404;
+                if (this.onload) this.onload();
+                return;
+            }
+            this.status = 200;
+            this.response = data.buffer.slice(data.byteOffset, data.byteOffset + data.byteLength);
+            if (this.onload) this.onload();
+        }, 0);
+    }
+}
+
+function load(buildPath, timeout) {
+    timeout = timeout || 10000;
+
+    global.self = global;
+    global.XMLHttpRequest = FileXMLHttpRequest;
+    // Emscripten prefers fetch() when it exists, which can not load the .wasm from a file path.
+    delete global.fetch;
+
+    require(path.resolve(buildPath));
+
+    return new Promise((resolve, reject) => {
+        const t0 = Date.now();
+        const check = () => {
+            if (global.artoolkit && global.artoolkit.setup) {
+                resolve({
+                    artoolkit: global.artoolkit,
+                    ARController: global.ARController,
+                    ARCameraParam: global.ARCameraParam
+                });
+            } else if (Date.now() - t0 > timeout) {
+                reject(new Error('Timed out loading ' + buildPath));
+            } else {
+                setTimeout(check, 10);
+            }
+        };
+        check();
+    });
+}
+
+function loadCamera(ARCameraParam, url) {
+    return new Promise((resolve, reject) => {
+        const cameraParam = new ARCameraParam(url, () => resolve(cameraParam), reject);
+    });
+}
+
+function loadMarker(arController, url) {
+    return new Promise((resolve, reject) => {
+        arController.loadMarker(url, resolve, reject);
+    });
+}
+
+function loadNFTMarker(arController, url) {
+    return new Promise((resolve, reject) => {
+        arController.loadNFTMarker(url, resolve, reject);
+    });
+}
+
+/*
+ * Reads a frame as an ImageData-like object { width, height, data } with RGBA data.
+ * Supports binary PPM (P6), binary PGM (P5) and raw RGBA files (.rgba, width and height must be given).
+ */
+function readFrame(file, width, height) {
+    const buf = fs.readFileSync(file);
+    if (path.extname(file) === '.rgba') {
+        return { width: width, height: height, data: new Uint8ClampedArray(buf.buffer, buf.byteOffset, width * height * 4) };
+    }
+
+    const header = [];
+    let pos = 0;
+    while (header.length < 4) {
+        while (/\s/.test(String.fromCharCode(buf[pos]))) pos++;
+        if (buf[pos] === 0x23) { // comment
+            while (buf[pos] !== 0x0a) pos++;
+            continue;
+        }
+        let token = '';
+        while (!/\s/.test(String.fromCharCode(buf[pos]))) token += String.fromCharCode(buf[pos++]);
+        header.push(token);
+    }
+    pos++;
+
+    const w = parseInt(header[1]), h = parseInt(header[2]);
+    const channels = header[0] === 'P6' ? 3 : 1;
+    if ((header[0] !== 'P6' && header[0] !== 'P5') || header[3] !== '255') {
+        throw new Error(file + ': only 8-bit binary PPM/PGM is supported');
+    }
+    const data = new Uint8ClampedArray(w * h * 4);
+    for (let i = 0, j = pos; i < w * h; i++, j += channels) {
+        data[i * 4 + 0] = buf[j];
+        data[i * 4 + 1] = channels === 3 ? buf[j + 1] : buf[j];
+        data[i * 4 + 2] = channels === 3 ? buf[j + 2] : buf[j];
+        data[i * 4 + 3] = 255;
+    }
+    return { width: w, height: h, data: data };
+}
+
+/*
+ * Reads a frame manifest (see accuracy.json) and resolves its paths relative to the manifest.
+ * frames are either file paths (see readFrame), { synthetic: <.patt file>, corners, background } or
+ * rendered at a pose, { synthetic: <.patt or .iset file> or matrix: id, pose, ... } (see synthetic.json).
+ */
+function readManifest(file) {
+    const manifest = JSON.parse(fs.readFileSync(file, 'utf8'));
+    const abs = (p) => path.resolve(path.dirname(path.resolve(file)), p);
+
+    manifest.camera = abs(manifest.camera);
+    manifest.markers.forEach((m) => { m.url = abs(m.url); });
+    manifest.frames = manifest.frames.map((f) => {
+        if (typeof f === 'string') return { file: abs(f) };
+        if (f.synthetic) f.synthetic = abs(f.synthetic);
+        if (f.file) f.file = abs(f.file);
+        return f;
+    });
+    return manifest;
+}
+
+/*
+ * Returns the RGBA frames of a manifest, rendering the synthetic ones. Frames rendered at a pose
+ * carry the ground truth as image.pose, see synthetic.renderScene().
+ */
+function readFrames(manifest) {
+    const patterns = {};
+    const surfaces = {};
+    let camera = null;
+    return manifest.frames.map((frame) => {
+        if (frame.pose) {
+            if (!camera) camera = synthetic.readCamera(manifest.camera);
+            const options = Object.assign({}, frame, { width: manifest.width, height: manifest.height, camera: camera });
+            return synthetic.renderScene(synthetic.frameSurface(frame, surfaces), options);
+        }
+        if (frame.synthetic) {
+            if (!patterns[frame.synthetic]) patterns[frame.synthetic] = synthetic.readPattern(frame.synthetic);
+            return synthetic.renderMarker(patterns[frame.synthetic], manifest.width, manifest.height, frame.corners, frame.background);
+        }
+        return readFrame(frame.file, manifest.width, manifest.height);
+    });
+}
+
+module.exports = {
+    load: load,
+    loadCamera: loadCamera,
+    loadMarker: loadMarker,
+    loadNFTMarker: loadNFTMarker,
+    readFrame: readFrame,
+    readManifest: readManifest,
+    readFrames: readFrames
+};
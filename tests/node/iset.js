@@ -0,0 +1,209 @@
+/*
+ * Reads the full resolution image of an NFT image set (.iset), for rendering NFT markers into
+ * synthetic frames. An .iset starts with the number of scales and the first scale as a grayscale
+ * baseline JPEG, whose density is the image dpi; the other scales are only dpi values.
+ *
+ * Includes a minimal baseline JPEG decoder (8-bit, one component), which is all .iset files use,
+ * since node.js has none and the scripts have no dependencies.
+ */
+
+const fs = require('fs');
+
+const ZIGZAG = [
+    0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+];
+
+// IDCT_COS[x * 8 + u] = C(u) / 2 * cos((2x + 1) u pi / 16)
+const IDCT_COS = new Float64Array(64);
+for (let x = 0; x < 8; x++) {
+    for (let u = 0; u < 8; u++) {
+        IDCT_COS[x * 8 + u] = (u === 0 ? Math.SQRT1_2 : 1) / 2 * Math.cos((2 * x + 1) * u * Math.PI / 16);
+    }
+}
+
+function buildHuffman(counts, symbols) {
+    // Canonical codes: maxCode[l] is the largest code of length l, offset[l] maps a code to its symbol.
+    const maxCode = new Int32Array(18).fill(-1);
+    const offset = new Int32Array(17);
+    let code = 0, k = 0;
+    for (let l = 1; l <= 16; l++) {
+        offset[l] = k - code;
+        code += counts[l - 1];
+        k += counts[l - 1];
+        if (counts[l - 1]) maxCode[l] = code - 1;
+        code <<= 1;
+    }
+    maxCode[17] = 0x7fffffff;
+    return { maxCode: maxCode, offset: offset, symbols: symbols };
+}
+
+class BitReader {
+    constructor(bytes, pos) {
+        this.bytes = bytes;
+        this.pos = pos;
+        this.acc = 0;
+        this.bits = 0;
+    }
+
+    bit() {
+        if (this.bits === 0) {
+            let b = 0;
+            // A marker (0xFF not followed by 0) ends the entropy-coded data, pad with zeros.
+            if (this.pos < this.bytes.length && !(this.bytes[this.pos] === 0xff && this.bytes[this.pos + 1] !== 0)) {
+                b = this.bytes[this.pos++];
+                if (b === 0xff) this.pos++; // stuffed 0
+            }
+            this.acc = b;
+            this.bits = 8;
+        }
+        this.bits--;
+        return (this.acc >> this.bits) & 1;
+    }
+
+    receive(n) {
+        let v = 0;
+        for (let i = 0; i < n; i++) v = (v << 1) | this.bit();
+        return v;
+    }
+
+    // Value of an n-bit coefficient, JPEG EXTEND.
+    extend(n) {
+        if (n === 0) return 0;
+        const v = this.receive(n);
+        return v < (1 << (n - 1)) ? v - (1 << n) + 1 : v;
+    }
+
+    decode(table) {
+        let code = this.bit(), l = 1;
+        while (code > table.maxCode[l]) {
+            code = (code << 1) | this.bit();
+            l++;
+        }
+        if (l > 16) throw new Error('Invalid Huffman code');
+        return table.symbols[code + table.offset[l]];
+    }
+
+    // Skips the RSTn marker of a restart interval.
+    restart() {
+        this.bits = 0;
+        while (this.pos < this.bytes.length && !(this.bytes[this.pos] === 0xff && this.bytes[this.pos + 1] >= 0xd0 && this.bytes[this.pos + 1] <= 0xd7)) this.pos++;
+        this.pos += 2;
+    }
+}
+
+/*
+ * Decodes a baseline grayscale JPEG starting at bytes[start].
+ * Returns { width, height, dpi, data: Uint8Array (width * height) }.
+ */
+function decodeJPEG(bytes, start) {
+    let pos = start || 0;
+    if (bytes[pos] !== 0xff || bytes[pos + 1] !== 0xd8) throw new Error('Not a JPEG image');
+    pos += 2;
+
+    const quant = [], dcTables = [], acTables = [];
+    let width = 0, height = 0, dpi = 72, restartInterval = 0, component = null;
+
+    for (;;) {
+        if (bytes[pos] !== 0xff) throw new Error('Invalid JPEG marker at ' + pos);
+        const marker = bytes[pos + 1];
+        const length = (bytes[pos + 2] << 8) | bytes[pos + 3];
+        const seg = pos + 4, end = pos + 2 + length;
+
+        if (marker === 0xe0 && bytes[seg] === 0x4a && bytes[seg + 7] === 1) { // JFIF, density in dots per inch
+            dpi = (bytes[seg + 8] << 8) | bytes[seg + 9];
+        } else if (marker === 0xdb) { // DQT
+            for (let p = seg; p < end; p += 65) {
+                if (bytes[p] >> 4) throw new Error('16-bit quantization tables are not supported');
+                quant[bytes[p] & 15] = bytes.subarray(p + 1, p + 65);
+            }
+        } else if (marker === 0xc4) { // DHT
+            for (let p = seg; p < end;) {
+                const tc = bytes[p] >> 4, th = bytes[p] & 15;
+                const counts = bytes.subarray(p + 1, p + 17);
+                const n = counts.reduce((a, b) => a + b, 0);
+                (tc ? acTables : dcTables)[th] = buildHuffman(counts, bytes.subarray(p + 17, p + 17 + n));
+                p += 17 + n;
+            }
+        } else if (marker === 0xdd) { // DRI
+            restartInterval = (bytes[seg] << 8) | bytes[seg + 1];
+        } else if (marker === 0xc0) { // SOF0
+            height = (bytes[seg + 1] << 8) | bytes[seg + 2];
+            width = (bytes[seg + 3] << 8) | bytes[seg + 4];
+            if (bytes[seg] !== 8 || bytes[seg + 5] !== 1) throw new Error('Only 8-bit grayscale baseline JPEG is supported');
+            component = { quant: bytes[seg + 8] };
+        } else if (marker >= 0xc1 && marker <= 0xcf && marker !== 0xc4 && marker !== 0xc8 && marker !== 0xcc) {
+            throw new Error('Only baseline JPEG is supported');
+        } else if (marker === 0xda) { // SOS
+            const tables = bytes[seg + 2];
+            component.dc = dcTables[tables >> 4];
+            component.ac = acTables[tables & 15];
+            pos = end;
+            break;
+        }
+        pos = end;
+    }
+
+    const blocksW = Math.ceil(width / 8), blocksH = Math.ceil(height / 8);
+    const data = new Uint8Array(width * height);
+    const reader = new BitReader(bytes, pos);
+    const q = quant[component.quant];
+    const coef = new Float64Array(64), tmp = new Float64Array(64);
+    let pred = 0;
+
+    for (let b = 0; b < blocksW * blocksH; b++) {
+        if (restartInterval && b > 0 && b % restartInterval === 0) {
+            reader.restart();
+            pred = 0;
+        }
+        coef.fill(0);
+        pred += reader.extend(reader.decode(component.dc));
+        coef[0] = pred * q[0];
+        for (let k = 1; k < 64;) {
+            const rs = reader.decode(component.ac);
+            const r = rs >> 4, s = rs & 15;
+            if (s === 0) {
+                if (r !== 15) break; // EOB
+                k += 16;
+                continue;
+            }
+            k += r;
+            coef[ZIGZAG[k]] = reader.extend(s) * q[k];
+            k++;
+        }
+
+        // Separable IDCT: rows, then columns.
+        for (let y = 0; y < 8; y++) {
+            for (let x = 0; x < 8; x++) {
+                let sum = 0;
+                for (let u = 0; u < 8; u++) sum += IDCT_COS[x * 8 + u] * coef[y * 8 + u];
+                tmp[y * 8 + x] = sum;
+            }
+        }
+        const bx = (b % blocksW) * 8, by = Math.floor(b / blocksW) * 8;
+        for (let x = 0; x < 8 && bx + x < width; x++) {
+            for (let y = 0; y < 8 && by + y < height; y++) {
+                let sum = 0;
+                for (let v = 0; v < 8; v++) sum += IDCT_COS[y * 8 + v] * tmp[v * 8 + x];
+                data[(by + y) * width + bx + x] = Math.max(0, Math.min(255, Math.round(sum + 128)));
+            }
+        }
+    }
+
+    return { width: width, height: height, dpi: dpi, data: data };
+}
+
+/*
+ * Reads the full resolution image of an .iset file as { width, height, dpi, data } with one byte per pixel.
+ */
+function readImageSet(file) {
+    const bytes = fs.readFileSync(file);
+    return decodeJPEG(bytes, 4);
+}
+
+module.exports = {
+    decodeJPEG: decodeJPEG,
+    readImageSet: readImageSet
+};
@@ -0,0 +1,80 @@
+/*
+ * Runs marker detection with one build over the frames of a manifest and collects the poses.
+ * Used by accuracy.js, which runs it once per build in a child process since each build
+ * defines the same globals.
+ *
+ *   node tests/node/poses.js <build.js> <manifest.json>
+ *
+ * When forked, the result is sent to the parent; otherwise it is printed as JSON.
+ */
+
+const headless = require('./headless');
+
+async function collectPoses(buildPath, manifestPath) {
+    const manifest = headless.readManifest(manifestPath);
+    const frames = headless.readFrames(manifest);
+    const { artoolkit, ARController, ARCameraParam } = await headless.load(buildPath);
+    artoolkit.setLogLevel(artoolkit.AR_LOG_LEVEL_ERROR);
+
+    const cameraParam = await headless.loadCamera(ARCameraParam, manifest.camera);
+    const arController = new ARController(manifest.width, manifest.height, cameraParam);
+
+    const patterns = {}; // pattern id -> marker width
+    const nftMarkers = []; // NFT marker index -> marker width
+    for (const marker of manifest.markers) {
+        if (marker.type === 'nft') {
+            nftMarkers[await headless.loadNFTMarker(arController, marker.url)] = marker.width;
+        } else {
+            patterns[await headless.loadMarker(arController, marker.url)] = marker.width;
+        }
+    }
+
+    const results = [];
+    for (const image of frames) {
+        const found = {};
+
+        arController.detectMarker(image);
+        const markerNum = arController.getMarkerNum();
+        for (let i = 0; i < markerNum; i++) {
+            const info = arController.getMarker(i);
+            if (!(info.idPatt in patterns) || (info.id !== info.idPatt && info.idMatrix !== -1)) continue;
+            const key = 'pattern:' + info.idPatt;
+            if (found[key] && found[key].cf >= info.cfPatt) continue;
+            if (info.dir !== info.dirPatt) {
+                arController.setMarkerInfoDir(i, info.dirPatt);
+            }
+            const pose = arController.getTransMatSquare(i, patterns[info.idPatt], new Float64Array(12));
+            found[key] = { cf: info.cfPatt, pose: Array.from(pose) };
+        }
+
+        if (nftMarkers.length) {
+            arController.detectNFTMarker();
+            for (let i = 0; i < nftMarkers.length; i++) {
+                const info = arController.getNFTMarker(i);
+                if (info.found) {
+                    found['nft:' + i] = { cf: 1, pose: info.pose.slice() };
+                }
+            }
+        }
+        results.push(found);
+    }
+
+    arController.dispose();
+    return results;
+}
+
+module.exports = collectPoses;
+
+if (require.main === module) {
+    collectPoses(process.argv[2], process.argv[3]).then((results) => {
+        if (process.send) {
+            process.send(results, () => process.exit(0));
+        } else {
+            console.log(JSON.stringify(results));
+            process.exit(0);
+        }
+    }).catch((e) => {
+        console.error(e);
+        process.exit(1);
+    });
+}
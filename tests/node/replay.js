@@ -0,0 +1,274 @@
+/*
+ * Replays a frame sequence through a build and reports throughput, latency percentiles and the
+ * time spent in each stage of the frame pipeline, as a table and optionally as JSON.
+ *
+ *   node tests/node/replay.js [manifest.json] [--build file.js] [--frames dir] [--capture file.arcl]
+ *                             [--iterations n] [--json report.json] [--baseline report.json] [--max-regression percent]
+ *
+ * The frames are those of the manifest (default: bench.json next to this file), or the .ppm, .pgm and
+ * .rgba files of --frames in name order, e.g. a recorded sequence. Each frame goes through:
+ *
+ *   detect      detectMarker()
+ *   pose        getMarker() and getTransMatSquare() for every known pattern marker found
+ *   nft_detect  detectNFTMarker()
+ *   nft_info    getNFTMarker() for every NFT marker
+ *
+ * With --capture, the frames, camera, markers and settings are those of a capture log recorded with
+ * ARController.prototype.startCapture(). The first pass also checks that the results are the recorded
+ * ones and prints the differences. detect then excludes the luma conversion, and NFT markers are only
+ * queried when the application did so.
+ *
+ * With --baseline, exits with 1 if the p50 of the frame time or of a stage is more than
+ * --max-regression percent (default 10) slower than in the baseline report, for CI.
+ * artoolkit_cli -b writes the same report for the native build.
+ */
+
+const fs = require('fs');
+const path = require('path');
+const headless = require('./headless');
+
+const STAGES = ['detect', 'pose', 'nft_detect', 'nft_info', 'total'];
+
+function parseArgs(argv) {
+    const args = {
+        manifest: path.resolve(__dirname, 'bench.json'),
+        build: path.resolve(__dirname, '../../build/artoolkit_wasm.js'),
+        frames: null,
+        capture: null,
+        iterations: 5,
+        json: null,
+        baseline: null,
+        maxRegression: 10
+    };
+    for (let i = 0; i < argv.length; i++) {
+        if (argv[i] === '--build') args.build = path.resolve(argv[++i]);
+        else if (argv[i] === '--frames') args.frames = path.resolve(argv[++i]);
+        else if (argv[i] === '--capture') args.capture = path.resolve(argv[++i]);
+        else if (argv[i] === '--iterations') args.iterations = parseInt(argv[++i]);
+        else if (argv[i] === '--json') args.json = path.resolve(argv[++i]);
+        else if (argv[i] === '--baseline') args.baseline = path.resolve(argv[++i]);
+        else if (argv[i] === '--max-regression') args.maxRegression = parseFloat(argv[++i]);
+        else args.manifest = path.resolve(argv[i]);
+    }
+    return args;
+}
+
+function percentile(sorted, p) {
+    return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p / 100))];
+}
+
+function stageStats(samples) {
+    const sorted = samples.slice().sort((a, b) => a - b);
+    return {
+        mean: sorted.reduce((a, b) => a + b, 0) / sorted.length,
+        p50: percentile(sorted, 50),
+        p99: percentile(sorted, 99),
+        max: sorted[sorted.length - 1]
+    };
+}
+
+function readSequence(dir, width, height) {
+    return fs.readdirSync(dir)
+        .filter((file) => ['.ppm', '.pgm', '.rgba'].indexOf(path.extname(file)) > -1)
+        .sort()
+        .map((file) => headless.readFrame(path.join(dir, file), width, height));
+}
+
+function fromCapture(ARController, capture) {
+    return new Promise((resolve, reject) => {
+        ARController.fromCapture(capture, (arController, ids) => resolve({ arController, ids }), reject);
+    });
+}
+
+async function replayCapture(args) {
+    const { artoolkit, ARController } = await headless.load(args.build);
+    artoolkit.setLogLevel(artoolkit.AR_LOG_LEVEL_ERROR);
+
+    const capture = artoolkit.readCapture(fs.readFileSync(args.capture));
+    if (!capture.frames.length) throw new Error('No frames in ' + args.capture);
+    const { arController, ids } = await fromCapture(ARController, capture);
+    const pattWidths = {};
+    capture.markers.forEach((marker, i) => { if (marker.type === 0) pattWidths[ids[i]] = 80; });
+
+    const samples = {};
+    STAGES.forEach((stage) => { samples[stage] = []; });
+    const matrix = new Float64Array(12);
+    const now = () => Number(process.hrtime.bigint()) / 1e6;
+    let elapsed = 0;
+    let differing = 0;
+
+    // The first pass checks the results and warms up the JIT, it is not timed.
+    for (let it = 0; it <= args.iterations; it++) {
+        arController.resetTracking();
+        const t0 = now();
+        capture.frames.forEach((frame, f) => {
+            if (it === 0) {
+                const differences = arController.replayFrame(frame);
+                if (differences.length) {
+                    differing++;
+                    console.log('frame ' + f + ': ' + differences.join(', '));
+                }
+                return;
+            }
+            arController.loadCaptureFrame(frame);
+            const t = [now()];
+            artoolkit.detectMarker(arController.id);
+            t.push(now());
+
+            const markerNum = arController.getMarkerNum();
+            for (let i = 0; i < markerNum; i++) {
+                const info = arController.getMarker(i);
+                if (info.idPatt < 0 || (info.id !== info.idPatt && info.idMatrix !== -1) || !(info.idPatt in pattWidths)) continue;
+                if (info.dir !== info.dirPatt) arController.setMarkerInfoDir(i, info.dirPatt);
+                arController.getTransMatSquare(i, pattWidths[info.idPatt], matrix);
+            }
+            t.push(now());
+
+            if (frame.nftDetect) arController.detectNFTMarker();
+            t.push(now());
+            for (const nft of frame.nft) arController.getNFTMarker(nft.index);
+            t.push(now());
+
+            for (let s = 0; s < 4; s++) samples[STAGES[s]].push(t[s + 1] - t[s]);
+            samples.total.push(t[4] - t[0]);
+        });
+        if (it > 0) elapsed += now() - t0;
+    }
+    arController.dispose();
+    console.log(args.capture + ': ' + (capture.frames.length - differing) + ' of ' + capture.frames.length + ' frames replayed with the recorded results');
+
+    return {
+        runner: 'node',
+        build: path.basename(args.build, '.js'),
+        frames: capture.frames.length,
+        iterations: args.iterations,
+        fps: samples.total.length / (elapsed / 1000),
+        stages: STAGES.reduce((stages, stage) => { stages[stage] = stageStats(samples[stage]); return stages; }, {})
+    };
+}
+
+async function replay(args) {
+    if (args.capture) return replayCapture(args);
+    const manifest = headless.readManifest(args.manifest);
+    const frames = args.frames ? readSequence(args.frames, manifest.width, manifest.height) : headless.readFrames(manifest);
+    if (!frames.length) throw new Error('No frames to replay');
+
+    const { artoolkit, ARController, ARCameraParam } = await headless.load(args.build);
+    artoolkit.setLogLevel(artoolkit.AR_LOG_LEVEL_ERROR);
+
+    const cameraParam = await headless.loadCamera(ARCameraParam, manifest.camera);
+    const arController = new ARController(frames[0].width, frames[0].height, cameraParam);
+    const pattWidths = {};
+    let nftMarkerNum = 0;
+    for (const marker of manifest.markers) {
+        if (marker.type === 'nft') {
+            await headless.loadNFTMarker(arController, marker.url);
+            nftMarkerNum++;
+        } else {
+            pattWidths[await headless.loadMarker(arController, marker.url)] = marker.width || 80;
+        }
+    }
+
+    const samples = {};
+    STAGES.forEach((stage) => { samples[stage] = []; });
+    const matrix = new Float64Array(12);
+    const now = () => Number(process.hrtime.bigint()) / 1e6;
+    let elapsed = 0;
+
+    // The first pass warms up the JIT and is not recorded.
+    for (let it = 0; it <= args.iterations; it++) {
+        const t0 = now();
+        for (const image of frames) {
+            const t = [now()];
+            arController.detectMarker(image);
+            t.push(now());
+
+            const markerNum = arController.getMarkerNum();
+            for (let i = 0; i < markerNum; i++) {
+                const info = arController.getMarker(i);
+                // Same rule as ARController.prototype.process.
+                if (info.idPatt < 0 || (info.id !== info.idPatt && info.idMatrix !== -1) || !(info.idPatt in pattWidths)) continue;
+                if (info.dir !== info.dirPatt) arController.setMarkerInfoDir(i, info.dirPatt);
+                arController.getTransMatSquare(i, pattWidths[info.idPatt], matrix);
+            }
+            t.push(now());
+
+            if (nftMarkerNum) arController.detectNFTMarker();
+            t.push(now());
+            for (let i = 0; i < nftMarkerNum; i++) arController.getNFTMarker(i);
+            t.push(now());
+
+            if (it > 0) {
+                for (let s = 0; s < 4; s++) samples[STAGES[s]].push(t[s + 1] - t[s]);
+                samples.total.push(t[4] - t[0]);
+            }
+        }
+        if (it > 0) elapsed += now() - t0;
+    }
+    arController.dispose();
+
+    const report = {
+        runner: 'node',
+        build: path.basename(args.build, '.js'),
+        frames: frames.length,
+        iterations: args.iterations,
+        fps: samples.total.length / (elapsed / 1000),
+        stages: {}
+    };
+    STAGES.forEach((stage) => { report.stages[stage] = stageStats(samples[stage]); });
+    return report;
+}
+
+function pad(s, n) {
+    s = String(s);
+    return s + ' '.repeat(Math.max(0, n - s.length));
+}
+
+function printReport(report) {
+    console.log(report.build + ': ' + report.frames + ' frames x ' + report.iterations + ' iterations, ' + report.fps.toFixed(1) + ' frames/s');
+    console.log(pad('stage', 14) + ['mean', 'p50', 'p99', 'max'].map((k) => pad(k + ' ms', 12)).join(''));
+    for (const stage of STAGES) {
+        const s = report.stages[stage];
+        console.log(pad(stage, 14) + ['mean', 'p50', 'p99', 'max'].map((k) => pad(s[k].toFixed(3), 12)).join(''));
+    }
+}
+
+// Stages faster than this are too short to compare reliably.
+const MIN_COMPARED_MS = 0.05;
+
+function compare(report, baseline, maxRegression) {
+    let regressions = 0;
+    for (const stage of STAGES) {
+        const base = baseline.stages[stage], cur = report.stages[stage];
+        if (!base || !cur || base.p50 < MIN_COMPARED_MS) continue;
+        const change = (cur.p50 / base.p50 - 1) * 100;
+        if (change > maxRegression) {
+            regressions++;
+            console.log(stage + ': p50 ' + cur.p50.toFixed(3) + ' ms, ' + change.toFixed(1) + '% slower than the baseline (' + base.p50.toFixed(3) + ' ms)');
+        }
+    }
+    return regressions;
+}
+
+async function main() {
+    const args = parseArgs(process.argv.slice(2));
+    const report = await replay(args);
+    printReport(report);
+
+    if (args.json) {
+        fs.writeFileSync(args.json, JSON.stringify(report, null, 2));
+        console.log('Report written to ' + args.json);
+    }
+
+    if (args.baseline) {
+        const regressions = compare(report, JSON.parse(fs.readFileSync(args.baseline, 'utf8')), args.maxRegression);
+        console.log(regressions ? 'FAIL' : 'PASS');
+        process.exit(regressions ? 1 : 0);
+    }
+    process.exit(0);
+}
+
+main().catch((e) => {
+    console.error(e);
+    process.exit(1);
+});
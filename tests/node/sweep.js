@@ -0,0 +1,217 @@
+/*
+ * Accuracy against speed of the detection settings, over synthetic frames rendered at known poses.
+ *
+ *   node tests/node/sweep.js [manifest.json] [--build file.js] [--iterations n] [--json report.json]
+ *
+ * The frames are those of the manifest (default: synthetic.json next to this file) that have a pose,
+ * see synthetic.renderScene(). Starting from the settings of the manifest, each knob of its "sweep"
+ * object (default: KNOBS) is set to each of its values in turn, an ARController setter name mapped to
+ * the values, given as numbers or artoolkit constant names. For every value the frames are processed
+ * iterations times and the script reports the share of frames whose marker was found, the translation
+ * error (in marker units, usually mm) and rotation error (degrees) of the poses against the ground
+ * truth, and the time per frame.
+ *
+ * Square marker frames go through detectMarker() and getTransMatSquare(), NFT frames (.iset) through
+ * detectMarker(), detectNFTMarker() and getNFTMarker(). Tracking is reset before each frame, so that every
+ * frame is a first detection and the results do not depend on the frame order. Knobs of frame to frame
+ * tracking, e.g. setNFTSearchFeatureNum, need a sequence instead, see replay.js.
+ *
+ * Square marker poses are biased by about a pixel since the corners are fitted to the contour pixels,
+ * inside the edge: expect translation errors of about 1% of the distance even with ideal frames.
+ */
+
+const fs = require('fs');
+const path = require('path');
+const headless = require('./headless');
+
+const KNOBS = {
+    setThresholdMode: [
+        'AR_LABELING_THRESH_MODE_MANUAL',
+        'AR_LABELING_THRESH_MODE_AUTO_MEDIAN',
+        'AR_LABELING_THRESH_MODE_AUTO_OTSU',
+        'AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE'
+    ],
+    setThreshold: [40, 70, 100, 130, 160, 190],
+    setImageProcMode: ['AR_IMAGE_PROC_FRAME_IMAGE', 'AR_IMAGE_PROC_FIELD_IMAGE'],
+    setPatternDetectionMode: [
+        'AR_TEMPLATE_MATCHING_COLOR',
+        'AR_TEMPLATE_MATCHING_MONO',
+        'AR_MATRIX_CODE_DETECTION',
+        'AR_TEMPLATE_MATCHING_COLOR_AND_MATRIX',
+        'AR_TEMPLATE_MATCHING_MONO_AND_MATRIX'
+    ]
+};
+
+function parseArgs(argv) {
+    const args = {
+        manifest: path.resolve(__dirname, 'synthetic.json'),
+        build: path.resolve(__dirname, '../../build/artoolkit_wasm.js'),
+        iterations: 3,
+        json: null
+    };
+    for (let i = 0; i < argv.length; i++) {
+        if (argv[i] === '--build') args.build = path.resolve(argv[++i]);
+        else if (argv[i] === '--iterations') args.iterations = parseInt(argv[++i]);
+        else if (argv[i] === '--json') args.json = path.resolve(argv[++i]);
+        else args.manifest = path.resolve(argv[i]);
+    }
+    return args;
+}
+
+// Angle in degrees of the rotation between two 3x4 row-major poses.
+function rotationError(a, b) {
+    let trace = 0;
+    for (let r = 0; r < 3; r++) {
+        for (let c = 0; c < 3; c++) trace += a[r * 4 + c] * b[r * 4 + c];
+    }
+    return Math.acos(Math.max(-1, Math.min(1, (trace - 1) / 2))) * 180 / Math.PI;
+}
+
+function translationError(a, b) {
+    return Math.hypot(a[3] - b[3], a[7] - b[7], a[11] - b[11]);
+}
+
+function applySettings(artoolkit, arController, settings) {
+    for (const name in settings) {
+        const value = settings[name];
+        if (typeof value === 'string' && artoolkit[value] === undefined) throw new Error('Unknown constant ' + value);
+        arController[name](typeof value === 'string' ? artoolkit[value] : value);
+    }
+}
+
+function mean(values) {
+    return values.length ? values.reduce((a, b) => a + b, 0) / values.length : NaN;
+}
+
+async function sweep(args) {
+    const manifest = headless.readManifest(args.manifest);
+    const frames = headless.readFrames(manifest);
+    const posed = [];
+    manifest.frames.forEach((frame, i) => {
+        if (frames[i].pose) posed.push({ frame: frame, image: frames[i] });
+    });
+    if (!posed.length) throw new Error('No frames with a pose in ' + args.manifest);
+
+    const { artoolkit, ARController, ARCameraParam } = await headless.load(args.build);
+    artoolkit.setLogLevel(artoolkit.AR_LOG_LEVEL_ERROR);
+
+    const cameraParam = await headless.loadCamera(ARCameraParam, manifest.camera);
+    const arController = new ARController(manifest.width, manifest.height, cameraParam);
+    const patternIds = {}; // .patt file -> pattern id
+    const nftIndices = {}; // .iset file -> NFT marker index
+    for (const marker of manifest.markers) {
+        if (marker.type === 'nft') nftIndices[marker.url + '.iset'] = await headless.loadNFTMarker(arController, marker.url);
+        else patternIds[marker.url] = await headless.loadMarker(arController, marker.url);
+    }
+
+    // Returns the pose found in the current frame, or null.
+    const matrix = new Float64Array(12);
+    const findPose = (frame) => {
+        if (frame.synthetic && frame.synthetic in nftIndices) {
+            arController.detectNFTMarker();
+            const info = arController.getNFTMarker(nftIndices[frame.synthetic]);
+            return info.found ? Array.from(info.pose) : null;
+        }
+        let best = -1, bestCf = -1;
+        const markerNum = arController.getMarkerNum();
+        for (let i = 0; i < markerNum; i++) {
+            const info = arController.getMarker(i);
+            const cf = frame.matrix !== undefined ? (info.idMatrix === frame.matrix ? info.cfMatrix : -1) :
+                (info.idPatt === patternIds[frame.synthetic] ? info.cfPatt : -1);
+            if (cf > bestCf) {
+                best = i;
+                bestCf = cf;
+            }
+        }
+        if (best < 0) return null;
+        const info = arController.getMarker(best);
+        const dir = frame.matrix !== undefined ? info.dirMatrix : info.dirPatt;
+        if (info.dir !== dir) arController.setMarkerInfoDir(best, dir);
+        return Array.from(arController.getTransMatSquare(best, frame.markerWidth || 80, matrix));
+    };
+
+    const run = () => {
+        const result = { found: 0, translationError: [], rotationError: [], ms: 0 };
+        const now = () => Number(process.hrtime.bigint()) / 1e6;
+        for (let it = 0; it < args.iterations; it++) {
+            for (const { frame, image } of posed) {
+                arController.resetTracking();
+                const t0 = now();
+                arController.detectMarker(image);
+                const pose = findPose(frame);
+                result.ms += now() - t0;
+                if (it > 0 || !pose) continue;
+                result.found++;
+                result.translationError.push(translationError(pose, image.pose));
+                result.rotationError.push(rotationError(pose, image.pose));
+            }
+        }
+        return {
+            found: result.found / posed.length,
+            translationError: { mean: mean(result.translationError), max: Math.max.apply(null, result.translationError) },
+            rotationError: { mean: mean(result.rotationError), max: Math.max.apply(null, result.rotationError) },
+            msPerFrame: result.ms / (args.iterations * posed.length)
+        };
+    };
+
+    const settings = manifest.settings || {};
+    const knobs = manifest.sweep || KNOBS;
+    // The values of the build, set again before each knob value so that knobs don't carry over.
+    const defaults = {};
+    for (const name of Object.keys(knobs).concat(Object.keys(settings))) {
+        defaults[name] = arController['get' + name.slice(3)]();
+    }
+    const configure = (knob, value) => {
+        applySettings(artoolkit, arController, defaults);
+        applySettings(artoolkit, arController, settings);
+        // The threshold only matters in the manual threshold mode.
+        if (knob === 'setThreshold' && !settings.setThresholdMode) arController.setThresholdMode(artoolkit.AR_LABELING_THRESH_MODE_MANUAL);
+        if (knob) applySettings(artoolkit, arController, { [knob]: value });
+    };
+
+    configure(null);
+    const results = [Object.assign({ knob: 'baseline', value: null }, run())];
+    for (const knob in knobs) {
+        for (const value of knobs[knob]) {
+            configure(knob, value);
+            results.push(Object.assign({ knob: knob, value: value }, run()));
+        }
+    }
+    arController.dispose();
+
+    return {
+        runner: 'node',
+        build: path.basename(args.build, '.js'),
+        manifest: path.basename(args.manifest),
+        frames: posed.length,
+        iterations: args.iterations,
+        settings: settings,
+        results: results
+    };
+}
+
+function printReport(report) {
+    console.log(report.build + ': ' + report.frames + ' frames x ' + report.iterations + ' iterations');
+    console.log('knob                     value                                    found   t err  t max   r err  r max   ms/frame');
+    for (const r of report.results) {
+        console.log(r.knob.padEnd(24) + ' ' + String(r.value === null ? '' : r.value).padEnd(40) + ' ' +
+            (r.found * 100).toFixed(0).padStart(4) + '%' +
+            r.translationError.mean.toFixed(2).padStart(8) + r.translationError.max.toFixed(2).padStart(7) +
+            r.rotationError.mean.toFixed(2).padStart(8) + r.rotationError.max.toFixed(2).padStart(7) +
+            r.msPerFrame.toFixed(2).padStart(11));
+    }
+}
+
+if (require.main === module) {
+    const args = parseArgs(process.argv.slice(2));
+    sweep(args).then((report) => {
+        printReport(report);
+        if (args.json) fs.writeFileSync(args.json, JSON.stringify(report, null, 2) + '\n');
+        process.exit(0);
+    }).catch((e) => {
+        console.error(e);
+        process.exit(1);
+    });
+}
+
+module.exports = sweep;
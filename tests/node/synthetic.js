@@ -0,0 +1,401 @@
+/*
+ * Renders markers into RGBA frames, so that the node scripts have frames with known content without a
+ * camera or an image decoder:
+ *
+ *   renderMarker()  a pattern marker (.patt file) at the given image corners, i.e. the marker's
+ *                   top-left, top-right, bottom-right and bottom-left corners.
+ *   renderScene()   a pattern marker, a matrix code or the image of an NFT marker (.iset) at a 6-DoF pose,
+ *                   projected with the camera parameters (camera_para.dat) including lens distortion,
+ *                   with optional lighting changes, blur and noise. The frame carries the ground truth pose.
+ *
+ *   node tests/node/synthetic.js scene.json --out dir
+ *
+ * writes the frames of a manifest (see synthetic.json) as .ppm files to dir, with truth.json holding
+ * the ground truth pose of each.
+ */
+
+const fs = require('fs');
+const path = require('path');
+const iset = require('./iset');
+
+const PATT_SIZE = 16;
+const PATT_RATIO = 0.5;
+
+// Returns the orientation 0 pattern as [row][col] = [r, g, b]. .patt files store B, G and R planes.
+function readPattern(file) {
+    const values = fs.readFileSync(file, 'utf8').trim().split(/\s+/).map(Number);
+    const pattern = [];
+    for (let row = 0; row < PATT_SIZE; row++) {
+        pattern.push([]);
+        for (let col = 0; col < PATT_SIZE; col++) {
+            const i = row * PATT_SIZE + col;
+            const b = values[i];
+            const g = values[PATT_SIZE * PATT_SIZE + i];
+            const r = values[2 * PATT_SIZE * PATT_SIZE + i];
+            pattern[row].push([r, g, b]);
+        }
+    }
+    return pattern;
+}
+
+// Projective mapping of the unit square onto the quad (Heckbert), as a 3x3 row-major matrix.
+function squareToQuad(q) {
+    const [x0, y0] = q[0], [x1, y1] = q[1], [x2, y2] = q[2], [x3, y3] = q[3];
+    const sx = x0 - x1 + x2 - x3, sy = y0 - y1 + y2 - y3;
+    if (sx === 0 && sy === 0) {
+        return [x1 - x0, x2 - x1, x0, y1 - y0, y2 - y1, y0, 0, 0, 1];
+    }
+    const dx1 = x1 - x2, dx2 = x3 - x2, dy1 = y1 - y2, dy2 = y3 - y2;
+    const den = dx1 * dy2 - dx2 * dy1;
+    const g = (sx * dy2 - dx2 * sy) / den;
+    const h = (dx1 * sy - sx * dy1) / den;
+    return [x1 - x0 + g * x1, x3 - x0 + h * x3, x0,
+            y1 - y0 + g * y1, y3 - y0 + h * y3, y0,
+            g, h, 1];
+}
+
+function adjoint(m) {
+    return [m[4] * m[8] - m[5] * m[7], m[2] * m[7] - m[1] * m[8], m[1] * m[5] - m[2] * m[4],
+            m[5] * m[6] - m[3] * m[8], m[0] * m[8] - m[2] * m[6], m[2] * m[3] - m[0] * m[5],
+            m[3] * m[7] - m[4] * m[6], m[1] * m[6] - m[0] * m[7], m[0] * m[4] - m[1] * m[3]];
+}
+
+function sampleMarker(pattern, u, v) {
+    if (u < 0 || u >= 1 || v < 0 || v >= 1) return null;
+    const border = (1 - PATT_RATIO) / 2;
+    if (u < border || u >= 1 - border || v < border || v >= 1 - border) return [0, 0, 0];
+    const col = Math.floor((u - border) / PATT_RATIO * PATT_SIZE);
+    const row = Math.floor((v - border) / PATT_RATIO * PATT_SIZE);
+    return pattern[row][col];
+}
+
+/*
+ * Returns an ImageData-like { width, height, data } with the marker drawn on a uniform background.
+ * Each pixel is supersampled 2x2 so the marker edges are anti-aliased like a camera image.
+ */
+function renderMarker(pattern, width, height, corners, background) {
+    if (background === undefined) background = 255;
+    const inv = adjoint(squareToQuad(corners));
+    const data = new Uint8ClampedArray(width * height * 4);
+    const offsets = [0.25, 0.75];
+
+    for (let y = 0; y < height; y++) {
+        for (let x = 0; x < width; x++) {
+            let r = 0, g = 0, b = 0;
+            for (const oy of offsets) {
+                for (const ox of offsets) {
+                    const px = x + ox, py = y + oy;
+                    const w = inv[6] * px + inv[7] * py + inv[8];
+                    const c = sampleMarker(pattern, (inv[0] * px + inv[1] * py + inv[2]) / w,
+                                                    (inv[3] * px + inv[4] * py + inv[5]) / w);
+                    r += c ? c[0] : background;
+                    g += c ? c[1] : background;
+                    b += c ? c[2] : background;
+                }
+            }
+            const i = (y * width + x) * 4;
+            data[i + 0] = r / 4;
+            data[i + 1] = g / 4;
+            data[i + 2] = b / 4;
+            data[i + 3] = 255;
+        }
+    }
+    return { width: width, height: height, data: data };
+}
+
+/*
+ * Reads camera parameters (camera_para.dat): big-endian image size, 3x4 projection matrix and the
+ * version 4 distortion factors k1, k2, p1, p2, fx, fy, x0, y0 and s.
+ */
+function readCamera(file) {
+    const buf = fs.readFileSync(file);
+    if (buf.length !== 176) throw new Error(file + ': only version 4 camera parameters are supported');
+    const camera = { xsize: buf.readInt32BE(0), ysize: buf.readInt32BE(4), mat: [], dist: [] };
+    for (let i = 0; i < 12; i++) camera.mat.push(buf.readDoubleBE(8 + i * 8));
+    for (let i = 0; i < 9; i++) camera.dist.push(buf.readDoubleBE(104 + i * 8));
+    return camera;
+}
+
+// Same as arParamChangeSize.
+function changeCameraSize(camera, width, height) {
+    const sx = width / camera.xsize, sy = height / camera.ysize;
+    const mat = camera.mat.map((v, i) => (i < 4 ? v * sx : (i < 8 ? v * sy : v)));
+    const dist = camera.dist.map((v, i) => (i === 4 || i === 6 ? v * sx : (i === 5 || i === 7 ? v * sy : v)));
+    return { xsize: width, ysize: height, mat: mat, dist: dist };
+}
+
+// Observed (distorted) to ideal image coordinates, by fixed point iteration like arParamObserv2Ideal.
+function observ2Ideal(dist, ox, oy, out) {
+    const [k1, k2, p1, p2, fx, fy, x0, y0, s] = dist;
+    const dx = (ox - x0) / fx, dy = (oy - y0) / fy;
+    let x = dx, y = dy;
+    for (let i = 0; i < 5; i++) {
+        const l = x * x + y * y;
+        const radial = 1 + k1 * l + k2 * l * l;
+        x = (dx - (2 * p1 * x * y + p2 * (l + 2 * x * x))) / radial;
+        y = (dy - (p1 * (l + 2 * y * y) + 2 * p2 * x * y)) / radial;
+    }
+    out[0] = x * fx / s + x0;
+    out[1] = y * fy / s + y0;
+}
+
+function multiply3(a, b) {
+    const m = [];
+    for (let r = 0; r < 3; r++) {
+        for (let c = 0; c < 3; c++) {
+            m.push(a[r * 3] * b[c] + a[r * 3 + 1] * b[3 + c] + a[r * 3 + 2] * b[6 + c]);
+        }
+    }
+    return m;
+}
+
+/*
+ * Returns the 3x4 row-major marker to camera transformation, as getTransMatSquare() and getNFTMarker()
+ * report it, for pose = { rotation: [rx, ry, rz], translation: [x, y, z] }: the marker faces the camera
+ * upright, is rotated by rx, ry and rz degrees about the camera x, y and z axes, in that order, and its
+ * origin is moved to the translation, in the units of the marker width (usually mm).
+ */
+function poseMatrix(pose) {
+    const [rx, ry, rz] = (pose.rotation || [0, 0, 0]).map((a) => a * Math.PI / 180);
+    const t = pose.translation;
+    const Rx = [1, 0, 0, 0, Math.cos(rx), -Math.sin(rx), 0, Math.sin(rx), Math.cos(rx)];
+    const Ry = [Math.cos(ry), 0, Math.sin(ry), 0, 1, 0, -Math.sin(ry), 0, Math.cos(ry)];
+    const Rz = [Math.cos(rz), -Math.sin(rz), 0, Math.sin(rz), Math.cos(rz), 0, 0, 0, 1];
+    const facing = [1, 0, 0, 0, -1, 0, 0, 0, -1]; // marker y up and z towards the camera
+    const R = multiply3(Rz, multiply3(Ry, multiply3(Rx, facing)));
+    return [R[0], R[1], R[2], t[0], R[3], R[4], R[5], t[1], R[6], R[7], R[8], t[2]];
+}
+
+/*
+ * Marker surfaces in marker coordinates (origin at the centre, y up, in the units of the marker width for
+ * square markers and mm for NFT markers). sample(x, y) returns [r, g, b] or null outside the marker.
+ */
+function patternSurface(pattern, markerWidth) {
+    return { sample: (x, y) => sampleMarker(pattern, x / markerWidth + 0.5, 0.5 - y / markerWidth) };
+}
+
+/*
+ * The cells of matrix code id in a size x size code without error correction (AR_MATRIX_CODE_3x3,
+ * AR_MATRIX_CODE_4x4, ...). The top-left and bottom-left corners are black and the bottom-right one white,
+ * which gives the orientation; the other cells hold the id, most significant bit first, row by row.
+ */
+function matrixCodeCells(id, size) {
+    const corners = [0, (size - 1) * size, size * size - 1];
+    const dataBits = size * size - corners.length;
+    if (id < 0 || id >= Math.pow(2, dataBits)) throw new Error('Matrix code id ' + id + ' is out of range');
+    const cells = [];
+    let bit = dataBits - 1;
+    for (let row = 0; row < size; row++) {
+        cells.push([]);
+        for (let col = 0; col < size; col++) {
+            const i = row * size + col;
+            if (i === corners[2]) cells[row].push(0);
+            else if (i === corners[0] || i === corners[1]) cells[row].push(1);
+            else cells[row].push(Math.floor(id / Math.pow(2, bit--)) % 2);
+        }
+    }
+    return cells;
+}
+
+/*
+ * A matrix code: cells[row][col] is 1 for black, top row first, in the pattern area of the marker.
+ * See matrixCodeCells().
+ */
+function matrixSurface(cells, markerWidth) {
+    const n = cells.length;
+    const border = (1 - PATT_RATIO) / 2;
+    return {
+        sample: (x, y) => {
+            const u = x / markerWidth + 0.5, v = 0.5 - y / markerWidth;
+            if (u < 0 || u >= 1 || v < 0 || v >= 1) return null;
+            if (u < border || u >= 1 - border || v < border || v >= 1 - border) return [0, 0, 0];
+            const c = cells[Math.floor((v - border) / PATT_RATIO * n)][Math.floor((u - border) / PATT_RATIO * n)] ? 0 : 255;
+            return [c, c, c];
+        }
+    };
+}
+
+// The image of an NFT marker, { width, height, dpi, data } as read by iset.readImageSet, with its origin at the bottom-left corner.
+function imageSurface(image) {
+    const scale = image.dpi / 25.4;
+    return {
+        sample: (x, y) => {
+            const px = x * scale - 0.5, py = image.height - y * scale - 0.5;
+            if (px < 0 || py < 0 || px >= image.width - 1 || py >= image.height - 1) return null;
+            const ix = Math.floor(px), iy = Math.floor(py), fx = px - ix, fy = py - iy;
+            const i = iy * image.width + ix, d = image.data;
+            const top = d[i] + (d[i + 1] - d[i]) * fx;
+            const bottom = d[i + image.width] + (d[i + image.width + 1] - d[i + image.width]) * fx;
+            const c = top + (bottom - top) * fy;
+            return [c, c, c];
+        }
+    };
+}
+
+// Deterministic noise for reproducible frames (mulberry32 and Box-Muller).
+function gaussianRandom(seed) {
+    let a = seed >>> 0;
+    const uniform = () => {
+        a = (a + 0x6d2b79f5) >>> 0;
+        let t = a;
+        t = Math.imul(t ^ (t >>> 15), t | 1);
+        t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+        return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+    return () => Math.sqrt(-2 * Math.log(1 - uniform())) * Math.cos(2 * Math.PI * uniform());
+}
+
+function gaussianBlur(data, width, height, sigma) {
+    const radius = Math.ceil(sigma * 3);
+    const kernel = [];
+    let sum = 0;
+    for (let i = -radius; i <= radius; i++) {
+        kernel.push(Math.exp(-i * i / (2 * sigma * sigma)));
+        sum += kernel[kernel.length - 1];
+    }
+    const k = kernel.map((v) => v / sum);
+    const tmp = new Float32Array(data.length);
+    const pass = (src, dst, dx, dy) => {
+        for (let y = 0; y < height; y++) {
+            for (let x = 0; x < width; x++) {
+                for (let c = 0; c < 3; c++) {
+                    let v = 0;
+                    for (let i = -radius; i <= radius; i++) {
+                        const sx = Math.min(width - 1, Math.max(0, x + i * dx));
+                        const sy = Math.min(height - 1, Math.max(0, y + i * dy));
+                        v += k[i + radius] * src[(sy * width + sx) * 4 + c];
+                    }
+                    dst[(y * width + x) * 4 + c] = v;
+                }
+            }
+        }
+    };
+    pass(data, tmp, 1, 0);
+    pass(tmp, data, 0, 1);
+}
+
+/*
+ * Renders a marker surface at a pose into an ImageData-like { width, height, data, pose }, where pose is
+ * the ground truth 3x4 marker to camera transformation. options:
+ *
+ *   width, height  frame size
+ *   camera         camera parameters from readCamera(), scaled to the frame width like the detection does
+ *   pose           see poseMatrix()
+ *   background     gray level around the marker, default 255
+ *   lighting       { gain: 1, offset: 0, gradient: [0, 0] }: c * gain * (1 + gradient . (position - centre) / size) + offset
+ *   blur           standard deviation in pixels of a gaussian blur, e.g. defocus
+ *   noise          standard deviation of additive gaussian noise in gray levels
+ *   seed           seed of the noise, for reproducible frames
+ */
+function renderScene(surface, options) {
+    const width = options.width, height = options.height;
+    const camera = changeCameraSize(options.camera, width, height);
+    const pose = poseMatrix(options.pose);
+    const background = options.background === undefined ? 255 : options.background;
+    const lighting = Object.assign({ gain: 1, offset: 0, gradient: [0, 0] }, options.lighting);
+
+    // Homography of the marker plane (z = 0) to ideal image coordinates.
+    const P = camera.mat;
+    const RT = [pose[0], pose[1], pose[3], pose[4], pose[5], pose[7], pose[8], pose[9], pose[11]];
+    const H = multiply3([P[0], P[1], P[2], P[4], P[5], P[6], P[8], P[9], P[10]], RT);
+    for (let r = 0; r < 3; r++) H[r * 3 + 2] += P[r * 4 + 3];
+    // The adjugate is the inverse up to the determinant, whose sign tells the side of the camera.
+    const inv = adjoint(H);
+    const det = H[0] * inv[0] + H[1] * inv[3] + H[2] * inv[6];
+    if (det < 0) inv.forEach((v, i) => { inv[i] = -v; });
+
+    const data = new Uint8ClampedArray(width * height * 4);
+    const buf = new Float32Array(width * height * 4);
+    const ideal = [0, 0];
+    const offsets = [0.25, 0.75];
+    for (let y = 0; y < height; y++) {
+        for (let x = 0; x < width; x++) {
+            let r = 0, g = 0, b = 0;
+            for (const oy of offsets) {
+                for (const ox of offsets) {
+                    observ2Ideal(camera.dist, x + ox, y + oy, ideal);
+                    const w = inv[6] * ideal[0] + inv[7] * ideal[1] + inv[8];
+                    const c = w > 0 ? surface.sample((inv[0] * ideal[0] + inv[1] * ideal[1] + inv[2]) / w,
+                                                     (inv[3] * ideal[0] + inv[4] * ideal[1] + inv[5]) / w) : null;
+                    r += c ? c[0] : background;
+                    g += c ? c[1] : background;
+                    b += c ? c[2] : background;
+                }
+            }
+            const light = lighting.gain * (1 + lighting.gradient[0] * (x / width - 0.5) + lighting.gradient[1] * (y / height - 0.5));
+            const i = (y * width + x) * 4;
+            buf[i + 0] = r / 4 * light + lighting.offset;
+            buf[i + 1] = g / 4 * light + lighting.offset;
+            buf[i + 2] = b / 4 * light + lighting.offset;
+        }
+    }
+
+    if (options.blur) gaussianBlur(buf, width, height, options.blur);
+    const random = options.noise ? gaussianRandom(options.seed || 1) : null;
+    for (let i = 0; i < buf.length; i += 4) {
+        const n = random ? random() * options.noise : 0;
+        data[i + 0] = buf[i + 0] + n;
+        data[i + 1] = buf[i + 1] + n;
+        data[i + 2] = buf[i + 2] + n;
+        data[i + 3] = 255;
+    }
+    return { width: width, height: height, data: data, pose: pose };
+}
+
+/*
+ * The surface of a manifest frame with a pose: { synthetic: <.patt or .iset file>, markerWidth } or
+ * { matrix: id, matrixSize, markerWidth }, the marker width defaulting to 80. cache keeps the files read.
+ */
+function frameSurface(frame, cache) {
+    const markerWidth = frame.markerWidth || 80;
+    if (frame.matrix !== undefined) {
+        return matrixSurface(matrixCodeCells(frame.matrix, frame.matrixSize || 3), markerWidth);
+    }
+    if (!cache[frame.synthetic]) {
+        cache[frame.synthetic] = path.extname(frame.synthetic) === '.iset' ?
+            iset.readImageSet(frame.synthetic) : readPattern(frame.synthetic);
+    }
+    const source = cache[frame.synthetic];
+    return source.dpi ? imageSurface(source) : patternSurface(source, markerWidth);
+}
+
+function writePPM(file, image) {
+    const header = Buffer.from('P6\n' + image.width + ' ' + image.height + '\n255\n');
+    const pixels = Buffer.alloc(image.width * image.height * 3);
+    for (let i = 0, j = 0; j < pixels.length; i += 4, j += 3) {
+        pixels[j] = image.data[i];
+        pixels[j + 1] = image.data[i + 1];
+        pixels[j + 2] = image.data[i + 2];
+    }
+    fs.writeFileSync(file, Buffer.concat([header, pixels]));
+}
+
+module.exports = {
+    readPattern: readPattern,
+    renderMarker: renderMarker,
+    readCamera: readCamera,
+    poseMatrix: poseMatrix,
+    patternSurface: patternSurface,
+    matrixCodeCells: matrixCodeCells,
+    matrixSurface: matrixSurface,
+    imageSurface: imageSurface,
+    renderScene: renderScene,
+    frameSurface: frameSurface,
+    writePPM: writePPM
+};
+
+if (require.main === module) {
+    const headless = require('./headless');
+    const args = process.argv.slice(2);
+    const out = args.indexOf('--out') >= 0 ? path.resolve(args.splice(args.indexOf('--out'), 2)[1]) : process.cwd();
+    const manifest = headless.readManifest(args[0] || path.resolve(__dirname, 'synthetic.json'));
+    const truth = [];
+    fs.mkdirSync(out, { recursive: true });
+    headless.readFrames(manifest).forEach((image, i) => {
+        const file = 'frame_' + String(i).padStart(4, '0') + '.ppm';
+        writePPM(path.join(out, file), image);
+        truth.push({ file: file, pose: image.pose || null });
+    });
+    fs.writeFileSync(path.join(out, 'truth.json'), '[\n' + truth.map((t) => '    ' + JSON.stringify(t)).join(',\n') + '\n]\n');
+    console.log('Wrote ' + truth.length + ' frames to ' + out);
+}
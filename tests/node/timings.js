@@ -0,0 +1,112 @@
+/*
+ * Times the labeling, KPM and AR2 workloads of one build over the frames of a manifest.
+ * Used by bench-builds.js, which runs it once per build in a child process.
+ *
+ *   node tests/node/timings.js <build.js> <manifest.json> [iterations]
+ *
+ * labeling: detectMarker(), i.e. luma conversion, thresholding, labeling and pattern matching.
+ * adaptive: detectMarker() in the adaptive threshold mode.
+ * kpm:      detectNFTMarker() while no NFT marker is tracked (feature extraction and matching).
+ * ar2:      getNFTMarker() while an NFT marker is tracked (template matching and pose).
+ * Synthetic frames only contain pattern markers, so ar2 is only timed on recorded NFT frames.
+ */
+
+const path = require('path');
+const headless = require('./headless');
+
+function summarize(samples) {
+    if (!samples.length) return null;
+    const sorted = samples.slice().sort((a, b) => a - b);
+    const sum = sorted.reduce((a, b) => a + b, 0);
+    return {
+        frames: sorted.length,
+        mean: sum / sorted.length,
+        median: sorted[Math.floor(sorted.length / 2)],
+        min: sorted[0],
+        max: sorted[sorted.length - 1]
+    };
+}
+
+async function collectTimings(buildPath, manifestPath, iterations) {
+    const manifest = headless.readManifest(manifestPath);
+    const frames = headless.readFrames(manifest);
+    const { artoolkit, ARController, ARCameraParam } = await headless.load(buildPath);
+    artoolkit.setLogLevel(artoolkit.AR_LOG_LEVEL_ERROR);
+
+    const cameraParam = await headless.loadCamera(ARCameraParam, manifest.camera);
+    const arController = new ARController(manifest.width, manifest.height, cameraParam);
+    let nftMarkerNum = 0;
+    for (const marker of manifest.markers) {
+        if (marker.type === 'nft') {
+            await headless.loadNFTMarker(arController, marker.url);
+            nftMarkerNum++;
+        } else {
+            await headless.loadMarker(arController, marker.url);
+        }
+    }
+
+    const labeling = [], adaptive = [], kpm = [], ar2 = [];
+    // The first pass warms up the JIT and is not recorded.
+    const timeDetection = (samples) => {
+        for (let it = 0; it <= iterations; it++) {
+            for (const image of frames) {
+                let t = process.hrtime.bigint();
+                arController.detectMarker(image);
+                if (it > 0) samples.push(Number(process.hrtime.bigint() - t) / 1e6);
+            }
+        }
+    };
+    timeDetection(labeling);
+    const thresholdMode = arController.getThresholdMode();
+    arController.setThresholdMode(artoolkit.AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE);
+    timeDetection(adaptive);
+    arController.setThresholdMode(thresholdMode);
+
+    if (nftMarkerNum) {
+        let tracking = false;
+        for (let it = 0; it <= iterations; it++) {
+            for (const image of frames) {
+                arController.detectMarker(image);
+                let t;
+                if (!tracking) {
+                    t = process.hrtime.bigint();
+                    arController.detectNFTMarker();
+                    if (it > 0) kpm.push(Number(process.hrtime.bigint() - t) / 1e6);
+                }
+                const wasTracking = tracking;
+                tracking = false;
+                t = process.hrtime.bigint();
+                for (let i = 0; i < nftMarkerNum; i++) {
+                    if (arController.getNFTMarker(i).found) tracking = true;
+                }
+                if (it > 0 && wasTracking) ar2.push(Number(process.hrtime.bigint() - t) / 1e6);
+            }
+        }
+    }
+
+    arController.dispose();
+    return {
+        build: path.basename(buildPath, '.js'),
+        iterations: iterations,
+        labeling: summarize(labeling),
+        adaptive: summarize(adaptive),
+        kpm: summarize(kpm),
+        ar2: summarize(ar2)
+    };
+}
+
+module.exports = collectTimings;
+
+if (require.main === module) {
+    collectTimings(process.argv[2], process.argv[3], parseInt(process.argv[4] || '5')).then((result) => {
+        if (process.send) {
+            process.send(result, () => process.exit(0));
+        } else {
+            console.log(JSON.stringify(result, null, 2));
+            process.exit(0);
+        }
+    }).catch((e) => {
+        console.error(e);
+        process.exit(1);
+    });
+}
@@ -149,6 +149,707 @@ QUnit.test("Create ARController track image", assert => {
     }
     const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
 });
+QUnit.test("Resize ARController keeps loaded markers", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(320, 240, cameraPara);
+        const found = [];
+        arController.addEventListener('getMarker', (trackableInfo) => {
+            found.push(trackableInfo.data.marker.idPatt);
+        });
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.setPatternDetectionMode(artoolkit.AR_TEMPLATE_MATCHING_MONO_AND_MATRIX);
+            arController.setThresholdMode(artoolkit.AR_LABELING_THRESH_MODE_AUTO_OTSU);
+
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                assert.ok(markerId >= 0, "Marker loaded");
+                arController.trackPatternMarkerId(markerId);
+
+                assert.deepEqual(arController.resize(v1.width, v1.height), 0, "Resized");
+                assert.deepEqual(arController.videoWidth, v1.width, "videoWidth updated");
+                assert.deepEqual(arController.videoHeight, v1.height, "videoHeight updated");
+                assert.deepEqual(arController.canvas.width, v1.width, "canvas.width updated");
+                assert.deepEqual(arController.canvas.height, v1.height, "canvas.height updated");
+                assert.deepEqual(arController.framesize, v1.width * v1.height * 4, "Frame buffer reallocated");
+                assert.deepEqual(arController.videoLuma.length, v1.width * v1.height, "Luma buffer reallocated");
+                assert.deepEqual(arController.getPatternDetectionMode(), artoolkit.AR_TEMPLATE_MATCHING_MONO_AND_MATRIX, "Pattern detection mode kept");
+                assert.deepEqual(arController.getThresholdMode(), artoolkit.AR_LABELING_THRESH_MODE_AUTO_OTSU, "Threshold mode kept");
+
+                arController.process(v1);
+                assert.ok(found.indexOf(markerId) >= 0, "Marker found after resize");
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Frame statistics", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                arController.process(v1);
+                const stats = arController.getFrameStats();
+                assert.deepEqual(stats.frameNum, 1, "One frame processed");
+                assert.ok(stats.lumaMs >= 0 && stats.detectMs >= 0, "Luma and detection timed");
+                assert.ok(stats.candidateQuadNum >= stats.markerNum, "Markers are decoded from the candidate quads");
+                assert.deepEqual(stats.squarePoseNum, stats.markerNum, "One pose per marker");
+
+                arController.process(v1);
+                assert.deepEqual(arController.getFrameStats().frameNum, 2, "Frame count updated");
+                assert.deepEqual(stats.frameNum, 1, "Returned stats are a copy");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("ROI detection", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                assert.deepEqual(arController.getROIFullScanInterval(), 0, "Full scans by default");
+                arController.setROIFullScanInterval(3);
+                assert.deepEqual(arController.getROIFullScanInterval(), 3, "Interval set");
+
+                const roiNums = [];
+                const found = [];
+                for (let i = 0; i < 4; i++) {
+                    arController.process(v1);
+                    roiNums.push(arController.getFrameStats().roiNum);
+                    let ids = [];
+                    for (let m = 0; m < arController.getMarkerNum(); m++) ids.push(arController.getMarker(m).idPatt);
+                    found.push(ids.includes(markerId));
+                }
+                assert.deepEqual(roiNums.map(n => n > 0), [false, true, true, false], "Full scan every 3 frames");
+                assert.deepEqual(found, [true, true, true, true], "Marker found in the regions");
+
+                arController.setROIFullScanInterval(0);
+                arController.process(v1);
+                assert.deepEqual(arController.getFrameStats().roiNum, 0, "Disabled");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Coarse detection", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                assert.deepEqual(arController.getCoarseDetectionFactor(), 1, "Full resolution by default");
+                assert.deepEqual(arController.setCoarseDetectionFactor(3), -1, "Factor 3 unsupported");
+                arController.setCoarseDetectionFactor(2);
+                assert.deepEqual(arController.getCoarseDetectionFactor(), 2, "Factor set");
+
+                arController.process(v1);
+                const stats = arController.getFrameStats();
+                assert.deepEqual(stats.coarseFactor, 2, "Labeled downscaled");
+                assert.ok(stats.roiNum > 0, "Regions refined at full resolution");
+                let ids = [];
+                for (let m = 0; m < arController.getMarkerNum(); m++) ids.push(arController.getMarker(m).idPatt);
+                assert.ok(ids.includes(markerId), "Marker found");
+
+                arController.setCoarseDetectionFactor(1);
+                arController.process(v1);
+                assert.deepEqual(arController.getFrameStats().coarseFactor, 1, "Disabled");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Coarse detection with the bracketing threshold", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                arController.setThresholdMode(artoolkit.AR_LABELING_THRESH_MODE_AUTO_BRACKETING);
+                arController.setCoarseDetectionFactor(2);
+                arController.process(v1);
+                assert.deepEqual(arController.getFrameStats().coarseFactor, 1, "Bracketing labels at full resolution");
+                assert.deepEqual(arController.getThresholdMode(), artoolkit.AR_LABELING_THRESH_MODE_AUTO_BRACKETING, "Still bracketing");
+                let ids = [];
+                for (let m = 0; m < arController.getMarkerNum(); m++) ids.push(arController.getMarker(m).idPatt);
+                assert.ok(ids.includes(markerId), "Marker found");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Labeling threads", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                const detect = () => {
+                    arController.process(v1);
+                    const markers = [];
+                    for (let m = 0; m < arController.getMarkerNum(); m++) {
+                        const marker = arController.getMarker(m);
+                        markers.push([marker.idPatt, marker.area, marker.vertex.map(v => v.slice())]);
+                    }
+                    return { labelNum: arController.getFrameStats().labelNum, markers: markers };
+                };
+                assert.deepEqual(arController.getLabelingThreadNum(), 1, "Single thread by default");
+                assert.deepEqual(arController.setLabelingThreadNum(0), -1, "0 threads unsupported");
+                const serial = detect();
+
+                arController.setLabelingThreadNum(4);
+                assert.deepEqual(arController.getLabelingThreadNum(), 4, "Threads set");
+                const strips = detect();
+                assert.deepEqual(strips, serial, "Same labels and markers as the single threaded labeling");
+                assert.ok(strips.markers.some(marker => marker[0] === markerId), "Marker found");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Adaptive threshold", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                const detect = () => {
+                    const frames = [];
+                    for (let i = 0; i < 3; i++) {
+                        arController.process(v1);
+                        const markers = [];
+                        for (let m = 0; m < arController.getMarkerNum(); m++) {
+                            const marker = arController.getMarker(m);
+                            markers.push([marker.id, marker.idPatt, marker.vertex.map(v => v.slice())]);
+                        }
+                        frames.push(markers);
+                    }
+                    return frames;
+                };
+                arController.setThresholdMode(artoolkit.AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE);
+                assert.deepEqual(arController.getFastAdaptiveThresholdEnabled(), 0, "arDetectMarker by default");
+                arController.setTraceEnabled(true);
+                const serial = detect();
+                let names = arController.getTrace().traceEvents.map(event => event.name);
+                assert.notOk(names.includes("arThreshAdaptiveBinarize"), "Not binarized with the running box filter by default");
+                arController.clearTrace();
+
+                assert.deepEqual(arController.setFastAdaptiveThresholdEnabled(true), 0, "Fast adaptive threshold enabled");
+                assert.deepEqual(arController.getFastAdaptiveThresholdEnabled(), 1, "Fast adaptive threshold set");
+                const fast = detect();
+                names = arController.getTrace().traceEvents.map(event => event.name);
+                assert.ok(names.includes("arThreshAdaptiveBinarize"), "Binarized with the running box filter");
+                assert.deepEqual(fast, serial, "Same marker ids and vertices as arDetectMarker in every frame");
+                assert.ok(fast.every(markers => markers.some(marker => marker[1] === markerId)), "Marker found");
+                arController.setTraceEnabled(false);
+                arController.clearTrace();
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Threshold estimation", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                arController.setThresholdMode(artoolkit.AR_LABELING_THRESH_MODE_AUTO_MEDIAN);
+                arController.process(v1);
+                const fullFrame = arController.getFrameStats().threshold;
+
+                assert.deepEqual(arController.setThresholdEstimation({ sampleStep: 4, smoothing: 1 }), -1, "Smoothing out of range");
+                assert.deepEqual(arController.setThresholdEstimation({ sampleStep: 4, interval: 10, maxBrightnessShift: 8, smoothing: 0.5 }), 0, "Estimation set");
+                const thresholds = [];
+                for (let i = 0; i < 3; i++) {
+                    arController.process(v1);
+                    thresholds.push(arController.getFrameStats().threshold);
+                }
+                assert.ok(Math.abs(thresholds[0] - fullFrame) <= 8, "Close to the full frame median");
+                assert.deepEqual(thresholds, [thresholds[0], thresholds[0], thresholds[0]], "Kept between updates");
+                let ids = [];
+                for (let m = 0; m < arController.getMarkerNum(); m++) ids.push(arController.getMarker(m).idPatt);
+                assert.ok(ids.includes(markerId), "Marker found");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Pattern index", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            const markerIds = [];
+            const loadNext = () => {
+                if (markerIds.length < 3) {
+                    arController.loadMarker('./patt.hiro', (markerId) => {
+                        markerIds.push(markerId);
+                        loadNext();
+                    });
+                    return;
+                }
+                const markers = () => {
+                    const found = [];
+                    for (let m = 0; m < arController.getMarkerNum(); m++) {
+                        const marker = arController.getMarker(m);
+                        found.push({ idPatt: marker.idPatt, cfPatt: marker.cfPatt, vertex: marker.vertex.map(v => v.slice()) });
+                    }
+                    return found;
+                };
+
+                assert.deepEqual(arController.getPatternIndexEnabled(), 0, "Disabled by default");
+                arController.process(v1);
+                assert.deepEqual(arController.getFrameStats().pattShortlistNum, -1, "No shortlist without the index");
+                const all = markers();
+
+                arController.setPatternIndexEnabled(true);
+                assert.deepEqual(arController.getPatternIndexEnabled(), 1, "Enabled");
+                arController.process(v1);
+                const stats = arController.getFrameStats();
+                assert.ok(stats.pattShortlistNum >= 0 && stats.pattShortlistNum <= 3 * stats.candidateQuadNum, "Patterns shortlisted");
+                assert.deepEqual(markers(), all, "Same markers as matching all the patterns");
+                assert.ok(all.some(marker => marker.idPatt === markerIds[0]), "First of the identical patterns found");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            };
+            loadNext();
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Corner tracking", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                const marker = () => {
+                    for (let m = 0; m < arController.getMarkerNum(); m++) {
+                        const info = arController.getMarker(m);
+                        if (info.idPatt === markerId) return { dir: info.dir, vertex: info.vertex.map(v => v.slice()) };
+                    }
+                    return null;
+                };
+
+                assert.deepEqual(arController.getCornerTrackingInterval(), 0, "Detection every frame by default");
+                assert.deepEqual(arController.setCornerTrackingInterval(-1), -1, "Negative interval unsupported");
+                assert.deepEqual(arController.setCornerTrackingInterval(3), 0, "Interval set");
+                arController.process(v1);
+                assert.deepEqual(arController.getFrameStats().trackedMarkerNum, 0, "First frame detected");
+                const detected = marker();
+                assert.ok(detected, "Marker found");
+
+                const tracked = [];
+                for (let i = 0; i < 3; i++) {
+                    arController.process(v1);
+                    tracked.push(arController.getFrameStats().trackedMarkerNum);
+                }
+                assert.deepEqual(tracked, [1, 1, 0], "Tracked, then detected again");
+                arController.process(v1);
+                const stats = arController.getFrameStats();
+                assert.deepEqual([stats.trackedMarkerNum, stats.labelNum], [1, 0], "No labeling while tracking");
+                const corners = marker();
+                assert.deepEqual(corners.dir, detected.dir, "Direction kept");
+                assert.ok(corners.vertex.every((v, i) => Math.abs(v[0] - detected.vertex[i][0]) < 0.5 && Math.abs(v[1] - detected.vertex[i][1]) < 0.5), "Corners of a still frame kept");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Batched square poses", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                arController.detectMarker(v1);
+                assert.deepEqual(arController.getTransMatSquareBatch(), 0, "No pose without a registered width");
+
+                arController.trackPatternMarkerId(markerId, 80);
+                arController.process(v1);
+                let index = -1;
+                for (let m = 0; m < arController.getMarkerNum(); m++) {
+                    if (arController.getMarker(m).idPatt === markerId) index = m;
+                }
+                assert.ok(index >= 0, "Marker found");
+                assert.deepEqual(arController.squarePoseTypes[index], artoolkit.PATTERN_MARKER, "Pose estimated in the batch");
+                assert.deepEqual(Array.from(arController.patternMarkers[markerId].matrix), Array.from(arController.squarePoses.subarray(index * 12, index * 12 + 12)), "process() takes the batched pose");
+
+                // Same frame: poses from scratch, as getTransMatSquare computes them.
+                assert.deepEqual(arController.getTransMatSquareBatch(), 1, "One pose");
+                const single = arController.getTransMatSquare(index, 80, new Float64Array(12));
+                assert.deepEqual(Array.from(arController.squarePoses.subarray(index * 12, index * 12 + 12)), Array.from(single), "Same pose as getTransMatSquare");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Pose filter and GL matrices", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                assert.deepEqual(arController.getPoseFilterCutoff(), 0, "Unfiltered by default");
+                assert.deepEqual(arController.setPoseFilter(5, 0), -1, "Sample rate rejected");
+                assert.deepEqual(arController.setPoseFilter(5), 0, "Filter set");
+                assert.deepEqual(arController.getPoseFilterCutoff(), 5, "Cutoff read back");
+
+                arController.trackPatternMarkerId(markerId, 80);
+                arController.process(v1);
+                arController.process(v1);
+                let index = -1;
+                for (let m = 0; m < arController.getMarkerNum(); m++) {
+                    if (arController.getMarker(m).idPatt === markerId) index = m;
+                }
+                assert.ok(index >= 0, "Marker found");
+                const expected = arController.arglCameraViewRHf(arController.transMatToGLMat(arController.squarePoses.subarray(index * 12, index * 12 + 12)));
+                const gl = arController.squarePosesGL.subarray(index * 16, index * 16 + 16);
+                assert.ok(expected.every((v, k) => Math.abs(v - gl[k]) <= 1e-4 * Math.max(1, Math.abs(v))), "GL matrix of the pose");
+
+                assert.deepEqual(arController.setPoseFilter(0), 0, "Filter off");
+                assert.deepEqual(arController.getPoseFilterCutoff(), 0, "Unfiltered");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Batched multimarker poses", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMultiMarker('../examples/Data/multi-barcode-4x3.dat', (multiMarkerId, markerNum) => {
+                // The barcodes aren't decoded in the default template matching mode: none of the sub-markers is in view.
+                arController.detectMarker(v1);
+                assert.deepEqual(arController.getTransMatMultiSquareBatch(true), 0, "No multimarker in view");
+                assert.deepEqual(arController.multiMarkerVisibleNum.length, 1, "One entry per multimarker");
+                assert.deepEqual(arController.multiMarkerVisibleNum[multiMarkerId], 0, "No visible sub-marker");
+                assert.deepEqual(arController.multiMarkerErrors[multiMarkerId], -1, "No error");
+                assert.deepEqual(arController.getFrameStats().multiPoseNum, 0, "Pose not estimated");
+                for (let j = 0; j < markerNum; j++) {
+                    assert.deepEqual(arController.getMultiEachMarker(multiMarkerId, j).visible, -1, "Sub-marker " + j + " not visible");
+                }
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            }, () => {
+                assert.ok(false, "multimarker loaded");
+                done();
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Trace spans", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                arController.process(v1);
+                assert.deepEqual(arController.getTrace().traceEvents.filter(e => e.ph !== 'M').length, 0, "Nothing recorded by default");
+
+                arController.setTraceEnabled(true);
+                arController.process(v1);
+                arController.setTraceEnabled(false);
+                const events = arController.getTrace().traceEvents;
+                const detect = events.filter(e => e.name === 'arDetectMarker');
+                assert.deepEqual(detect.map(e => e.ph), ['B', 'E'], "One detection span");
+                assert.ok(detect[1].ts >= detect[0].ts, "Span ends after it begins");
+
+                arController.clearTrace();
+                assert.deepEqual(arController.getTrace().traceEvents.filter(e => e.ph !== 'M').length, 0, "Cleared");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("NFT tracking info and search feature number", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadNFTMarker('../examples/DataNFT/pinball', (markerId) => {
+                arController.process(v1);
+                const info = arController.getNFTTrackingInfo();
+                assert.ok(info.markerIndex >= -1, "Tracking info reported");
+                assert.deepEqual(info.icpErr.length, 5, "One error per cascade level");
+                assert.deepEqual(info.searchFeatureNum, 16, "Default search feature number");
+
+                arController.setNFTSearchFeatureNum(8);
+                assert.deepEqual(arController.getNFTSearchFeatureNum(), 8, "Search feature number set");
+                assert.deepEqual(arController.getNFTTrackingInfo().searchFeatureNum, 8, "Reported in the tracking info");
+
+                setTimeout(() => {
+                    arController.dispose();
+                    done();
+                }
+                ,this.cleanUpTimeout);
+            }, (error) => {
+                assert.notOk(error);
+                done();
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Capture and replay frames", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(v1, cameraPara);
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            arController.loadMarker('./patt.hiro', (markerId) => {
+                arController.startCapture({ rgba: true });
+                arController.process(v1);
+                arController.process(v1);
+                const log = arController.stopCapture();
+
+                const capture = artoolkit.readCapture(log);
+                assert.deepEqual(capture.width, arController.width, "Frame size recorded");
+                assert.deepEqual(capture.frames.length, 2, "Two frames recorded");
+                assert.deepEqual(capture.markers.length, 1, "Marker recorded");
+                assert.deepEqual(capture.frames[0].luma.length, capture.width * capture.height, "Luma recorded");
+
+                ARController.fromCapture(capture, (replayController, markerIds) => {
+                    assert.deepEqual(markerIds, [markerId], "Marker loaded from the capture");
+                    capture.frames.forEach((frame, i) => {
+                        assert.deepEqual(replayController.replayFrame(frame), [], "Frame " + i + " replayed with the recorded results");
+                    });
+
+                    setTimeout(() => {
+                        replayController.dispose();
+                        arController.dispose();
+                        done();
+                    }
+                    ,this.cleanUpTimeout);
+                });
+            });
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
+QUnit.test("Resize ARController within its memory plan", assert => {
+    const done = assert.async();
+    assert.timeout(this.timeout);
+    const success = () => {
+        const arController = new ARController(320, 240, cameraPara, { maxWidth: 640, maxHeight: 480, maxPatterns: 4 });
+
+        arController.onload = (err) => {
+            assert.notOk(err, "no error");
+            const framepointer = arController.framepointer;
+            const videoLumaPointer = arController.videoLumaPointer;
+
+            assert.deepEqual(arController.resize(640, 480), 0, "Resized");
+            assert.deepEqual(arController.framepointer, framepointer, "Frame buffer kept");
+            assert.deepEqual(arController.videoLumaPointer, videoLumaPointer, "Luma buffer kept");
+            assert.deepEqual(arController.framesize, 640 * 480 * 4, "Frame size updated");
+
+            setTimeout(() => {
+                arController.dispose();
+                done();
+            }
+            ,this.cleanUpTimeout);
+        };
+    }
+    const error = () => {
+        assert.ok(false);
+        done();
+    }
+    const cameraPara = new ARCameraParam(this.cParaUrl, success, error);
+});
 QUnit.test("Create ARController default, CameraPara as string", assert => {
     const videoWidth = 640, videoHeight = 480;
     const cameraParaUrl = './camera_para.dat';
@@ -15,6 +15,9 @@ var
 const platform = os.platform();
 
 var NO_LIBAR = false;
+var NO_MEMORY_GROWTH = false;
+var SIMD = false;
+var PTHREADS = false;
 
 var arguments = process.argv;
 
@@ -23,6 +26,18 @@ for (var j = 2; j < arguments.length; j++) {
 		NO_LIBAR = true;
 		console.log('Building jsartoolkit5 with --no-libar option, libar will be preserved.');
 	};
+	if (arguments[j] == '--no-memory-growth') {
+		NO_MEMORY_GROWTH = true;
+		console.log('Building jsartoolkit5 with --no-memory-growth option, the heap is fixed at TOTAL_MEMORY.');
+	};
+	if (arguments[j] == '--simd') {
+		SIMD = true;
+		console.log('Building jsartoolkit5 with --simd option, artoolkit_wasm_simd.js will be built.');
+	};
+	if (arguments[j] == '--pthreads') {
+		PTHREADS = true;
+		console.log('Building jsartoolkit5 with --pthreads option, artoolkit_wasm_mt.js will be built.');
+	};
 }
 
 var HAVE_NFT = 1;
@@ -38,6 +53,7 @@ if (!EMSCRIPTEN_ROOT) {
 var EMCC = EMSCRIPTEN_ROOT ? path.resolve(EMSCRIPTEN_ROOT, 'emcc') : 'emcc';
 var EMPP = EMSCRIPTEN_ROOT ? path.resolve(EMSCRIPTEN_ROOT, 'em++') : 'em++';
 var OPTIMIZE_FLAGS = ' -Oz '; // -Oz for smallest size
+var SIMD_OPTIMIZE_FLAGS = ' -O3 -msimd128 '; // -O3 for speed, auto-vectorized to WebAssembly SIMD
 var MEM = 256 * 1024 * 1024; // 64MB
 
 
@@ -46,12 +62,22 @@ var OUTPUT_PATH = path.resolve(__dirname, '../build/') + '/';
 
 var BUILD_DEBUG_FILE = 'artoolkit.debug.js';
 var BUILD_WASM_FILE = 'artoolkit_wasm.js';
+var BUILD_WASM_FLOAT_FILE = 'artoolkit_wasm_float.js';
+var BUILD_WASM_SIMD_FILE = 'artoolkit_wasm_simd.js';
+var BUILD_WASM_SQUARE_FILE = 'artoolkit_wasm_square.js';
+var BUILD_WASM_MT_FILE = 'artoolkit_wasm_mt.js';
+var BUILD_NFT_MODULE_FILE = 'artoolkit_nft.js';
 var BUILD_MIN_FILE = 'artoolkit.min.js';
 
 var MAIN_SOURCES = [
 	'ARToolKitJS.cpp',
 	'trackingMod.c',
 	'trackingMod2d.c',
+	'ARTrace.c',
+	'ARLabelingMT.c',
+	'ARThreshAdaptive.c',
+	'ARPattIndex.c',
+	'ARCornerTrack.c',
 ];
 
 if (!fs.existsSync(path.resolve(ARTOOLKIT5_ROOT, 'include/AR/config.h'))) {
@@ -153,6 +179,9 @@ var kpm_sources = [
 	return path.resolve(__dirname, ARTOOLKIT5_ROOT + '/lib/SRC/KPM/', src);
 });
 
+// The square marker build has no AR2 and KPM, its NFT functions are in the separately loaded NFT module.
+var ar_square_sources = ar_sources;
+
 if (HAVE_NFT) {
   ar_sources = ar_sources
   .concat(ar2_sources)
@@ -162,25 +191,40 @@ if (HAVE_NFT) {
 var DEFINES = ' ';
 if (HAVE_NFT) DEFINES += ' -D HAVE_NFT ';
 
+// The float build compiles ARToolKit itself with ARdouble as float, so it links against its own libar.
+var FLOAT_DEFINES = DEFINES + ' -D ARDOUBLE_IS_FLOAT ';
+
 var FLAGS = '' + OPTIMIZE_FLAGS;
 FLAGS += ' -Wno-warn-absolute-paths ';
 FLAGS += ' -s TOTAL_MEMORY=' + MEM + ' ';
 FLAGS += ' -s USE_ZLIB=1';
 FLAGS += ' -s USE_LIBJPEG';
 FLAGS += ' --memory-init-file 0 '; // for memless file
-FLAGS += ' -s ALLOW_MEMORY_GROWTH=1';
+FLAGS += ' -s ALLOW_MEMORY_GROWTH=' + (NO_MEMORY_GROWTH ? 0 : 1);
 
 var WASM_FLAGS = ' -s BINARYEN_TRAP_MODE=clamp'
 
 var PRE_FLAGS = ' --pre-js ' + path.resolve(__dirname, '../js/artoolkit.api.js') +' ';
 
+// The NFT module is a factory (ARToolKitNFT) instantiated by artoolkit.api.js, it shares the api of the square marker build.
+var NFT_MODULE_FLAGS = ' -D ARTOOLKIT_NFT_MODULE -s MODULARIZE=1 -s EXPORT_NAME="ARToolKitNFT" ';
+NFT_MODULE_FLAGS += ' -s FORCE_FILESYSTEM=1 -s EXTRA_EXPORTED_RUNTIME_METHODS=\'["FS"]\' ';
+
 FLAGS += ' --bind ';
 
+// SIMD needs the LLVM wasm backend (emsdk "upstream"), so it is only built with --simd. The backend always clamps
+// float to int conversions and has no BINARYEN_TRAP_MODE, the fastcomp flag of WASM_FLAGS.
+var SIMD_FLAGS = FLAGS.replace(OPTIMIZE_FLAGS, SIMD_OPTIMIZE_FLAGS);
+
+// The pthreads build runs the labeling strips of setLabelingThreadNum() in web workers. It needs SharedArrayBuffer,
+// so a cross-origin isolated page, and the LLVM wasm backend. libar is rebuilt with atomics to link with it.
+var PTHREAD_FLAGS = FLAGS + ' -pthread -s PTHREAD_POOL_SIZE=4 ';
+
 /* DEBUG FLAGS */
 var DEBUG_FLAGS = ' -g ';
 DEBUG_FLAGS += ' -s ASSERTIONS=1 '
 DEBUG_FLAGS += ' --profiling '
-DEBUG_FLAGS += ' -s ALLOW_MEMORY_GROWTH=1';
+DEBUG_FLAGS += ' -s ALLOW_MEMORY_GROWTH=' + (NO_MEMORY_GROWTH ? 0 : 1);
 DEBUG_FLAGS += '  -s DEMANGLE_SUPPORT=1 ';
 
 var INCLUDES = [
@@ -206,12 +250,9 @@ function clean_builds() {
 
     try {
         var files = fs.readdirSync(OUTPUT_PATH);
-				var filesLength = files.length;
-        if (filesLength > 0)
-				if (NO_LIBAR == true){
-					filesLength -= 1;
-				}
-            for (var i = 0; i < filesLength; i++) {
+            for (var i = 0; i < files.length; i++) {
+                // Keep libar.bc and libar_float.bc when they are not rebuilt.
+                if (NO_LIBAR == true && path.extname(files[i]) === '.bc') continue;
                 var filePath = OUTPUT_PATH + '/' + files[i];
                 if (fs.statSync(filePath).isFile())
                     fs.unlinkSync(filePath);
@@ -225,6 +266,26 @@ var compile_arlib = format(EMCC + ' ' + INCLUDES + ' '
     + FLAGS + ' ' + DEFINES + ' -o {OUTPUT_PATH}libar.bc ',
     OUTPUT_PATH);
 
+var compile_arlib_float = format(EMCC + ' ' + INCLUDES + ' '
+    + ar_sources.join(' ')
+    + FLAGS + ' ' + FLOAT_DEFINES + ' -o {OUTPUT_PATH}libar_float.bc ',
+    OUTPUT_PATH);
+
+var compile_arlib_simd = format(EMCC + ' ' + INCLUDES + ' '
+    + ar_sources.join(' ')
+    + SIMD_FLAGS + ' ' + DEFINES + ' -o {OUTPUT_PATH}libar_simd.bc ',
+    OUTPUT_PATH);
+
+var compile_arlib_mt = format(EMCC + ' ' + INCLUDES + ' '
+    + ar_sources.join(' ')
+    + PTHREAD_FLAGS + ' ' + DEFINES + ' -o {OUTPUT_PATH}libar_mt.bc ',
+    OUTPUT_PATH);
+
+var compile_arlib_square = format(EMCC + ' ' + INCLUDES + ' '
+    + ar_square_sources.join(' ')
+    + FLAGS + ' -o {OUTPUT_PATH}libar_square.bc ',
+    OUTPUT_PATH);
+
 var compile_kpm = format(EMCC + ' ' + INCLUDES + ' '
     + kpm_sources.join(' ')
     + FLAGS + ' ' + DEFINES + ' -o {OUTPUT_PATH}libkpm.bc ',
@@ -247,6 +308,33 @@ var compile_wasm = format(EMCC + ' ' + INCLUDES + ' '
     + FLAGS + WASM_FLAGS + DEFINES + PRE_FLAGS + ' -o {OUTPUT_PATH}{BUILD_FILE} ',
     OUTPUT_PATH, OUTPUT_PATH, BUILD_WASM_FILE);
 
+var compile_wasm_float = format(EMCC + ' ' + INCLUDES + ' '
+    + ' {OUTPUT_PATH}libar_float.bc ' + MAIN_SOURCES
+    + FLAGS + WASM_FLAGS + FLOAT_DEFINES + PRE_FLAGS + ' -o {OUTPUT_PATH}{BUILD_FILE} ',
+    OUTPUT_PATH, OUTPUT_PATH, BUILD_WASM_FLOAT_FILE);
+
+var compile_wasm_simd = format(EMCC + ' ' + INCLUDES + ' '
+    + ' {OUTPUT_PATH}libar_simd.bc ' + MAIN_SOURCES
+    + SIMD_FLAGS + DEFINES + PRE_FLAGS + ' -o {OUTPUT_PATH}{BUILD_FILE} ',
+    OUTPUT_PATH, OUTPUT_PATH, BUILD_WASM_SIMD_FILE);
+
+var compile_wasm_square = format(EMCC + ' ' + INCLUDES + ' '
+    + ' {OUTPUT_PATH}libar_square.bc ' + path.resolve(SOURCE_PATH, 'ARToolKitJS.cpp') + ' ' + path.resolve(SOURCE_PATH, 'ARTrace.c')
+    + ' ' + path.resolve(SOURCE_PATH, 'ARLabelingMT.c') + ' ' + path.resolve(SOURCE_PATH, 'ARThreshAdaptive.c')
+    + ' ' + path.resolve(SOURCE_PATH, 'ARPattIndex.c') + ' ' + path.resolve(SOURCE_PATH, 'ARCornerTrack.c')
+    + FLAGS + WASM_FLAGS + PRE_FLAGS + ' -o {OUTPUT_PATH}{BUILD_FILE} ',
+    OUTPUT_PATH, OUTPUT_PATH, BUILD_WASM_SQUARE_FILE);
+
+var compile_wasm_mt = format(EMCC + ' ' + INCLUDES + ' '
+    + ' {OUTPUT_PATH}libar_mt.bc ' + MAIN_SOURCES
+    + PTHREAD_FLAGS + DEFINES + PRE_FLAGS + ' -o {OUTPUT_PATH}{BUILD_FILE} ',
+    OUTPUT_PATH, OUTPUT_PATH, BUILD_WASM_MT_FILE);
+
+var compile_nft_module = format(EMCC + ' ' + INCLUDES + ' '
+    + ALL_BC + MAIN_SOURCES
+    + FLAGS + WASM_FLAGS + DEFINES + NFT_MODULE_FLAGS + ' -o {OUTPUT_PATH}{BUILD_FILE} ',
+    OUTPUT_PATH, OUTPUT_PATH, BUILD_NFT_MODULE_FILE);
+
 /*
  * Run commands
  */
@@ -286,13 +374,22 @@ function addJob(job) {
 }
 
 addJob(clean_builds);
-addJob(compile_arlib);
+if (NO_LIBAR == false) {
+  addJob(compile_arlib);
+  addJob(compile_arlib_float);
+  if (SIMD) addJob(compile_arlib_simd);
+  if (PTHREADS) addJob(compile_arlib_mt);
+  if (HAVE_NFT) addJob(compile_arlib_square);
+}
 addJob(compile_combine);
 addJob(compile_wasm);
 addJob(compile_combine_min);
-
-if (NO_LIBAR == true){
-  jobs.splice(1,1);
+addJob(compile_wasm_float);
+if (SIMD) addJob(compile_wasm_simd);
+if (PTHREADS) addJob(compile_wasm_mt);
+if (HAVE_NFT) {
+  addJob(compile_wasm_square);
+  addJob(compile_nft_module);
 }
 
 runJob();